@@ -0,0 +1,31 @@
+#include "DroneBackend.h"
+
+
+// DroneBackend class version 1.1
+
+
+// Wait until the drone has finished every command sent to it.
+// FlightPlanExecute waits here before a NOP instruction, before a snapshot is written and at the
+// end of the program. Backends whose commands complete in sendCommand() need not override this.
+
+void DroneBackend::waitForCommands()
+{}
+
+
+// Return whether NOP instructions must wait in real time for this backend's drone.
+// A backend whose drone follows the mission clock instead, such as the headless drone simulator,
+// returns false; NOP instructions then advance the mission clock without waiting, unless another
+// backend in use needs real time.
+
+bool DroneBackend::needsRealTime() const
+{
+	return true;
+}
+
+
+// Finish a program execution, such as by displaying what the drone did; called once every
+// command has completed.
+
+void DroneBackend::finishExecution()
+{}
+
@@ -0,0 +1,34 @@
+#ifndef DRONE_BACKEND_H
+#define DRONE_BACKEND_H
+
+
+#include "DroneCommand.h"
+
+
+// DroneBackend class version 1.1
+
+// The interface through which FlightPlanExecute controls a drone, real or simulated.
+// Each FPL drone command is compiled into a typed command when the program is parsed (see
+// DroneCommand.h), and the same DroneCommand is sent to every backend in use. Backends never wait
+// for their drone in sendCommand(): a backend that has to wait for a drone, such as a Tello, does
+// so on its own thread, so the drones of several backends execute each command at the same time
+// and waitForCommands() only waits as long as the slowest of them.
+// See SimulatorBackend.h and TelloBackend.h for the backends FlightPlanExecute creates itself;
+// other backends can be added with FlightPlanExecute::addDroneBackend().
+
+
+class DroneBackend
+{
+public:		// member functions intended to be used by clients of the class
+
+	virtual ~DroneBackend() {}	// destructor
+
+	virtual const char* name() const = 0;
+	virtual void        sendCommand(const DroneCommand& command) = 0;
+	virtual void        waitForCommands();
+	virtual bool        needsRealTime() const;
+	virtual void        finishExecution();
+};
+
+
+#endif // DRONE_BACKEND_H
@@ -0,0 +1,333 @@
+#include "DroneCommand.h"
+#include "IntVariableTable.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+
+// DroneCommand version 1.1
+
+
+using std::istringstream;
+using std::size_t;
+using std::string;
+using std::to_string;
+
+
+// The drone commands that can be compiled: the generic FPL drone commands followed by the Tello
+// SDK 2.0 commands, with the argument limits given in the Tello SDK 2.0 User Guide.
+
+static const DroneCommandSpec DRONE_COMMAND_SPECS[]
+{
+	{ "initialize",    DroneCommandKind::INITIALIZE, 0,    0,   0,  0,   0, nullptr },
+	{ "arm",           DroneCommandKind::ARM,        0,    0,   0,  0,   0, nullptr },
+	{ "takeoff",       DroneCommandKind::TAKEOFF,    0,    0,   0,  0,   0, nullptr },
+	{ "land",          DroneCommandKind::LAND,       0,    0,   0,  0,   0, nullptr },
+	{ "move",          DroneCommandKind::MOVE,       3, -500, 500,  0,   0, nullptr },
+	{ "speed",         DroneCommandKind::SPEED,      1,   10, 100,  0,   0, nullptr },
+	{ "emergency",     DroneCommandKind::OTHER,      0,    0,   0,  0,   0, nullptr },
+	{ "stop",          DroneCommandKind::OTHER,      0,    0,   0,  0,   0, nullptr },
+	{ "streamon",      DroneCommandKind::OTHER,      0,    0,   0,  0,   0, nullptr },
+	{ "streamoff",     DroneCommandKind::OTHER,      0,    0,   0,  0,   0, nullptr },
+	{ "up",            DroneCommandKind::OTHER,      1,   20, 500,  0,   0, nullptr },
+	{ "down",          DroneCommandKind::OTHER,      1,   20, 500,  0,   0, nullptr },
+	{ "left",          DroneCommandKind::OTHER,      1,   20, 500,  0,   0, nullptr },
+	{ "right",         DroneCommandKind::OTHER,      1,   20, 500,  0,   0, nullptr },
+	{ "forward",       DroneCommandKind::OTHER,      1,   20, 500,  0,   0, nullptr },
+	{ "back",          DroneCommandKind::OTHER,      1,   20, 500,  0,   0, nullptr },
+	{ "cw",            DroneCommandKind::OTHER,      1,    1, 360,  0,   0, nullptr },
+	{ "ccw",           DroneCommandKind::OTHER,      1,    1, 360,  0,   0, nullptr },
+	{ "flip",          DroneCommandKind::OTHER,      1,    0,   0,  0,   0, "lrfb"  },
+	{ "go",            DroneCommandKind::OTHER,      4, -500, 500, 10, 100, nullptr },
+	{ "curve",         DroneCommandKind::OTHER,      7, -500, 500, 10,  60, nullptr },
+	{ "rc",            DroneCommandKind::OTHER,      4, -100, 100,  0,   0, nullptr },
+	{ "speed?",        DroneCommandKind::OTHER,      0,    0,   0,  0,   0, nullptr },
+	{ "battery?",      DroneCommandKind::OTHER,      0,    0,   0,  0,   0, nullptr },
+	{ "time?",         DroneCommandKind::OTHER,      0,    0,   0,  0,   0, nullptr },
+	{ "height?",       DroneCommandKind::OTHER,      0,    0,   0,  0,   0, nullptr },
+	{ "temp?",         DroneCommandKind::OTHER,      0,    0,   0,  0,   0, nullptr },
+	{ "attitude?",     DroneCommandKind::OTHER,      0,    0,   0,  0,   0, nullptr },
+	{ "baro?",         DroneCommandKind::OTHER,      0,    0,   0,  0,   0, nullptr },
+	{ "acceleration?", DroneCommandKind::OTHER,      0,    0,   0,  0,   0, nullptr },
+	{ "tof?",          DroneCommandKind::OTHER,      0,    0,   0,  0,   0, nullptr },
+	{ "wifi?",         DroneCommandKind::OTHER,      0,    0,   0,  0,   0, nullptr },
+	{ "sdk?",          DroneCommandKind::OTHER,      0,    0,   0,  0,   0, nullptr },
+	{ "sn?",           DroneCommandKind::OTHER,      0,    0,   0,  0,   0, nullptr },
+};
+
+// Tello motion commands are rejected unless the target is at least this far along some axis (in cm).
+
+static const int MIN_OFFSET{ 20 };
+
+// The radius of a Tello curve command's arc must lie within these limits (in cm).
+
+static const double MIN_ARC_RADIUS{ 50.0 };
+static const double MAX_ARC_RADIUS{ 1000.0 };
+
+
+// Return the specification of the drone command with the given name, or null if there is none.
+
+static const DroneCommandSpec* findSpec(const string& name)
+{
+	for (const DroneCommandSpec& spec : DRONE_COMMAND_SPECS) {
+		if (name == spec.name) {
+			return &spec;
+		}
+	}
+
+	return nullptr;
+}
+
+
+// Return whether an offset is too short for the Tello, which requires x, y and z not all to be
+// between -20 and 20.
+
+static bool shortOffset(const int offset[])
+{
+	return (std::abs(offset[0]) < MIN_OFFSET) && (std::abs(offset[1]) < MIN_OFFSET) && (std::abs(offset[2]) < MIN_OFFSET);
+}
+
+
+// Return the radius of the arc from the drone's position through the first point of a curve command
+// to its second point, or 0 if the three points are on a line.
+
+static double arcRadius(const int first[], const int second[])
+{
+	const double ax{ static_cast<double>(first[0]) };
+	const double ay{ static_cast<double>(first[1]) };
+	const double az{ static_cast<double>(first[2]) };
+	const double bx{ static_cast<double>(second[0]) };
+	const double by{ static_cast<double>(second[1]) };
+	const double bz{ static_cast<double>(second[2]) };
+
+	const double cross_x{ ay * bz - az * by };
+	const double cross_y{ az * bx - ax * bz };
+	const double cross_z{ ax * by - ay * bx };
+	const double cross{ std::sqrt(cross_x * cross_x + cross_y * cross_y + cross_z * cross_z) };
+
+	if (cross == 0.0) {
+		return 0.0;
+	}
+
+	const double a{ std::sqrt(ax * ax + ay * ay + az * az) };
+	const double b{ std::sqrt(bx * bx + by * by + bz * bz) };
+	const double c{ std::sqrt((ax - bx) * (ax - bx) + (ay - by) * (ay - by) + (az - bz) * (az - bz)) };
+
+	return (a * b * c) / (2.0 * cross);
+}
+
+
+// Check one argument value of a drone command against its specification, describing the problem in
+// the error argument if it is invalid.
+
+static bool validArgument(const DroneCommandSpec& spec, int index, int value, string& error)
+{
+	if (spec.letters != nullptr) {
+		if ((value > 0) && (value < 128) && (std::strchr(spec.letters, value) != nullptr)) {
+			return true;
+		}
+		error = string("the argument of \"") + spec.name + "\" must be one of the letters " + spec.letters;
+		return false;
+	}
+
+	int min_value{ spec.min_value };
+	int max_value{ spec.max_value };
+
+	if ((spec.max_speed != 0) && (index == spec.num_arguments - 1)) {
+		min_value = spec.min_speed;
+		max_value = spec.max_speed;
+	}
+
+	if ((value >= min_value) && (value <= max_value)) {
+		return true;
+	}
+
+	error = "argument " + to_string(index + 1) + " of \"" + spec.name + "\" is " + to_string(value) +
+			" but must be between " + to_string(min_value) + " and " + to_string(max_value);
+	return false;
+}
+
+
+// Compile a drone command token, including its '<' and '>' delimiters, such as "<move %x %y 0>".
+// The command name must be one of the specified drone commands and be followed by the number of
+// arguments it takes. Each argument is an integer constant, a '%' followed by the name of a declared
+// integer variable, or for "flip" a direction letter. Constant arguments are checked against their
+// limits, and if every argument is constant the whole command is checked with validDroneCommand().
+// Returns whether the token is a valid drone command, describing the problem in the error argument
+// if it is not.
+
+bool compileDroneCommand(const string& token, const IntVariableTable& variables,
+						 CompiledDroneCommand& compiled, string& error)
+{
+	const size_t n{ token.length() };
+
+	if ((n < 2) || (token[0] != '<') || (token[n - 1] != '>')) {
+		error = "a drone command must be enclosed in '<' and '>'";
+		return false;
+	}
+
+	istringstream iss_command(token.substr(1, n - 2));
+	string        name;
+	iss_command >> name;
+
+	const DroneCommandSpec* spec{ findSpec(name) };
+
+	if (spec == nullptr) {
+		error = "\"" + name + "\" is not a drone command";
+		return false;
+	}
+
+	compiled      = CompiledDroneCommand();
+	compiled.spec = spec;
+
+	int    num_arguments{ 0 };
+	bool   all_constant{ true };
+	string argument;
+
+	while (iss_command >> argument) {
+		if (num_arguments == spec->num_arguments) {
+			num_arguments++;
+			break;
+		}
+
+		DroneArgument& compiled_argument{ compiled.arguments[num_arguments] };
+
+		if (argument[0] == '%') {
+			const int index{ variables.lookupVariable(argument.substr(1)) };
+			if (!variables.validIndex(index)) {
+				error = "\"" + argument.substr(1) + "\" is not a declared integer variable";
+				return false;
+			}
+			compiled_argument.constant = false;
+			compiled_argument.value    = index;
+			all_constant = false;
+		}
+		else {
+			if ((spec->letters != nullptr) && (argument.length() == 1)) {
+				compiled_argument.value = argument[0];
+			}
+			else {
+				char* end;
+				errno = 0;
+				const long value{ std::strtol(argument.c_str(), &end, 10) };
+				if ((*end != '\0') || (errno == ERANGE) || (value < -1000000) || (value > 1000000)) {
+					error = "argument " + to_string(num_arguments + 1) + " of \"" + name +
+							"\" is not an integer constant or %variable";
+					return false;
+				}
+				compiled_argument.value = static_cast<int>(value);
+			}
+			if (!validArgument(*spec, num_arguments, compiled_argument.value, error)) {
+				return false;
+			}
+		}
+
+		num_arguments++;
+	}
+
+	if (num_arguments != spec->num_arguments) {
+		error = "\"" + name + "\" takes " + to_string(spec->num_arguments) + " argument(s)";
+		return false;
+	}
+
+	if (all_constant) {
+		DroneCommand command;
+		command.kind = spec->kind;
+		command.spec = spec;
+		for (int i{ 0 }; i < num_arguments; i++) {
+			command.arguments[i] = compiled.arguments[i].value;
+		}
+		return validDroneCommand(command, error);
+	}
+
+	return true;
+}
+
+
+// Return whether a drone command whose argument values are known is one the Tello accepts,
+// describing the problem in the error argument if it is not.
+// Besides the limits of each argument, the target of a "move", "go" or "curve" command must not be
+// within 20 cm of the drone along every axis, and the arc of a "curve" command must have a radius
+// between 0.5 and 10 m.
+
+bool validDroneCommand(const DroneCommand& command, string& error)
+{
+	const DroneCommandSpec* spec{ command.spec };
+
+	if (spec == nullptr) {
+		error = "unknown drone command";
+		return false;
+	}
+
+	for (int i{ 0 }; i < spec->num_arguments; i++) {
+		if (!validArgument(*spec, i, command.arguments[i], error)) {
+			return false;
+		}
+	}
+
+	const bool other{ command.kind == DroneCommandKind::OTHER };
+	const bool go{ other && (std::strcmp(spec->name, "go") == 0) };
+	const bool curve{ other && (std::strcmp(spec->name, "curve") == 0) };
+
+	if ((command.kind == DroneCommandKind::MOVE) || go || curve) {
+		if (shortOffset(command.arguments) || (curve && shortOffset(command.arguments + 3))) {
+			error = string("x, y and z of \"") + spec->name + "\" must not all be between -20 and 20";
+			return false;
+		}
+	}
+
+	if (curve) {
+		const double radius{ arcRadius(command.arguments, command.arguments + 3) };
+		if ((radius < MIN_ARC_RADIUS) || (radius > MAX_ARC_RADIUS)) {
+			error = "the arc radius of \"curve\" must be between 50 and 1000 cm";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+// Return the text of a drone command without its '<' and '>' delimiters, such as "move 10 20 0".
+
+string formatDroneCommand(const DroneCommand& command)
+{
+	if (command.spec == nullptr) {
+		return string();
+	}
+
+	string text{ command.spec->name };
+
+	for (int i{ 0 }; i < command.spec->num_arguments; i++) {
+		text += ' ';
+		if (command.spec->letters != nullptr) {
+			text += static_cast<char>(command.arguments[i]);
+		}
+		else {
+			text += to_string(command.arguments[i]);
+		}
+	}
+
+	return text;
+}
+
+
+// Return a drone command of a kind that takes no arguments, such as DroneCommandKind::TAKEOFF.
+
+DroneCommand droneCommandOfKind(DroneCommandKind kind)
+{
+	DroneCommand command;
+
+	command.kind = kind;
+
+	for (const DroneCommandSpec& spec : DRONE_COMMAND_SPECS) {
+		if (spec.kind == kind) {
+			command.spec = &spec;
+			break;
+		}
+	}
+
+	return command;
+}
@@ -0,0 +1,95 @@
+#ifndef DRONE_COMMAND_H
+#define DRONE_COMMAND_H
+
+
+#include <string>
+
+
+// DroneCommand version 1.1
+
+// Drone commands are compiled when an FPL program is parsed: each drone command token, such as
+// "<move %x %y 0>", is checked against the specification of the command it names and stored as a
+// CompiledDroneCommand whose arguments are either integer constants or integer variable indexes.
+// Arguments are checked against the limits of the Tello SDK 2.0 User Guide, constants when the
+// command is compiled and variable values when it is executed, so that a command the Tello would
+// reject is found before takeoff whenever its arguments are constants.
+// Executing a CMD instruction only fills in the variable values, giving the DroneCommand that is
+// sent to every drone backend; no drone command text is parsed during execution.
+
+
+class IntVariableTable;
+
+
+// The most arguments a drone command has, those of the Tello "curve" command.
+
+const int MAX_DRONE_ARGUMENTS{ 7 };
+
+
+// The kinds of drone command that the drone backends distinguish. The generic FPL drone commands
+// have a kind of their own; other Tello SDK commands are of kind OTHER.
+
+enum class DroneCommandKind { INITIALIZE, ARM, TAKEOFF, LAND, MOVE, SPEED, OTHER };
+
+
+// The specification of one drone command: its name, kind and arguments.
+// Every argument lies between min_value and max_value, except that if max_speed is not 0 the last
+// argument is a speed between min_speed and max_speed (in cm/s), and if letters is not null the
+// only argument is one of its letters.
+
+struct DroneCommandSpec
+{
+	const char*      name;
+	DroneCommandKind kind;
+	int              num_arguments;
+	int              min_value;
+	int              max_value;
+	int              min_speed;
+	int              max_speed;
+	const char*      letters;
+};
+
+
+// One argument of a compiled drone command: an integer constant, or the index of the integer
+// variable whose value is used when the command is executed.
+
+struct DroneArgument
+{
+	bool constant{ true };
+	int  value{ 0 };
+};
+
+
+// A drone command token compiled when the FPL program is parsed.
+
+struct CompiledDroneCommand
+{
+	const DroneCommandSpec* spec{ nullptr };
+	DroneArgument           arguments[MAX_DRONE_ARGUMENTS];
+};
+
+
+// A drone command ready to be sent to the drone backends, with every argument value known.
+// A MOVE command's arguments are its x, y and z offsets in cm and a SPEED command's argument is
+// its speed in cm/s. A MOVE command may also carry the speed planned for it (see
+// FlightPlanExecute::setSpeedPolicy()). The command also records the location of the FPL
+// instruction that sent it and the mission time at which it was sent.
+
+struct DroneCommand
+{
+	DroneCommandKind        kind{ DroneCommandKind::OTHER };
+	const DroneCommandSpec* spec{ nullptr };
+	int                     arguments[MAX_DRONE_ARGUMENTS]{};
+	int                     speed{ 0 };			// planned speed of a MOVE in cm/s, or 0 for the drone's own speed
+	int                     instruction{ -1 };
+	long long               time_ms{ 0 };
+};
+
+
+bool         compileDroneCommand(const std::string& token, const IntVariableTable& variables,
+								 CompiledDroneCommand& compiled, std::string& error);
+bool         validDroneCommand(const DroneCommand& command, std::string& error);
+std::string  formatDroneCommand(const DroneCommand& command);
+DroneCommand droneCommandOfKind(DroneCommandKind kind);
+
+
+#endif // DRONE_COMMAND_H
@@ -13,19 +13,22 @@ using std::setw;
 using std::string;
 
 
-// The DroneCommandTable constructor dynamically allocates the fixed size array of drone commands.
+// The DroneCommandTable constructor dynamically allocates the fixed size arrays of drone commands
+// and compiled drone commands.
 
 DroneCommandTable::DroneCommandTable()
 {
-	drone_command_table = new string[MAX_DRONE_COMMANDS];
+	drone_command_table    = new string[MAX_DRONE_COMMANDS];
+	compiled_command_table = new CompiledDroneCommand[MAX_DRONE_COMMANDS];
 }
 
 
-// The DroneCommandTable destructor deallocates the drone command array.
+// The DroneCommandTable destructor deallocates the drone command arrays.
 
 DroneCommandTable::~DroneCommandTable()
 {
 	delete[] drone_command_table;
+	delete[] compiled_command_table;
 }
 
 
@@ -56,20 +59,21 @@ int DroneCommandTable::lookupCommand(const string& token) const
 }
 
 
-// Accepts a string consisting of a drone command (including the '<' and '>' delimiters)
-// and adds the command to the end of the drone command table if the command is not already
-// in the table.
+// Accepts a string consisting of a drone command (including the '<' and '>' delimiters), with the
+// command compiled from it, and adds the command to the end of the drone command table if the
+// command is not already in the table.
 // A message is generated and -1 is returned if the drone command table has no available entry.
 // Otherwise the index of the table entry for the drone command is returned.
 
-int DroneCommandTable::addCommand(const string& token)
+int DroneCommandTable::addCommand(const string& token, const CompiledDroneCommand& compiled)
 {
 	int index{ lookupCommand(token) };
 
 	if (index == -1) {
 		if (num_drone_commands < MAX_DRONE_COMMANDS) {
 			index = num_drone_commands;
-			drone_command_table[index] = token;
+			drone_command_table[index]    = token;
+			compiled_command_table[index] = compiled;
 			num_drone_commands++;
 		}
 		else {
@@ -93,6 +97,18 @@ string DroneCommandTable::getCommand(int index) const
 }
 
 
+// Returns the compiled drone command in the drone command table entry specified by the index
+// argument.
+// An assertion is triggered if the index argument is out of bounds.
+
+const CompiledDroneCommand& DroneCommandTable::getCompiledCommand(int index) const
+{
+	assert(validIndex(index));
+
+	return compiled_command_table[index];
+}
+
+
 // Returns whether the argument is a valid drone command table index.
 
 bool DroneCommandTable::validIndex(int index) const
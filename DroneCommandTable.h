@@ -2,12 +2,15 @@
 #define DRONE_COMMAND_TABLE_H
 
 
+#include "DroneCommand.h"
 #include <string>
 
 
 // Drone command tokens including the '<' and '>' delimiters are stored in a table in the order
 // they were parsed.
 // There is a single table entry for multiple occurrences of the same drone command token.
+// Each entry also holds the command compiled from the token when it was parsed (see DroneCommand.h),
+// which is what is executed.
 
 
 class DroneCommandTable
@@ -17,18 +20,21 @@ public:		// member functions intended to be used by clients of the class
 	DroneCommandTable();		// constructor
 	~DroneCommandTable();		// destructor
 
-	int         numCommands() const;
-	int         lookupCommand(const std::string& token) const;
-	int         addCommand(const std::string& token);
-	std::string getCommand(int index) const;
-	bool        validIndex(int index) const;
-	void        display() const;
+	int                         numCommands() const;
+	int                         lookupCommand(const std::string& token) const;
+	int                         addCommand(const std::string&          token,
+	                                       const CompiledDroneCommand& compiled);
+	std::string                 getCommand(int index) const;
+	const CompiledDroneCommand& getCompiledCommand(int index) const;
+	bool                        validIndex(int index) const;
+	void                        display() const;
 
 private:	// data members should always have private scope
 
-	std::string* drone_command_table{ nullptr };	// dynamically allocated array of drone commands
-	const int    MAX_DRONE_COMMANDS{ 5000 };		// maximum number of drone commands allowed
-	int          num_drone_commands{ 0 };			// current number of drone commands used
+	std::string*          drone_command_table{ nullptr };		// dynamically allocated array of drone commands
+	CompiledDroneCommand* compiled_command_table{ nullptr };	// compiled form of each drone command
+	const int             MAX_DRONE_COMMANDS{ 5000 };			// maximum number of drone commands allowed
+	int                   num_drone_commands{ 0 };				// current number of drone commands used
 };
 
 
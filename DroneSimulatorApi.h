@@ -2,11 +2,11 @@
 #define DRONE_SIMULATOR_API_H
 
 
-#include <mutex>
+#include <memory>
 #include <string>
 
 
-// Drone Simulator API class version 1.0
+// Drone Simulator API class version 1.8
 
 
 // A three-dimensional integer Cartesian coordinate system for the virtual drone.
@@ -27,30 +27,67 @@ struct Coordinate3D
 };
 
 
+// The kinds of drone command the simulator distinguishes.
+
+enum class SimulatorCommandType { MOVE, TAKEOFF, LAND, ARM, SPEED, RESET, OTHER };
+
+
+// A drone command already parsed by the sending thread, so the rendering thread never parses text.
+// The offset is only meaningful for MOVE commands. The value is the speed of a SPEED command, or
+// of a MOVE command if not 0 (in cm/s).
+// Each command records when it was sent, in milliseconds of scene time (or of mission time in the
+// headless scene), and the location of the FPL instruction that sent it, or -1 if unknown.
+// An instant command moves the drone to the end of its motion at once, such as when a replay
+// seeks, and RESET returns the drone to the ground at its starting position with an empty flight
+// path.
+
+struct SimulatorCommand
+{
+	SimulatorCommandType type{ SimulatorCommandType::OTHER };
+	Coordinate3D         offset;
+	int                  value{ 0 };
+	int                  instruction{ -1 };
+	long long            time_ms{ 0 };
+	bool                 instant{ false };
+};
+
+
+// Forward declarations to reduce the need for include files.
+
+class  SimulatorScene;
+struct SimulatorDrone;
+
+
 // A very basic class to control a virtual drone with commands issued by the main thread
 // and displayed in a window rendered with the SFML 2D graphics library. 
+// Every DroneSimulator in the process is displayed in the same window, unless it is created with
+// the headless scene for use without a display, see SimulatorScene.h.
+// The drone starts on the ground at the origin unless another starting position is given, so that
+// several simulated drones can take off side by side.
 
 class DroneSimulator
 {
 public:					// member functions intended to be used by clients of the class
 
-	DroneSimulator();	// constructor
+	explicit DroneSimulator(const Coordinate3D& start = Coordinate3D());							// constructor
+	explicit DroneSimulator(SimulatorScene& scene, const Coordinate3D& start = Coordinate3D());	// constructor
 
-	void sendCommand(const std::string& command);
+	void sendCommand(const std::string& command, int instruction_index = -1, long long mission_ms = -1);
+	void sendCommand(const SimulatorCommand& command);
+	void displayState() const;
+	void displayMotionReport() const;
+	void displaySeparationReport() const;
+	bool saveImage(const std::string& file_name) const;
 
-private:				// member functions not intended to be used by clients of the class
+	unsigned long long droppedCommands() const;
 
-	void renderingThread();
-	bool commandReceived(std::string& command, Coordinate3D& relative_3d_coord);
+	static SimulatorCommand parseCommand(const std::string& command);
 
 private:				// data members should always have private scope
-	
-	static const int   WINDOW_WIDTH{ 1200 };	// fixed width  of the drone simulator window in pixels
-	static const int   WINDOW_HEIGHT{ 900 };	// fixed height of the drone simulator window in pixels
 
-	static std::mutex  drone_command_mutex;		// ensures thread-safe access to drone_command
-	static std::string drone_command;			// commands sent by the main thread and received by the
-												// rendering thread
+	SimulatorScene&                 scene;	// the scene displaying this drone
+	std::shared_ptr<SimulatorDrone> drone;	// the part of this drone shared with the rendering thread
+	unsigned long long              dropped_commands{ 0 };	// commands dropped as the rendering thread fell behind
 };
 
 
@@ -0,0 +1,233 @@
+#include "FlightPath.h"
+#include <algorithm>
+#include <cmath>
+
+
+// Flight Path class version 1.4
+
+
+using std::make_unique;
+using std::max;
+using std::min;
+using std::size_t;
+using std::unique_ptr;
+using std::vector;
+
+
+// The FlightPath constructor records the window position of the origin and the path colours,
+// and adds the drone's starting position, the origin by default, as the first waypoint at every
+// level of detail.
+
+FlightPath::FlightPath(const sf::Vector2f& origin, const sf::Color& path_colour, const sf::Color& waypoint_colour,
+					   const Coordinate3D& start) :
+	origin(origin),
+	path_colour(path_colour),
+	waypoint_colour(waypoint_colour),
+	absolute_3d_coord(start),
+	current_position(origin.x + float(start.x), origin.y - float(start.y)),
+	min_position(current_position),
+	max_position(current_position)
+{
+	for (int n{ 0 }; n < NUM_LEVELS; n++) {
+		levels[n].tolerance = (n == 0) ? 0.0f : std::ldexp(1.0f, n);
+		levels[n].last_kept = current_position;
+		levels[n].new_waypoints.push_back(current_position);
+	}
+}
+
+
+// Add a waypoint at the given offset relative to the previous waypoint, keeping it at each level
+// of detail where it is far enough from the last waypoint kept.
+// The waypoint is uploaded to the graphics card the next time the path is drawn.
+
+void FlightPath::addMove(const Coordinate3D& offset)
+{
+	absolute_3d_coord.x += offset.x;
+	absolute_3d_coord.y += offset.y;
+	absolute_3d_coord.z += offset.z;
+
+	current_position = sf::Vector2f(origin.x + float(absolute_3d_coord.x), origin.y - float(absolute_3d_coord.y));
+
+	min_position.x = min(min_position.x, current_position.x);
+	min_position.y = min(min_position.y, current_position.y);
+	max_position.x = max(max_position.x, current_position.x);
+	max_position.y = max(max_position.y, current_position.y);
+
+	for (Level& level : levels) {
+		const float dx{ current_position.x - level.last_kept.x };
+		const float dy{ current_position.y - level.last_kept.y };
+		if ((dx * dx + dy * dy) >= (level.tolerance * level.tolerance)) {
+			level.new_waypoints.push_back(current_position);
+			level.last_kept = current_position;
+		}
+	}
+}
+
+
+// Return the absolute coordinates of the last waypoint.
+
+Coordinate3D FlightPath::position() const
+{
+	return absolute_3d_coord;
+}
+
+
+// Return the window rectangle bounding every waypoint.
+
+sf::FloatRect FlightPath::bounds() const
+{
+	return sf::FloatRect(min_position.x, min_position.y, max_position.x - min_position.x, max_position.y - min_position.y);
+}
+
+
+// Draw the waypoint markers and the line through the waypoints,
+// using the target's current view to choose the level of detail and the visible chunks.
+
+void FlightPath::draw(sf::RenderTarget& target, const sf::Texture& marker_texture)
+{
+	upload(levels[0], true);
+
+	for (int n{ 1 }; n < NUM_LEVELS; n++) {
+		upload(levels[n], false);
+	}
+
+	const sf::View&     view{ target.getView() };
+	const sf::Vector2f& view_size{ view.getSize() };
+	const float         units_per_pixel{ view_size.x / float(max(target.getSize().x, 1u)) };
+	const int           level_number{ min(NUM_LEVELS - 1, max(0, int(std::floor(std::log2(units_per_pixel))))) };
+	const Level&        level{ levels[level_number] };
+
+	const sf::FloatRect visible(view.getCenter().x - view_size.x / 2.0f, view.getCenter().y - view_size.y / 2.0f,
+								view_size.x, view_size.y);
+
+	const sf::RenderStates marker_states(&marker_texture);
+
+	if (level_number == 0) {
+		for (const unique_ptr<Chunk>& chunk : level.chunks) {
+			if (chunk->bounds.intersects(visible)) {
+				target.draw(chunk->markers, 0, 6 * chunk->num_waypoints, marker_states);
+			}
+		}
+	}
+
+	for (size_t i{ 0 }; i < level.chunks.size(); i++) {
+		if (level.chunks[i]->bounds.intersects(visible)) {
+			target.draw(level.chunks[i]->line, 0, level.chunks[i]->num_waypoints + (i > 0 ? 1 : 0));
+		}
+	}
+
+	// Join the last waypoint kept at this level to the drone's current position.
+	if ((level.last_kept.x != current_position.x) || (level.last_kept.y != current_position.y)) {
+		const sf::Vertex tail[]{ sf::Vertex(level.last_kept, path_colour), sf::Vertex(current_position, path_colour) };
+		target.draw(tail, 2, sf::Lines);
+	}
+}
+
+
+// Returns the white circle texture drawn at each waypoint, tinted by the waypoint colour.
+
+sf::Texture FlightPath::createMarkerTexture()
+{
+	sf::RenderTexture render_texture;
+	render_texture.create(MARKER_TEXTURE_SIZE, MARKER_TEXTURE_SIZE);
+	render_texture.setSmooth(true);
+	render_texture.clear(sf::Color::Transparent);
+
+	sf::CircleShape circle(MARKER_TEXTURE_SIZE / 2.0f);
+	circle.setFillColor(sf::Color::White);
+	render_texture.draw(circle);
+	render_texture.display();
+
+	return render_texture.getTexture();
+}
+
+
+// Copy the vertices of waypoints kept at a level of detail since the previous upload into the
+// level's vertex buffers, starting a new chunk whenever the last one is full.
+// Each chunk receives at most one update per buffer, and its bounds are extended by the marker
+// radius so that markers on the edge of the view are still drawn.
+
+void FlightPath::upload(Level& level, bool with_markers)
+{
+	vector<sf::Vertex> line_vertices;
+	vector<sf::Vertex> marker_vertices;
+
+	const float r{ float(MARKER_RADIUS) };
+
+	size_t next{ 0 };
+
+	while (next < level.new_waypoints.size()) {
+		if (level.chunks.empty() || (level.chunks.back()->num_waypoints == CHUNK_WAYPOINTS)) {
+			unique_ptr<Chunk> chunk{ make_unique<Chunk>() };
+			chunk->line.create(CHUNK_WAYPOINTS + 1);
+			if (with_markers) {
+				chunk->markers.create(6 * CHUNK_WAYPOINTS);
+			}
+			const sf::Vector2f start{ level.chunks.empty() ? level.new_waypoints[0] : level.last_uploaded };
+			chunk->bounds = sf::FloatRect(start.x - r, start.y - r, 2.0f * r, 2.0f * r);
+			if (!level.chunks.empty()) {
+				const sf::Vertex joining_vertex(level.last_uploaded, path_colour);
+				chunk->line.update(&joining_vertex, 1, 0);
+			}
+			level.chunks.push_back(std::move(chunk));
+		}
+
+		Chunk&       chunk{ *level.chunks.back() };
+		const size_t first_line_vertex{ chunk.num_waypoints + (level.chunks.size() > 1 ? 1 : 0) };
+		const size_t n{ min(CHUNK_WAYPOINTS - chunk.num_waypoints, level.new_waypoints.size() - next) };
+
+		float left{ chunk.bounds.left };
+		float top{ chunk.bounds.top };
+		float right{ chunk.bounds.left + chunk.bounds.width };
+		float bottom{ chunk.bounds.top + chunk.bounds.height };
+
+		line_vertices.clear();
+		marker_vertices.clear();
+
+		for (size_t i{ next }; i < next + n; i++) {
+			const sf::Vector2f& point{ level.new_waypoints[i] };
+			line_vertices.push_back(sf::Vertex(point, path_colour));
+			if (with_markers) {
+				appendMarker(marker_vertices, point, waypoint_colour);
+			}
+			left   = min(left, point.x - r);
+			top    = min(top, point.y - r);
+			right  = max(right, point.x + r);
+			bottom = max(bottom, point.y + r);
+		}
+
+		chunk.line.update(line_vertices.data(), n, unsigned(first_line_vertex));
+		if (with_markers) {
+			chunk.markers.update(marker_vertices.data(), 6 * n, unsigned(6 * chunk.num_waypoints));
+		}
+
+		chunk.bounds         = sf::FloatRect(left, top, right - left, bottom - top);
+		chunk.num_waypoints += n;
+		next                += n;
+		level.last_uploaded  = level.new_waypoints[next - 1];
+	}
+
+	level.new_waypoints.clear();
+}
+
+
+// Append the two triangles of a marker quad centred on a point, to be drawn with the marker texture.
+
+void FlightPath::appendMarker(vector<sf::Vertex>& vertices, const sf::Vector2f& point, const sf::Color& colour)
+{
+	const float r{ float(MARKER_RADIUS) };
+	const float w{ float(MARKER_TEXTURE_SIZE) };
+	const float h{ float(MARKER_TEXTURE_SIZE) };
+
+	const sf::Vertex top_left(sf::Vector2f(point.x - r, point.y - r), colour, sf::Vector2f(0.0f, 0.0f));
+	const sf::Vertex top_right(sf::Vector2f(point.x + r, point.y - r), colour, sf::Vector2f(w, 0.0f));
+	const sf::Vertex bottom_right(sf::Vector2f(point.x + r, point.y + r), colour, sf::Vector2f(w, h));
+	const sf::Vertex bottom_left(sf::Vector2f(point.x - r, point.y + r), colour, sf::Vector2f(0.0f, h));
+
+	vertices.push_back(top_left);
+	vertices.push_back(top_right);
+	vertices.push_back(bottom_right);
+	vertices.push_back(top_left);
+	vertices.push_back(bottom_right);
+	vertices.push_back(bottom_left);
+}
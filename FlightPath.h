@@ -0,0 +1,90 @@
+#ifndef FLIGHT_PATH_H
+#define FLIGHT_PATH_H
+
+
+#include "DroneSimulatorApi.h"
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+// Flight Path class version 1.4
+
+// The retained graphics of one simulated drone's flight path: a line through every waypoint and
+// a small circular marker at each waypoint. The drone itself is drawn by SimulatorScene.
+// Absolute waypoint positions are accumulated as move commands arrive, and only the vertices of
+// new waypoints are uploaded to the graphics card. The vertices are kept in fixed-size chunks of
+// vertex buffers, and every waypoint marker is a textured quad in its chunk's marker batch.
+//
+// To keep very long paths interactive the line is also kept at NUM_LEVELS - 1 coarser levels of
+// detail. Level n keeps a waypoint only if it is at least 2^n units from the last waypoint kept
+// at that level, so the simplified line never strays more than 2^n units from the full path.
+// Each frame draws the coarsest level whose tolerance is below one pixel at the current zoom,
+// and only the chunks whose bounding rectangles overlap the view. Waypoint markers are only
+// drawn at full detail.
+// FlightPath objects may only be used by the thread that draws them.
+
+
+class FlightPath
+{
+public:		// member functions intended to be used by clients of the class
+
+	FlightPath(const sf::Vector2f& origin, const sf::Color& path_colour, const sf::Color& waypoint_colour,
+			   const Coordinate3D& start = Coordinate3D());	// constructor
+
+	void          addMove(const Coordinate3D& offset);
+	Coordinate3D  position() const;
+	sf::FloatRect bounds() const;
+	void          draw(sf::RenderTarget& target, const sf::Texture& marker_texture);
+
+	static sf::Texture createMarkerTexture();
+	static void        appendMarker(std::vector<sf::Vertex>& vertices, const sf::Vector2f& point, const sf::Color& colour);
+
+private:	// member functions not intended to be used by clients of the class
+
+	// The vertex buffers holding up to CHUNK_WAYPOINTS waypoints of one level of detail, and the
+	// rectangle bounding them.
+	// Each chunk's line starts at the last waypoint of the previous chunk, so the line is unbroken.
+
+	struct Chunk
+	{
+		sf::VertexBuffer line{ sf::LineStrip, sf::VertexBuffer::Static };	// line through the waypoints
+		sf::VertexBuffer markers{ sf::Triangles, sf::VertexBuffer::Static };// two triangles per waypoint
+		std::size_t      num_waypoints{ 0 };								// waypoints uploaded so far
+		sf::FloatRect    bounds;											// bounds of the line vertices
+	};
+
+	// One level of detail of the flight path.
+
+	struct Level
+	{
+		float                               tolerance{ 0.0f };	// minimum distance between kept waypoints
+		std::vector<std::unique_ptr<Chunk>> chunks;				// uploaded waypoints
+		std::vector<sf::Vector2f>           new_waypoints;		// waypoints kept but not yet uploaded
+		sf::Vector2f                        last_kept;			// the most recently kept waypoint
+		sf::Vector2f                        last_uploaded;		// the most recently uploaded waypoint
+	};
+
+	void upload(Level& level, bool with_markers);
+
+private:	// data members should always have private scope
+
+	static const std::size_t CHUNK_WAYPOINTS{ 4096 };	// waypoints per chunk
+	static const int         NUM_LEVELS{ 16 };			// levels of detail, including the full path
+	static const int         MARKER_RADIUS{ 3 };		// waypoint marker radius in pixels
+	static const unsigned    MARKER_TEXTURE_SIZE{ 32 };	// width and height of the marker texture in pixels
+
+	sf::Vector2f origin;								// window position of coordinate (0, 0)
+	sf::Color    path_colour;							// colour of the line through the waypoints
+	sf::Color    waypoint_colour;						// colour of the waypoint markers
+	Coordinate3D absolute_3d_coord;						// absolute coordinates of the last waypoint
+	sf::Vector2f current_position;						// window position of the last waypoint
+	sf::Vector2f min_position;							// smallest window coordinates of any waypoint
+	sf::Vector2f max_position;							// largest window coordinates of any waypoint
+
+	Level levels[NUM_LEVELS];							// level 0 is the full path
+};
+
+
+#endif // FLIGHT_PATH_H
@@ -0,0 +1,331 @@
+#include "FlightPlanExecute.h"
+#include "DroneBackend.h"
+#include "SimulatorBackend.h"
+#include "TelloBackend.h"
+#include "TrajectoryRecorder.h"
+#include <iostream>
+
+
+// FlightPlanExecute class version 1.2
+
+// This subset of the FlightPlanExecute member functions concentrates on sending commands to the
+// drones, through the DroneBackend objects selected for each program execution.
+
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::chrono::steady_clock;
+
+
+// Send a drone command, whose variable values have already been filled in, to every drone backend
+// in use, recording it in the trajectory file if one is being recorded.
+// When motion coalescing is enabled a move command is held back, so that following collinear moves
+// can be merged into it, until a command that cannot be merged is sent or execution waits for the
+// drones.
+
+void FlightPlanExecute::sendDroneCommand(DroneCommand command)
+{
+	command.instruction = program_counter;
+	command.time_ms     = missionMilliseconds();
+
+	if (motion_coalescing) {
+		if (coalesceMove(command)) {
+			return;
+		}
+		flushPendingMove();
+		if (command.kind == DroneCommandKind::MOVE) {
+			pending_move = command;
+			move_pending = true;
+			return;
+		}
+	}
+
+	dispatchDroneCommand(command);
+}
+
+
+// Send a drone command to the drone backends, unless a speed policy other than SpeedPolicy::FIXED
+// is in use: the command is then held back until the next NOP deadline is known, when the speed of
+// each move is planned (see planSpeeds()).
+
+void FlightPlanExecute::dispatchDroneCommand(const DroneCommand& command)
+{
+	if (speed_policy != SpeedPolicy::FIXED) {
+		planned_commands.push_back(command);
+	}
+	else {
+		sendToBackends(command);
+	}
+}
+
+
+// Record a drone command in the trajectory file and fan it out to every drone backend in use: no
+// backend waits for its drone here, so the drones of all the backends carry out the command at the
+// same time.
+// When profiling is enabled the time spent by each backend is accumulated separately.
+
+void FlightPlanExecute::sendToBackends(const DroneCommand& command)
+{
+	if (trajectory_recorder != nullptr) {
+		recordDroneCommand(command);
+	}
+
+	for (size_t i{ 0 }; i < drone_backends.size(); i++) {
+		if (profiling) {
+			const steady_clock::time_point start{ steady_clock::now() };
+			drone_backends[i]->sendCommand(command);
+			backend_profiles[i].time += steady_clock::now() - start;
+			backend_profiles[i].commands++;
+		}
+		else {
+			drone_backends[i]->sendCommand(command);
+		}
+	}
+}
+
+
+// Merge a move command into the pending move if both point the same way, so the drone flies the
+// combined distance in a single command, and one command round trip and one stop are saved.
+// Moves are only merged while the combined move stays within the Tello's distance limits.
+// Returns whether the command was merged.
+
+bool FlightPlanExecute::coalesceMove(const DroneCommand& command)
+{
+	if (!move_pending || (command.kind != DroneCommandKind::MOVE)) {
+		return false;
+	}
+
+	const int* a{ pending_move.arguments };
+	const int* b{ command.arguments };
+
+	// The moves are collinear and point the same way when their cross product is zero and their
+	// dot product is positive.
+
+	const long long cross_x{ static_cast<long long>(a[1]) * b[2] - static_cast<long long>(a[2]) * b[1] };
+	const long long cross_y{ static_cast<long long>(a[2]) * b[0] - static_cast<long long>(a[0]) * b[2] };
+	const long long cross_z{ static_cast<long long>(a[0]) * b[1] - static_cast<long long>(a[1]) * b[0] };
+	const long long dot{ static_cast<long long>(a[0]) * b[0] + static_cast<long long>(a[1]) * b[1] +
+						 static_cast<long long>(a[2]) * b[2] };
+
+	if ((cross_x != 0) || (cross_y != 0) || (cross_z != 0) || (dot <= 0)) {
+		return false;
+	}
+
+	DroneCommand merged{ pending_move };
+
+	for (int i{ 0 }; i < 3; i++) {
+		merged.arguments[i] += b[i];
+	}
+
+	string error;
+
+	if (!validDroneCommand(merged, error)) {
+		return false;
+	}
+
+	pending_move = merged;
+	coalesced_moves++;
+
+	return true;
+}
+
+
+// Send the move command held back for motion coalescing, if there is one.
+
+void FlightPlanExecute::flushPendingMove()
+{
+	if (move_pending) {
+		move_pending = false;
+		dispatchDroneCommand(pending_move);
+	}
+}
+
+
+// Wait until every drone has finished the commands sent to it. As the drones carry out the commands
+// at the same time, this waits as long as the slowest drone rather than for each drone in turn.
+// Execution waits here before a NOP instruction, before a snapshot is written and at the end of the
+// program.
+// Any move held back for motion coalescing is sent first, so moves are never merged across a NOP
+// instruction's deadline, followed by any commands held back for speed planning. Before a NOP
+// instruction the deadline argument is the mission time (in ms) the NOP waits until, which the
+// speeds are planned to meet; otherwise it is -1. The trajectory file, if one is being recorded, is
+// then brought up to date.
+// When profiling is enabled the time spent waiting is included in each backend's command time.
+
+void FlightPlanExecute::waitForDrones(long long deadline_ms)
+{
+	flushPendingMove();
+
+	if (!planned_commands.empty()) {
+		planSpeeds(deadline_ms);
+	}
+
+	if (trajectory_recorder != nullptr) {
+		trajectory_recorder->flush();
+	}
+
+	for (size_t i{ 0 }; i < drone_backends.size(); i++) {
+		if (profiling) {
+			const steady_clock::time_point start{ steady_clock::now() };
+			drone_backends[i]->waitForCommands();
+			backend_profiles[i].time += steady_clock::now() - start;
+		}
+		else {
+			drone_backends[i]->waitForCommands();
+		}
+	}
+}
+
+
+// Return whether NOP instructions must wait in real time. They need not when every backend in use
+// follows the mission clock, such as the headless drone simulator, or when no drone is controlled
+// while a trajectory file is recorded.
+
+bool FlightPlanExecute::dronesNeedRealTime() const
+{
+	if (drone_backends.empty()) {
+		return trajectory_recorder == nullptr;
+	}
+
+	for (const DroneBackend* backend : drone_backends) {
+		if (backend->needsRealTime()) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+// Select the drone backends used by a program execution from the drone mode, creating the
+// simulator and Tello backends the first time they are needed, followed by any backends added
+// with addDroneBackend().
+
+void FlightPlanExecute::selectDroneBackends()
+{
+	drone_backends.clear();
+
+	if ((drone_mode == DroneMode::SIMULATOR) || (drone_mode == DroneMode::BOTH)) {
+		if (simulator_backend == nullptr) {
+			simulator_backend = new SimulatorBackend();
+		}
+		Coordinate3D start;
+		start.x = simulator_start_x;
+		start.y = simulator_start_y;
+		simulator_backend->setStartPosition(start);
+		drone_backends.push_back(simulator_backend);
+	}
+
+	if ((drone_mode == DroneMode::TELLO) || (drone_mode == DroneMode::BOTH)) {
+		if (tello_backend == nullptr) {
+			tello_backend = new TelloBackend();
+		}
+		drone_backends.push_back(tello_backend);
+	}
+
+	drone_backends.insert(drone_backends.end(), added_backends.begin(), added_backends.end());
+
+	backend_profiles.assign(drone_backends.size(), BackendProfile());
+
+	move_pending    = false;
+	coalesced_moves = 0;
+
+	planned_commands.clear();
+	planned_moves       = 0;
+	planned_speed_total = 0;
+	missed_deadlines    = 0;
+}
+
+
+// Report the outcome of a program execution for every drone backend used, such as the Tello's
+// response times or the simulated drone's motion report, the command round trips saved by motion
+// coalescing and the speeds planned for the moves.
+
+void FlightPlanExecute::finishDrones()
+{
+	for (DroneBackend* backend : drone_backends) {
+		backend->finishExecution();
+	}
+
+	if (motion_coalescing && (coalesced_moves > 0)) {
+		cout << endl << "Motion coalescing merged " << coalesced_moves
+			 << " move commands into the preceding collinear move, saving " << coalesced_moves
+			 << " command round trips per drone" << endl;
+	}
+
+	if (speed_policy != SpeedPolicy::FIXED) {
+		displaySpeedReport();
+	}
+}
+
+
+// Use the headless drone simulator, which needs no display, for subsequent program executions.
+// At the end of each execution the simulated drone's state is displayed, and if an image file name
+// is given (such as "mission.png") the flight paths of every headless simulated drone are saved in it.
+// NOP instructions do not wait when the headless drone simulator is the only drone controlled.
+// Must be called before an "<initialize>" drone command is executed.
+
+void FlightPlanExecute::useHeadlessSimulator(const string& image_file_name)
+{
+	delete simulator_backend;
+	simulator_backend = new SimulatorBackend(SimulatorOutput::HEADLESS, image_file_name);
+}
+
+
+// Send simulator commands to a separate fpl-viewer process for subsequent program executions,
+// instead of displaying them in this process. The commands pass through shared memory with the
+// given name, or a name unique to this process if none is given, which the viewer is started with.
+// Sending a command never waits for the viewer; commands are dropped if the viewer falls more than
+// thousands of commands behind, or is not running.
+// Must be called before an "<initialize>" drone command is executed.
+
+void FlightPlanExecute::useSimulatorViewer(const string& link_name)
+{
+	delete simulator_backend;
+	simulator_backend = new SimulatorBackend(SimulatorOutput::VIEWER, link_name);
+}
+
+
+// Start the simulated drone of subsequent program executions on the ground at (x, y) instead of
+// the origin, so that the drones of several programs simulated together take off side by side
+// rather than on top of each other.
+// Must be called before an "<initialize>" drone command is executed.
+
+void FlightPlanExecute::setSimulatorStart(int x, int y)
+{
+	simulator_start_x = x;
+	simulator_start_y = y;
+}
+
+
+// Send the Tello commands of subsequent program executions to one drone of a started swarm instead
+// of creating a Tello object, so that many programs, each executed on its own thread, can control
+// the drones of one swarm through its single event loop. The swarm must outlive the executions.
+
+void FlightPlanExecute::useTelloSwarm(TelloSwarm& swarm, int drone)
+{
+	delete tello_backend;
+	tello_backend = new TelloBackend(swarm, drone);
+}
+
+
+// Also send the drone commands of subsequent program executions to another backend, such as one
+// recording the commands or controlling another kind of drone, whatever the drone mode.
+// The backend is not deallocated by FlightPlanExecute and must outlive the executions.
+
+void FlightPlanExecute::addDroneBackend(DroneBackend& backend)
+{
+	added_backends.push_back(&backend);
+}
+
+
+// Select whether subsequent program executions merge consecutive move commands that point the same
+// way into a single move, within the Tello's distance limits, to save command round trips and the
+// drone's stop between the moves. The drones fly the same path and pass the same NOP deadlines:
+// moves are never merged across a NOP instruction, a snapshot or any other drone command.
+
+void FlightPlanExecute::enableMotionCoalescing(bool enable)
+{
+	motion_coalescing = enable;
+}
@@ -1,15 +1,18 @@
 #include "FlightPlanExecute.h"
 #include "IntVariableTable.h"
 #include "LabelTable.h"
+#include "DroneCommand.h"
 #include "DroneCommandTable.h"
 #include "InstructionTable.h"
-#include "DroneSimulatorApi.h"
-#include "TelloApi.h"
+#include "SimulatorBackend.h"
+#include "TelloBackend.h"
+#include "TraceLogger.h"
+#include "TraceRecorder.h"
+#include "TrajectoryRecorder.h"
 #include <iostream>
 #include <iomanip>
 #include <cassert>
-#include <ctime>
-#include <windows.h>
+#include <thread>
 
 
 // FlightPlanExecute class version 1.2
@@ -20,8 +23,9 @@
 
 using std::cout;
 using std::endl;
-using std::right;
-using std::setw;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
 using std::size_t;
 using std::string;
 using std::to_string;
@@ -41,17 +45,20 @@ FlightPlanExecute::FlightPlanExecute(IntVariableTable&        variables,
 {}
 
 
-// The FlightPlanExecute destructor deallocates the Simulator or Tello object if one of these was created.
+// The FlightPlanExecute destructor deallocates the simulator and Tello backends if they were created,
+// as well as the integer variable value and instruction profile arrays, the trace logger and the
+// trace and trajectory recorders.
 
 FlightPlanExecute::~FlightPlanExecute()
 {
-	if (drone_simulator != nullptr) {
-		delete drone_simulator;
-	}
-
-	if (tello_drone != nullptr) {
-		delete tello_drone;
-	}
+	delete[] variable_values;
+	delete[] instruction_profiles;
+	delete trace_logger;
+	delete trace_recorder;
+	delete trajectory_recorder;
+
+	delete simulator_backend;
+	delete tello_backend;
 }
 
 
@@ -60,12 +67,25 @@ FlightPlanExecute::~FlightPlanExecute()
 // Execution continues until either an "end" instruction is executed, or an invalid opcode or operand
 // is encountered.
 // A message is generated if the program cannot be executed because the instruction table is empty.
+// The integer variable values are copied into the variable_values array before execution starts
+// and copied back into the integer variable table after execution ends.
+// If restore() was called beforehand, execution resumes from the restored program counter,
+// variable values and mission clock instead of starting again from index 0.
+// When profiling is enabled a separate execution loop gathers the profile, so execution without
+// profiling is unaffected.
+// Traced instructions are recorded by a TraceLogger, which writes the trace on a background thread.
+// Recording a binary execution trace also uses a separate execution loop.
+// Drone commands are recorded in a trajectory file as they are sent, if one was requested.
+// Drone commands are sent to the drone backends selected by the drone mode, and to any added with
+// addDroneBackend(). Execution ends only once every drone has finished the commands sent to it.
 
 void FlightPlanExecute::executeProgram(DroneMode drone, TraceMode trace)
 {
 	drone_mode = drone;
 	trace_mode = trace;
 
+	selectDroneBackends();
+
 	if (instruction_table.numInstructions() == 0) {
 		cout << endl << "Program execution cannot proceed because the instruction table is empty" << endl;
 	}
@@ -76,26 +96,76 @@ void FlightPlanExecute::executeProgram(DroneMode drone, TraceMode trace)
 		else if (trace_mode == TraceMode::CMD_NOP_OPCODES) {
 			cout << endl << "Program execution: [CMD and NOP operations]" << endl << endl;
 		}
-		timer_start           = clock();
-		program_counter       = 0;
-		compare_returns_equal = false;
-		end_program           = false;
-		while (!end_program) {
-			executeNextInstruction();
+		if (trace_mode != TraceMode::OFF) {
+			trace_logger = new TraceLogger(int_variable_table, label_table, drone_command_table,
+										   trace_mode, trace_overflow);
+		}
+		end_program = false;
+		if (resume_pending) {
+			mission_start  = steady_clock::now() - milliseconds(restored_clock_ms);
+			resume_pending = false;
+			resumeDroneState();
+		}
+		else {
+			mission_start         = steady_clock::now();
+			program_counter       = 0;
+			compare_returns_equal = false;
+			drone_initialized     = false;
+			drone_armed           = false;
+			drone_airborne        = false;
+			loadVariables();
+		}
+		if (profiling) {
+			resetProfile();
+		}
+		if (!trace_file_name.empty()) {
+			startTraceRecording();
+		}
+		if (!trajectory_file_name.empty()) {
+			startTrajectoryRecording();
+		}
+		if (trace_recorder != nullptr) {
+			while (!end_program) {
+				executeRecordedInstruction();
+			}
+			delete trace_recorder;
+			trace_recorder = nullptr;
+		}
+		else if (profiling) {
+			while (!end_program) {
+				executeProfiledInstruction();
+			}
+		}
+		else {
+			while (!end_program) {
+				executeNextInstruction();
+			}
 		}
+		waitForDrones();
+		storeVariables();
+		delete trace_logger;
+		trace_logger = nullptr;
+		delete trajectory_recorder;
+		trajectory_recorder = nullptr;
+		finishDrones();
 	}
 }
 
 
+// Select what happens when instructions are traced faster than the trace can be written to the
+// console: either execution waits for the trace to catch up, or the excess trace lines are dropped.
+
+void FlightPlanExecute::setTraceOverflow(TraceOverflow overflow)
+{
+	trace_overflow = overflow;
+}
+
+
 // Execute the instruction appearing at instruction_table[program_counter],
 // and update the program_counter.
 
 void FlightPlanExecute::executeNextInstruction()
 {
-	if (trace_mode == TraceMode::ALL_OPCODES) {
-		cout << right << setw(8) << program_counter << "    ";
-	}
-
 	InstructionEntry instruction = instruction_table.getInstruction(program_counter);
 
 	switch (instruction.opcode) {
@@ -139,8 +209,8 @@ void FlightPlanExecute::executeNextInstruction()
 		executeEndInstruction(instruction);
 		break;
 	default:
-		cout << "Undefined instruction opcode (" << opcodeToString(instruction.opcode)
-			 << ") at location " << program_counter << " - program terminated" << endl;
+		reportError("Undefined instruction opcode (" + opcodeToString(instruction.opcode)
+					+ ") at location " + to_string(program_counter) + " - program terminated");
 		end_program = true;
 		break;
 	}
@@ -154,10 +224,10 @@ void FlightPlanExecute::executeIntInstruction(const InstructionEntry& instructio
 	assert(instruction.opcode == Opcodes::INT);
 
 	if (trace_mode == TraceMode::ALL_OPCODES) {
-		cout << int_variable_table.getName(instruction.operand1) << " = " << instruction.operand2 << endl;
+		traceInstruction(instruction, 0, instruction.operand2, instruction.operand2, false);
 	}
 
-	int_variable_table.setValue(instruction.operand1, instruction.operand2);
+	variable_values[instruction.operand1] = instruction.operand2;
 
 	program_counter++;
 }
@@ -174,11 +244,10 @@ void FlightPlanExecute::executeAddInstruction(const InstructionEntry& instructio
 	int new_value{ operand1 + operand2 };
 
 	if (trace_mode == TraceMode::ALL_OPCODES) {
-		cout << int_variable_table.getName(instruction.operand1) << " = " << operand1 << " + "
-		 	 << operand2 << " = " << new_value << endl;
+		traceInstruction(instruction, operand1, operand2, new_value, false);
 	}
 
-	int_variable_table.setValue(instruction.operand1, new_value);
+	variable_values[instruction.operand1] = new_value;
 
 	program_counter++;
 }
@@ -195,11 +264,10 @@ void FlightPlanExecute::executeSubInstruction(const InstructionEntry& instructio
 	int new_value{ operand1 - operand2 };
 
 	if (trace_mode == TraceMode::ALL_OPCODES) {
-		cout << int_variable_table.getName(instruction.operand1) << " = " << operand1 << " - "
-			 << operand2 << " = " << new_value << endl;
+		traceInstruction(instruction, operand1, operand2, new_value, false);
 	}
 
-	int_variable_table.setValue(instruction.operand1, new_value);
+	variable_values[instruction.operand1] = new_value;
 
 	program_counter++;
 }
@@ -216,11 +284,10 @@ void FlightPlanExecute::executeMulInstruction(const InstructionEntry& instructio
 	int new_value{ operand1 * operand2 };
 
 	if (trace_mode == TraceMode::ALL_OPCODES) {
-		cout << int_variable_table.getName(instruction.operand1) << " = " << operand1 << " * "
-			 << operand2 << " = " << new_value << endl;
+		traceInstruction(instruction, operand1, operand2, new_value, false);
 	}
 
-	int_variable_table.setValue(instruction.operand1, new_value);
+	variable_values[instruction.operand1] = new_value;
 
 	program_counter++;
 }
@@ -237,17 +304,16 @@ void FlightPlanExecute::executeDivInstruction(const InstructionEntry& instructio
 	int operand2{ getOperand2(instruction) };
 
 	if (operand2 == 0) {
-		cout << "Attempted division by zero at location " << program_counter
-			<< " - program terminated" << endl;
+		reportError("Attempted division by zero at location " + to_string(program_counter)
+					+ " - program terminated");
 		end_program = true;
 	}
 	else {
 		int new_value{ operand1 / operand2 };
 		if (trace_mode == TraceMode::ALL_OPCODES) {
-			cout << int_variable_table.getName(instruction.operand1) << " = " << operand1 << " / "
-				 << operand2 << " = " << new_value << endl;
+			traceInstruction(instruction, operand1, operand2, new_value, false);
 		}
-		int_variable_table.setValue(instruction.operand1, new_value);
+		variable_values[instruction.operand1] = new_value;
 		program_counter++;
 	}
 }
@@ -262,10 +328,10 @@ void FlightPlanExecute::executeSetInstruction(const InstructionEntry& instructio
 	int new_value{ getOperand2(instruction) };
 
 	if (trace_mode == TraceMode::ALL_OPCODES) {
-		cout << int_variable_table.getName(instruction.operand1) << " = " << new_value << endl;
+		traceInstruction(instruction, 0, new_value, new_value, false);
 	}
 
-	int_variable_table.setValue(instruction.operand1, new_value);
+	variable_values[instruction.operand1] = new_value;
 
 	program_counter++;
 }
@@ -281,7 +347,7 @@ void FlightPlanExecute::executeCmpInstruction(const InstructionEntry& instructio
 	int operand2{ getOperand2(instruction) };
 
 	if (trace_mode == TraceMode::ALL_OPCODES) {
-		cout << operand1 << " == " << operand2 << " ?" << endl;
+		traceInstruction(instruction, operand1, operand2, 0, false);
 	}
 
 	compare_returns_equal = (operand1 == operand2);
@@ -297,12 +363,7 @@ void FlightPlanExecute::executeBeqInstruction(const InstructionEntry& instructio
 	assert(instruction.opcode == Opcodes::BEQ);
 
 	if (trace_mode == TraceMode::ALL_OPCODES) {
-		if (compare_returns_equal) {
-			cout << "BEQ taken to label " << label_table.getName(instruction.operand1) << endl;
-		}
-		else {
-			cout << "BEQ skipped" << endl;
-		}
+		traceInstruction(instruction, 0, 0, 0, compare_returns_equal);
 	}
 
 	if (compare_returns_equal) {
@@ -321,12 +382,7 @@ void FlightPlanExecute::executeBneInstruction(const InstructionEntry& instructio
 	assert(instruction.opcode == Opcodes::BNE);
 
 	if (trace_mode == TraceMode::ALL_OPCODES) {
-		if (compare_returns_equal) {
-			cout << "BNE skipped" << endl;
-		}
-		else {
-			cout << "BNE taken to label " << label_table.getName(instruction.operand1) << endl;
-		}
+		traceInstruction(instruction, 0, 0, 0, !compare_returns_equal);
 	}
 
 	if (compare_returns_equal) {
@@ -345,7 +401,7 @@ void FlightPlanExecute::executeBraInstruction(const InstructionEntry& instructio
 	assert(instruction.opcode == Opcodes::BRA);
 
 	if (trace_mode == TraceMode::ALL_OPCODES) {
-		cout << "BRA to label " << label_table.getName(instruction.operand1) << endl;
+		traceInstruction(instruction, 0, 0, 0, true);
 	}
 
 	program_counter = label_table.getValue(instruction.operand1);
@@ -353,42 +409,46 @@ void FlightPlanExecute::executeBraInstruction(const InstructionEntry& instructio
 
 
 // Execute a drone command.
-// Drone commands containing identifiers beginning with '%' will have the identifier substrings
-// replaced with the current values of the corresponding integer variables.
+// The command was compiled when the program was parsed; any integer variable arguments are
+// replaced with the current values of the variables, and a command whose values are outside the
+// Tello's limits is skipped.
+// If snapshot recording is enabled, a snapshot is written once the command has completed.
 
 void FlightPlanExecute::executeCmdInstruction(const InstructionEntry& instruction)
 {
 	assert(instruction.opcode == Opcodes::CMD);
 
-	string command{ drone_command_table.getCommand(instruction.operand1) };
-	string modified_command{ insertVariableValues(command) };
+	const CompiledDroneCommand& compiled{ drone_command_table.getCompiledCommand(instruction.operand1) };
 
-	if ((trace_mode == TraceMode::ALL_OPCODES) || (trace_mode == TraceMode::CMD_NOP_OPCODES)) {
-		cout << "CMD " << command;
-		if (modified_command != command) {
-			cout << " becomes CMD " << modified_command;
-		}
-		cout << endl;
+	DroneCommand command;
+
+	if (trace_logger != nullptr) {
+		TraceEvent event;
+		command = resolveDroneCommand(compiled, &event);
+		traceEvent(instruction, event);
+		trace_logger->flush();
+	}
+	else {
+		command = resolveDroneCommand(compiled);
 	}
 
-	switch (drone_mode) {
-	case DroneMode::NONE:
-		break;
-	case DroneMode::SIMULATOR:
-		executeSimulatorCommand(modified_command);
-		break;
-	case DroneMode::TELLO:
-		executeTelloCommand(modified_command);
-		break;
-	case DroneMode::BOTH:
-		executeSimulatorCommand(modified_command);
-		executeTelloCommand(modified_command);
-		break;
-	default:
-		break;
+	string error;
+
+	if (validDroneCommand(command, error)) {
+		sendDroneCommand(command);
+		recordDroneState(command);
+	}
+	else {
+		reportError("Invalid drone command <" + formatDroneCommand(command) + "> at location "
+					+ to_string(program_counter) + ": " + error + " - command skipped");
 	}
 
 	program_counter++;
+
+	if (!snapshot_file_name.empty()) {
+		waitForDrones();
+		writeSnapshotFile();
+	}
 }
 
 
@@ -400,6 +460,11 @@ void FlightPlanExecute::executeCmdInstruction(const InstructionEntry& instructio
 // For example, if the current time is 5 seconds and n = 7, the application thread will
 // resume in 2 seconds.
 // The application thread does not suspend if the current time is greater than n.
+// Commands sent to the drones are completed first, so that the wait starts from the drones'
+// actual progress rather than from the interpreter's.
+// When no drone backend in use needs real time, such as when only the headless drone simulator is
+// being controlled, or no drone is controlled while a trajectory file is recorded, nothing is
+// waiting to be seen, so instead of suspending the mission clock is advanced to n seconds.
 
 void FlightPlanExecute::executeNopInstruction(const InstructionEntry& instruction)
 {
@@ -407,14 +472,23 @@ void FlightPlanExecute::executeNopInstruction(const InstructionEntry& instructio
 
 	int wait_until_time{ getOperand2(instruction) };
 
-	if ((trace_mode == TraceMode::ALL_OPCODES) || (trace_mode == TraceMode::CMD_NOP_OPCODES)) {
-		cout << "Wait until " << wait_until_time << " seconds since initialization" << endl;
+	if (trace_logger != nullptr) {
+		traceInstruction(instruction, 0, wait_until_time, 0, false);
+		trace_logger->flush();
 	}
 
-	int pause{ (wait_until_time * CLOCKS_PER_SEC) - clock() + timer_start };
+	waitForDrones(wait_until_time * 1000LL);
+
+	const steady_clock::time_point wait_until{ mission_start + seconds(wait_until_time) };
 
-	if (pause > 0) {
-		Sleep(pause);
+	if (!dronesNeedRealTime()) {
+		const steady_clock::time_point now{ steady_clock::now() };
+		if (wait_until > now) {
+			mission_start -= wait_until - now;
+		}
+	}
+	else {
+		std::this_thread::sleep_until(wait_until);
 	}
 
 	program_counter++;
@@ -428,7 +502,7 @@ void FlightPlanExecute::executeEndInstruction(const InstructionEntry& instructio
 	assert(instruction.opcode == Opcodes::END);
 
 	if (trace_mode == TraceMode::ALL_OPCODES) {
-		cout << "END" << endl;
+		traceInstruction(instruction, 0, 0, 0, false);
 	}
 
 	end_program = true;
@@ -436,18 +510,18 @@ void FlightPlanExecute::executeEndInstruction(const InstructionEntry& instructio
 
 
 // The instruction's first operand is assumed to contain a valid index into the integer variable table.
-// The indexed variable's value is returned.
+// The indexed variable's value is returned from the variable_values array.
 
 int FlightPlanExecute::getOperand1(const InstructionEntry& instruction) const
 {
-	return int_variable_table.getValue(instruction.operand1);
+	return variable_values[instruction.operand1];
 }
 
 
 // The instruction's second operand is assumed to contain a valid index into the integer variable table
 // (if the instruction's constant_version field is false) or an integer constant (if the instruction's
 // constant_version field is true).
-// Either the indexed variable's value or the constant value is returned.
+// Either the indexed variable's value (from the variable_values array) or the constant value is returned.
 
 int FlightPlanExecute::getOperand2(const InstructionEntry& instruction) const
 {
@@ -457,66 +531,116 @@ int FlightPlanExecute::getOperand2(const InstructionEntry& instruction) const
 		right_operand = instruction.operand2;
 	}
 	else {
-		right_operand = int_variable_table.getValue(instruction.operand2);
+		right_operand = variable_values[instruction.operand2];
 	}
 
 	return right_operand;
 }
 
 
-// Return the command argument such that all "%variable_name" substrings are replaced with the
-// current value of the corresponding integer variables.
-// The '%' character indicates that the characters which follow the '%' character up to any
-// space or the end of string represents an integer variable name.
-// The integer variable names in the command do not necessarily have to be "x", "y" and "z".
-// Each variable name is extracted from the command string, the name is looked up using
-// IntVariableTable::lookupVariable(), and the variable's current value is determined using
-// IntVariableTable::getValue().
-// If a variable cannot be found in the integer variable table then a value of 0 is used.
-// Example: If integer variables named v1, v2 and v3 have values 23, 39 and 35 respectively,
-// then the string argument "go %v1 %v2 %v3 30" will be transformed to "go 23 39 35 30".
+// Return the drone command compiled from a drone command token, with each integer variable
+// argument replaced with the current value of the variable, read from the variable_values array.
+// Example: If integer variables named v1, v2 and v3 have values 23, 39 and 35 respectively, then
+// the command compiled from "<go %v1 %v2 %v3 30>" becomes "go 23 39 35 30".
+// If a trace event is supplied, the variable values are also recorded in the event, in the order
+// the variables appear in the token.
 
-string FlightPlanExecute::insertVariableValues(const string& command) const
+DroneCommand FlightPlanExecute::resolveDroneCommand(const CompiledDroneCommand& compiled, TraceEvent* event) const
 {
-	enum class EditStates { COPY_MODE, INSERT_MODE };
-	EditStates state{ EditStates::COPY_MODE };
+	DroneCommand command;
 
-	string modified_command;
-	string variable_name;
+	command.kind = compiled.spec->kind;
+	command.spec = compiled.spec;
 
-	const size_t n{ command.length() };
-
-	for (size_t i{ 0 }; i < n; i++) {
-		const char c{ command[i] };
-		switch (state) {
-		case EditStates::COPY_MODE:
-			if (c == '%') {
-				variable_name.clear();
-				state = EditStates::INSERT_MODE;
-			}
-			else {
-				modified_command += c;
-			}
-			break;
-		case EditStates::INSERT_MODE:
-			if ((c == ' ') || (c == '>')) {
-				int index{ int_variable_table.lookupVariable(variable_name) };
-				int value{ 0 };
-				if (int_variable_table.validIndex(index)) {
-					value = int_variable_table.getValue(index);
-				}
-				modified_command += to_string(value);
-				modified_command += c;
-				state = EditStates::COPY_MODE;
-			}
-			else {
-				variable_name += c;
+	for (int i{ 0 }; i < compiled.spec->num_arguments; i++) {
+		const DroneArgument& argument{ compiled.arguments[i] };
+		if (argument.constant) {
+			command.arguments[i] = argument.value;
+		}
+		else {
+			command.arguments[i] = variable_values[argument.value];
+			if ((event != nullptr) && (event->num_values < MAX_TRACE_VALUES)) {
+				event->values[event->num_values] = command.arguments[i];
+				event->num_values++;
 			}
-			break;
-		default:
-			break;
 		}
 	}
 
-	return modified_command;
+	return command;
+}
+
+
+// Copy the current value of every integer variable into the variable_values array, which is
+// (re)allocated to match the size of the integer variable table.
+// Instructions then read and write variables by direct index rather than through the table.
+
+void FlightPlanExecute::loadVariables()
+{
+	delete[] variable_values;
+
+	num_variables   = int_variable_table.numVariables();
+	variable_values = new int[num_variables > 0 ? num_variables : 1];
+
+	for (int i{ 0 }; i < num_variables; i++) {
+		variable_values[i] = int_variable_table.getValue(i);
+	}
+}
+
+
+// Write the values held in the variable_values array back into the integer variable table.
+// This is done automatically when program execution ends, but clients may also call it at any
+// other time to observe the current variable values through the integer variable table.
+
+void FlightPlanExecute::storeVariables() const
+{
+	for (int i{ 0 }; i < num_variables; i++) {
+		int_variable_table.setValue(i, variable_values[i]);
+	}
+}
+
+
+// Record a trace event for the instruction about to be completed.
+// The operand values, the value assigned and whether a branch is taken are supplied by the caller.
+
+void FlightPlanExecute::traceInstruction(const InstructionEntry& instruction,
+										 int value1, int value2, int result, bool taken)
+{
+	TraceEvent event;
+
+	event.value1 = value1;
+	event.value2 = value2;
+	event.result = result;
+	event.taken  = taken;
+
+	traceEvent(instruction, event);
+}
+
+
+// Complete a trace event with the instruction's location, opcode and first operand, then pass it
+// to the trace logger.
+
+void FlightPlanExecute::traceEvent(const InstructionEntry& instruction, TraceEvent& event)
+{
+	event.program_counter = program_counter;
+	event.opcode          = instruction.opcode;
+	event.operand1        = instruction.operand1;
+
+	trace_logger->record(event);
+}
+
+
+// Write an execution error message to the console after any trace lines still being written.
+// With full tracing the message is preceded by the program counter, like a trace line.
+
+void FlightPlanExecute::reportError(const string& message)
+{
+	if (trace_logger != nullptr) {
+		trace_logger->flush();
+	}
+
+	if (trace_mode == TraceMode::ALL_OPCODES) {
+		cout << std::right << std::setw(8) << program_counter << "    ";
+	}
+
+	cout << message << endl;
 }
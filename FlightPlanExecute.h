@@ -2,7 +2,10 @@
 #define FLIGHT_PLAN_EXECUTE_H
 
 
+#include "DroneCommand.h"
+#include <chrono>
 #include <string>
+#include <vector>
 
 
 // FlightPlanExecute class version 1.2
@@ -10,6 +13,8 @@
 // The tables generated by the FlightPlanParse class are used the FlightPlanExecute class
 // to execute the FPL program.
 // The only table modified by the FlightPlanExecute class is the integer variable table.
+// During execution the integer variable values are held in a flat array owned by FlightPlanExecute,
+// and the values are written back to the integer variable table when execution ends.
 
 
 // Select which drone(s) to control during FPL execution, including none and both.
@@ -22,22 +27,65 @@ enum class DroneMode { NONE, SIMULATOR, TELLO, BOTH };
 enum class TraceMode { OFF, CMD_NOP_OPCODES, ALL_OPCODES };
 
 
+// Select what happens when instructions are traced faster than the trace can be written out.
+
+enum class TraceOverflow { BLOCK, DROP };
+
+
+// Select how the speed of each move is chosen: the drone's own speed (set by "arm" or "speed"),
+// the fastest speed allowed, or the lowest speed that still arrives by the next NOP deadline.
+
+enum class SpeedPolicy { FIXED, FASTEST, CONSERVE };
+
+
 // Forward declarations to reduce the need for include files.
 
 class IntVariableTable;
 class LabelTable;
 class DroneCommandTable;
 class InstructionTable;
-class DroneSimulator;
-class Tello;
+class DroneBackend;
+class SimulatorBackend;
+class TelloBackend;
+class TelloSwarm;
+class FlightPlanParse;
+class TraceLogger;
+class TraceRecorder;
+class TrajectoryRecorder;
 
 struct InstructionEntry;
+struct TraceEvent;
+
+
+// Execution counts and timing gathered for one instruction table entry when profiling is enabled.
+// Taken and not taken counts are only recorded for branch instructions, and elapsed time is only
+// recorded for CMD and NOP instructions.
+
+struct InstructionProfile
+{
+	long long executions{ 0 };
+	long long branches_taken{ 0 };
+	long long branches_not_taken{ 0 };
+	std::chrono::steady_clock::duration elapsed{ 0 };
+};
+
+
+// Command count and time gathered for one drone backend when profiling is enabled. The time
+// includes waiting for the backend's drone to finish its commands.
+
+struct BackendProfile
+{
+	long long commands{ 0 };
+	std::chrono::steady_clock::duration time{ 0 };
+};
 
 
 // The FlightPlanExecute class encapsulates all member functions and data structures needed to execute
 // FPL programs and communicate with a drone.
 // The four parse tables used by the FlightPlanExecute class are generated by the FlightPlanParse class.
-// See FlightPlanExecute.cpp and FlightPlanTello.cpp for a description of the member functions.
+// See FlightPlanExecute.cpp, FlightPlanDrones.cpp, FlightPlanSnapshot.cpp,
+// FlightPlanProfile.cpp, FlightPlanRecord.cpp and FlightPlanTrajectory.cpp for a description of the
+// member functions.
 
 class FlightPlanExecute
 {
@@ -50,10 +98,33 @@ public:		// member functions intended to be used by clients of the class
 	~FlightPlanExecute();										// destructor
 
 	void executeProgram(DroneMode drone, TraceMode trace);
+	void setTraceOverflow(TraceOverflow overflow);
+	void storeVariables() const;
+
+	std::string snapshot() const;
+	bool        restore(const std::string& snapshot_data);
+	void        recordSnapshots(const std::string& file_name);
+	bool        restoreFromFile(const std::string& file_name);
+
+	void enableProfiling(bool enable);
+	void displayProfile(const FlightPlanParse& parse) const;
+
+	void recordTrace(const std::string& file_name);
+	void recordTrajectory(const std::string& file_name);
+
+	void useHeadlessSimulator(const std::string& image_file_name = "");
+	void useSimulatorViewer(const std::string& link_name = "");
+	void setSimulatorStart(int x, int y);
+	void useTelloSwarm(TelloSwarm& swarm, int drone);
+	void addDroneBackend(DroneBackend& backend);
+	void enableMotionCoalescing(bool enable);
+	void setSpeedPolicy(SpeedPolicy policy, int max_speed = 100);
 
 private:	// member functions not intended to be used by clients of the class
 
 	void executeNextInstruction();
+	void executeProfiledInstruction();
+	void executeRecordedInstruction();
 
 	void executeIntInstruction(const InstructionEntry& instruction);
 	void executeAddInstruction(const InstructionEntry& instruction);
@@ -69,13 +140,41 @@ private:	// member functions not intended to be used by clients of the class
 	void executeNopInstruction(const InstructionEntry& instruction);
 	void executeEndInstruction(const InstructionEntry& instruction);
 
-	void executeSimulatorCommand(const std::string& command);
-	void executeTelloCommand(const std::string& command);
+	void sendDroneCommand(DroneCommand command);
+	void dispatchDroneCommand(const DroneCommand& command);
+	void sendToBackends(const DroneCommand& command);
+	bool coalesceMove(const DroneCommand& command);
+	void flushPendingMove();
+	void waitForDrones(long long deadline_ms = -1);
+	bool dronesNeedRealTime() const;
+	void selectDroneBackends();
+	void finishDrones();
 
 	int  getOperand1(const InstructionEntry& instruction) const;
 	int  getOperand2(const InstructionEntry& instruction) const;
 
-	std::string insertVariableValues(const std::string& command) const;
+	DroneCommand resolveDroneCommand(const CompiledDroneCommand& compiled, TraceEvent* event = nullptr) const;
+
+	void traceInstruction(const InstructionEntry& instruction, int value1, int value2, int result, bool taken);
+	void traceEvent(const InstructionEntry& instruction, TraceEvent& event);
+	void reportError(const std::string& message);
+
+	void loadVariables();
+
+	void recordDroneState(const DroneCommand& command);
+	void resumeDroneState();
+	void writeSnapshotFile() const;
+
+	void resetProfile();
+
+	void      startTraceRecording();
+	void      startTrajectoryRecording();
+	void      recordDroneCommand(const DroneCommand& command);
+	long long missionMilliseconds() const;
+
+	void planSpeeds(long long deadline_ms);
+	int  plannedSpeed(long long deadline_ms);
+	void displaySpeedReport() const;
 
 private:	// data members should always have private scope
 
@@ -84,17 +183,58 @@ private:	// data members should always have private scope
 	const DroneCommandTable& drone_command_table;	// records drone commands
 	const InstructionTable&  instruction_table;		// records instructions
 
-	DroneSimulator* drone_simulator{ nullptr };		// dynamically instantiated drone simulator object
-	Tello* tello_drone{ nullptr };					// dynamically instantiated Tello object
+	SimulatorBackend* simulator_backend{ nullptr };	// dynamically instantiated drone simulator backend
+	TelloBackend*     tello_backend{ nullptr };		// dynamically instantiated Tello backend
+	std::vector<DroneBackend*> added_backends;		// backends added by clients, not owned
+	std::vector<DroneBackend*> drone_backends;		// backends used by the current execution
+	int simulator_start_x{ 0 };						// where the simulated drone starts on the ground
+	int simulator_start_y{ 0 };
+
+	int* variable_values{ nullptr };				// dynamically allocated copy of the integer variable values
+	int  num_variables{ 0 };						// number of entries in variable_values
 
 	TraceMode trace_mode{ TraceMode::OFF };			// level of instruction tracing desired
+	TraceOverflow trace_overflow{ TraceOverflow::BLOCK };	// what to do when the trace falls behind
+	TraceLogger* trace_logger{ nullptr };			// dynamically instantiated while tracing
 	DroneMode drone_mode{ DroneMode::NONE };		// what drone to control, if any
 
-	int timer_start{ 0 };							// clock() value when the drone is initialized
+	std::chrono::steady_clock::time_point mission_start;	// time when program execution started
 	int program_counter{ 0 };						// index of the next instruction to execute
 
 	bool compare_returns_equal{ false };			// result of a CMP instruction
 	bool end_program{ false };						// an END instruction or error was encountered
+
+	bool drone_initialized{ false };				// an "<initialize>" command has been executed
+	bool drone_armed{ false };						// an "<arm>" command has been executed
+	bool drone_airborne{ false };					// a "<takeoff>" command has been executed without a "<land>"
+
+	bool resume_pending{ false };					// restore() succeeded so executeProgram() should resume
+	int  restored_clock_ms{ 0 };					// mission clock value recorded in the restored snapshot
+	std::string snapshot_file_name;					// if not empty, a snapshot is written after every CMD
+
+	bool profiling{ false };						// gather an execution profile while executing
+	InstructionProfile* instruction_profiles{ nullptr };	// dynamically allocated profile per instruction
+	int  num_profiles{ 0 };							// number of entries in instruction_profiles
+
+	std::vector<BackendProfile> backend_profiles;	// profile of each entry of drone_backends
+
+	bool         motion_coalescing{ false };		// merge consecutive collinear move commands
+	bool         move_pending{ false };				// pending_move has not been sent yet
+	DroneCommand pending_move;						// move command held back to be merged with the next
+	int          coalesced_moves{ 0 };				// move commands merged into an earlier one
+
+	SpeedPolicy  speed_policy{ SpeedPolicy::FIXED };	// how the speed of each move is chosen
+	int          max_move_speed{ 100 };				// fastest speed planned for a move in cm/s
+	std::vector<DroneCommand> planned_commands;		// commands held back until their speeds are planned
+	int          planned_moves{ 0 };				// moves given a planned speed
+	long long    planned_speed_total{ 0 };			// sum of the speeds planned for those moves
+	int          missed_deadlines{ 0 };				// NOP deadlines the planned moves cannot meet
+
+	std::string    trace_file_name;					// if not empty, a binary execution trace is recorded
+	TraceRecorder* trace_recorder{ nullptr };		// dynamically instantiated while recording
+
+	std::string         trajectory_file_name;				// if not empty, a trajectory file is recorded
+	TrajectoryRecorder* trajectory_recorder{ nullptr };	// dynamically instantiated while recording
 };
 
 
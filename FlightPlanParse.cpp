@@ -14,7 +14,7 @@ using std::string;
 using std::to_string;
 
 
-// FlightPlanParse class version 1.2
+// FlightPlanParse class version 1.3
 
 // The FlightPlanParse class parse a flight plan language program and creates four parse tables.
 
@@ -251,8 +251,15 @@ bool FlightPlanParse::addLabelOrInstruction(string tokens[])
 			break;
 		case Opcodes::CMD:
 			if (isDroneCommand(tokens[1]) && tokens[2].empty()) {
-				instruction.operand1 = drone_command_table.addCommand(tokens[1]);
-				valid_tokens = true;
+				CompiledDroneCommand compiled;
+				string               error;
+				if (compileDroneCommand(tokens[1], int_variable_table, compiled, error)) {
+					instruction.operand1 = drone_command_table.addCommand(tokens[1], compiled);
+					valid_tokens = true;
+				}
+				else {
+					cout << "Invalid drone command " << addQuotes(tokens[1]) << ": " << error << endl;
+				}
 			}
 			break;
 		case Opcodes::NOP:
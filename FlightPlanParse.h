@@ -5,7 +5,7 @@
 #include <string>
 
 
-// FlightPlanParse class version 1.2
+// FlightPlanParse class version 1.3
 
 
 // When a compiler parses a language, it builds a variety of data structures such as tables.
@@ -42,14 +42,14 @@ public:		// member functions intended to be used by clients of the class
 		            DroneCommandTable& drone_commands,
 		            InstructionTable&  instructions);	// constructor
 
-	void parseLine(const std::string& line);
-	bool parseSuccess() const;
-	void displayInstructions() const;
+	void        parseLine(const std::string& line);
+	bool        parseSuccess() const;
+	void        displayInstructions() const;
+	std::string indexToInstructionLine(int index) const;
 
 private:	// member functions not intended to be used by clients of the class
 
 	bool        addLabelOrInstruction(std::string tokens[]);
-	std::string indexToInstructionLine(int index) const;
 	bool        validInstructionOperands(int index) const;
 
 private:	// data members should always have private scope
@@ -0,0 +1,264 @@
+#include "FlightPlanExecute.h"
+#include "FlightPlanParse.h"
+#include "DroneBackend.h"
+#include "LabelTable.h"
+#include "InstructionTable.h"
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+
+// FlightPlanExecute class version 1.2
+
+// This subset of the FlightPlanExecute member functions concentrates on gathering and reporting
+// an execution profile: how often each instruction executes, how often each branch is taken,
+// and where the time spent in CMD and NOP instructions goes.
+
+
+using std::cout;
+using std::endl;
+using std::fixed;
+using std::left;
+using std::right;
+using std::setprecision;
+using std::setw;
+using std::sort;
+using std::string;
+using std::vector;
+using std::chrono::duration;
+using std::chrono::steady_clock;
+
+
+// A loop is formed by a backward branch, and is considered hot if the instructions in its body
+// account for at least this percentage of all instructions executed.
+
+static const double HOT_LOOP_PERCENT{ 10.0 };
+
+
+// A loop found while reporting the profile: the instructions from first_index to branch_index
+// inclusive, repeated whenever the branch at branch_index is taken.
+
+struct ProfiledLoop
+{
+	int       first_index{ 0 };
+	int       branch_index{ 0 };
+	long long iterations{ 0 };
+	long long executions{ 0 };
+};
+
+
+// Convert a steady_clock duration to milliseconds for display.
+
+static double toMilliseconds(steady_clock::duration elapsed)
+{
+	return duration<double, std::milli>(elapsed).count();
+}
+
+
+// Select whether subsequent calls to executeProgram() gather an execution profile.
+
+void FlightPlanExecute::enableProfiling(bool enable)
+{
+	profiling = enable;
+}
+
+
+// Clear the profile gathered by a previous execution and size it to match the instruction table.
+
+void FlightPlanExecute::resetProfile()
+{
+	delete[] instruction_profiles;
+
+	num_profiles         = instruction_table.numInstructions();
+	instruction_profiles = new InstructionProfile[num_profiles > 0 ? num_profiles : 1];
+
+	backend_profiles.assign(drone_backends.size(), BackendProfile());
+}
+
+
+// Execute the instruction appearing at instruction_table[program_counter] while recording its
+// execution count, the outcome of branch instructions, and the time taken by CMD and NOP
+// instructions.
+
+void FlightPlanExecute::executeProfiledInstruction()
+{
+	const int          index{ program_counter };
+	const Opcodes      opcode{ instruction_table.getInstruction(index).opcode };
+	InstructionProfile& profile{ instruction_profiles[index] };
+
+	profile.executions++;
+
+	switch (opcode) {
+	case Opcodes::BEQ:
+		if (compare_returns_equal) {
+			profile.branches_taken++;
+		}
+		else {
+			profile.branches_not_taken++;
+		}
+		executeNextInstruction();
+		break;
+	case Opcodes::BNE:
+		if (compare_returns_equal) {
+			profile.branches_not_taken++;
+		}
+		else {
+			profile.branches_taken++;
+		}
+		executeNextInstruction();
+		break;
+	case Opcodes::BRA:
+		profile.branches_taken++;
+		executeNextInstruction();
+		break;
+	case Opcodes::CMD:
+	case Opcodes::NOP:
+	{
+		const steady_clock::time_point start{ steady_clock::now() };
+		executeNextInstruction();
+		profile.elapsed += steady_clock::now() - start;
+		break;
+	}
+	default:
+		executeNextInstruction();
+		break;
+	}
+}
+
+
+// Display the profile gathered by the most recent profiled execution.
+// Each instruction is listed with its labels, reconstructed source line, execution count, branch
+// outcomes and elapsed time, and instructions inside hot loops are marked with '*'.
+// The loops found are then listed from hottest to coolest, followed by a summary of the time spent
+// sending commands to each drone and waiting in NOP instructions.
+
+void FlightPlanExecute::displayProfile(const FlightPlanParse& parse) const
+{
+	if ((instruction_profiles == nullptr) || (num_profiles == 0)) {
+		cout << endl << "No execution profile is available" << endl;
+		return;
+	}
+
+	long long total_executions{ 0 };
+	steady_clock::duration cmd_time{ 0 };
+	steady_clock::duration nop_time{ 0 };
+	long long nop_count{ 0 };
+
+	for (int i{ 0 }; i < num_profiles; i++) {
+		const InstructionProfile& profile{ instruction_profiles[i] };
+		total_executions += profile.executions;
+		const Opcodes opcode{ instruction_table.getInstruction(i).opcode };
+		if (opcode == Opcodes::CMD) {
+			cmd_time += profile.elapsed;
+		}
+		else if (opcode == Opcodes::NOP) {
+			nop_time  += profile.elapsed;
+			nop_count += profile.executions;
+		}
+	}
+
+	// Find the loops formed by taken backward branches.
+
+	vector<ProfiledLoop> loops;
+
+	for (int i{ 0 }; i < num_profiles; i++) {
+		const InstructionEntry instruction{ instruction_table.getInstruction(i) };
+		const bool is_branch{ (instruction.opcode == Opcodes::BEQ) || (instruction.opcode == Opcodes::BNE) ||
+							  (instruction.opcode == Opcodes::BRA) };
+		if (is_branch && (instruction_profiles[i].branches_taken > 0)) {
+			const int target{ label_table.getValue(instruction.operand1) };
+			if ((target >= 0) && (target <= i)) {
+				ProfiledLoop loop;
+				loop.first_index  = target;
+				loop.branch_index = i;
+				loop.iterations   = instruction_profiles[i].branches_taken;
+				for (int j{ target }; j <= i; j++) {
+					loop.executions += instruction_profiles[j].executions;
+				}
+				loops.push_back(loop);
+			}
+		}
+	}
+
+	sort(loops.begin(), loops.end(),
+		 [](const ProfiledLoop& a, const ProfiledLoop& b) { return a.executions > b.executions; });
+
+	// Mark the instructions that belong to a hot loop.
+
+	vector<bool> hot(num_profiles, false);
+
+	for (const ProfiledLoop& loop : loops) {
+		if (100.0 * loop.executions >= HOT_LOOP_PERCENT * total_executions) {
+			for (int j{ loop.first_index }; j <= loop.branch_index; j++) {
+				hot[j] = true;
+			}
+		}
+	}
+
+	cout << endl << "Execution profile: [program counter | executions | taken | not taken | ms | instruction]"
+		 << endl << endl;
+
+	cout << fixed << setprecision(3);
+
+	for (int i{ 0 }; i < num_profiles; i++) {
+		const InstructionProfile& profile{ instruction_profiles[i] };
+		const Opcodes opcode{ instruction_table.getInstruction(i).opcode };
+		string labels{ label_table.instructionIndexToLabels(i) };
+		if (labels.length() > 0) {
+			cout << labels;
+		}
+		cout << (hot[i] ? "  * " : "    ") << right << setw(8) << i << setw(12) << profile.executions;
+		if ((opcode == Opcodes::BEQ) || (opcode == Opcodes::BNE) || (opcode == Opcodes::BRA)) {
+			cout << setw(10) << profile.branches_taken << setw(10) << profile.branches_not_taken;
+		}
+		else {
+			cout << setw(20) << "";
+		}
+		if ((opcode == Opcodes::CMD) || (opcode == Opcodes::NOP)) {
+			cout << setw(12) << toMilliseconds(profile.elapsed);
+		}
+		else {
+			cout << setw(12) << "";
+		}
+		cout << "    " << left << parse.indexToInstructionLine(i) << endl;
+	}
+
+	cout << endl << right << "Instructions executed: " << total_executions << endl;
+
+	if (loops.empty()) {
+		cout << endl << "No loops were executed" << endl;
+	}
+	else {
+		cout << endl << "Loops: [label | locations | iterations | executions | % of executions]" << endl << endl;
+		for (const ProfiledLoop& loop : loops) {
+			const InstructionEntry branch{ instruction_table.getInstruction(loop.branch_index) };
+			const double percent{ (100.0 * loop.executions) / total_executions };
+			cout << ((percent >= HOT_LOOP_PERCENT) ? "  * " : "    ")
+				 << left << setw(24) << label_table.getName(branch.operand1)
+				 << right << setw(8) << loop.first_index << " - " << left << setw(8) << loop.branch_index
+				 << right << setw(12) << loop.iterations << setw(12) << loop.executions
+				 << setw(10) << percent << endl;
+		}
+	}
+
+	cout << endl << "Time: [activity | count | total ms | mean ms]" << endl << endl;
+	cout << left << setw(24) << "    CMD (all drones)" << right << setw(12) << "" << setw(14)
+		 << toMilliseconds(cmd_time) << endl;
+	for (size_t i{ 0 }; i < backend_profiles.size(); i++) {
+		const BackendProfile& backend{ backend_profiles[i] };
+		if (backend.commands > 0) {
+			cout << left << setw(24) << "    CMD " + string(drone_backends[i]->name()) << right << setw(12) << backend.commands
+				 << setw(14) << toMilliseconds(backend.time)
+				 << setw(12) << toMilliseconds(backend.time) / backend.commands << endl;
+		}
+	}
+	cout << left << setw(24) << "    NOP" << right << setw(12) << nop_count << setw(14) << toMilliseconds(nop_time);
+	if (nop_count > 0) {
+		cout << setw(12) << toMilliseconds(nop_time) / nop_count;
+	}
+	cout << endl;
+
+	cout.unsetf(std::ios::floatfield);
+	cout << setprecision(6);
+}
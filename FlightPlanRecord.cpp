@@ -0,0 +1,118 @@
+#include "FlightPlanExecute.h"
+#include "InstructionTable.h"
+#include "TraceRecorder.h"
+
+
+// FlightPlanExecute class version 1.2
+
+// This subset of the FlightPlanExecute member functions concentrates on recording a binary
+// execution trace, which TraceDecoder can later turn back into the full instruction trace or
+// replay into the drone simulator.
+
+
+using std::string;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+
+// Record a binary execution trace to the named file during subsequent calls to executeProgram().
+// An empty file name disables trace recording.
+
+void FlightPlanExecute::recordTrace(const string& file_name)
+{
+	trace_file_name = file_name;
+}
+
+
+// Create the trace recorder and write the execution state that recording starts from.
+// Recording is skipped if the trace file cannot be created.
+
+void FlightPlanExecute::startTraceRecording()
+{
+	trace_recorder = new TraceRecorder();
+
+	if (!trace_recorder->open(trace_file_name, program_counter, compare_returns_equal,
+							  variable_values, num_variables)) {
+		delete trace_recorder;
+		trace_recorder = nullptr;
+	}
+}
+
+
+// Returns the number of milliseconds elapsed since the start of the mission.
+
+long long FlightPlanExecute::missionMilliseconds() const
+{
+	return duration_cast<milliseconds>(steady_clock::now() - mission_start).count();
+}
+
+
+// Execute the instruction appearing at instruction_table[program_counter] and append its record
+// to the binary execution trace.
+// The instruction is executed with profiling if profiling is also enabled.
+
+void FlightPlanExecute::executeRecordedInstruction()
+{
+	const int              index{ program_counter };
+	const InstructionEntry instruction{ instruction_table.getInstruction(index) };
+
+	trace_recorder->recordInstruction(index);
+
+	int old_value{ 0 };
+
+	switch (instruction.opcode) {
+	case Opcodes::INT:
+	case Opcodes::ADD:
+	case Opcodes::SUB:
+	case Opcodes::MUL:
+	case Opcodes::DIV:
+	case Opcodes::SET:
+		old_value = variable_values[instruction.operand1];
+		break;
+	case Opcodes::CMD:
+		trace_recorder->recordTimestamp(missionMilliseconds());
+		break;
+	case Opcodes::BEQ:
+		trace_recorder->recordOutcome(compare_returns_equal);
+		break;
+	case Opcodes::BNE:
+		trace_recorder->recordOutcome(!compare_returns_equal);
+		break;
+	case Opcodes::BRA:
+		trace_recorder->recordOutcome(true);
+		break;
+	default:
+		break;
+	}
+
+	if (profiling) {
+		executeProfiledInstruction();
+	}
+	else {
+		executeNextInstruction();
+	}
+
+	switch (instruction.opcode) {
+	case Opcodes::INT:
+	case Opcodes::ADD:
+	case Opcodes::SUB:
+	case Opcodes::MUL:
+	case Opcodes::DIV:
+	case Opcodes::SET:
+		trace_recorder->recordValueChange(old_value, variable_values[instruction.operand1]);
+		break;
+	case Opcodes::CMP:
+		trace_recorder->recordOutcome(compare_returns_equal);
+		break;
+	case Opcodes::NOP:
+		trace_recorder->recordTimestamp(missionMilliseconds());
+		trace_recorder->flush();
+		break;
+	case Opcodes::END:
+		trace_recorder->flush();
+		break;
+	default:
+		break;
+	}
+}
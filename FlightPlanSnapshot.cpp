@@ -0,0 +1,266 @@
+#include "FlightPlanExecute.h"
+#include "DroneCommand.h"
+#include "IntVariableTable.h"
+#include "InstructionTable.h"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+
+// FlightPlanExecute class version 1.2
+
+// This subset of the FlightPlanExecute member functions concentrates on taking and restoring
+// snapshots of the execution state, so that an interrupted mission can resume from the last
+// completed drone command rather than from instruction 0.
+
+
+using std::cout;
+using std::endl;
+using std::ifstream;
+using std::ios;
+using std::ofstream;
+using std::ostringstream;
+using std::string;
+
+
+// A snapshot is a compact little-endian binary record:
+//   4 bytes  "FPLS" signature
+//   1 byte   format version
+//   1 byte   flags (compare result, drone initialized, drone armed, drone airborne)
+//   4 bytes  program counter
+//   4 bytes  mission clock in milliseconds
+//   4 bytes  number of integer variables (n)
+//   4n bytes integer variable values in integer variable table order
+
+static const char    SNAPSHOT_SIGNATURE[]{ "FPLS" };
+static const uint8_t SNAPSHOT_VERSION{ 1 };
+static const size_t  SNAPSHOT_HEADER_SIZE{ 18 };
+
+static const uint8_t FLAG_COMPARE_EQUAL{ 0x01 };
+static const uint8_t FLAG_INITIALIZED{ 0x02 };
+static const uint8_t FLAG_ARMED{ 0x04 };
+static const uint8_t FLAG_AIRBORNE{ 0x08 };
+
+
+// Append a 32-bit integer to the snapshot buffer in little-endian byte order.
+
+static void appendInt32(string& buffer, int32_t value)
+{
+	const uint32_t bits{ static_cast<uint32_t>(value) };
+
+	buffer += static_cast<char>(bits & 0xFF);
+	buffer += static_cast<char>((bits >> 8) & 0xFF);
+	buffer += static_cast<char>((bits >> 16) & 0xFF);
+	buffer += static_cast<char>((bits >> 24) & 0xFF);
+}
+
+
+// Read a little-endian 32-bit integer from the snapshot buffer at the specified offset.
+// The caller is responsible for ensuring the buffer holds at least offset + 4 bytes.
+
+static int32_t readInt32(const string& buffer, size_t offset)
+{
+	uint32_t bits{ 0 };
+
+	for (int i{ 3 }; i >= 0; i--) {
+		bits = (bits << 8) | static_cast<uint8_t>(buffer[offset + i]);
+	}
+
+	return static_cast<int32_t>(bits);
+}
+
+
+// Return a binary snapshot of the execution state: the program counter, the result of the last
+// CMP instruction, the mission clock, the drone state implied by the commands executed so far,
+// and the values of all integer variables.
+
+string FlightPlanExecute::snapshot() const
+{
+	string buffer;
+	buffer.reserve(SNAPSHOT_HEADER_SIZE + 4 * num_variables);
+
+	uint8_t flags{ 0 };
+
+	if (compare_returns_equal) {
+		flags |= FLAG_COMPARE_EQUAL;
+	}
+	if (drone_initialized) {
+		flags |= FLAG_INITIALIZED;
+	}
+	if (drone_armed) {
+		flags |= FLAG_ARMED;
+	}
+	if (drone_airborne) {
+		flags |= FLAG_AIRBORNE;
+	}
+
+	buffer.append(SNAPSHOT_SIGNATURE, 4);
+	buffer += static_cast<char>(SNAPSHOT_VERSION);
+	buffer += static_cast<char>(flags);
+	appendInt32(buffer, program_counter);
+	appendInt32(buffer, static_cast<int32_t>(missionMilliseconds()));
+	appendInt32(buffer, num_variables);
+
+	for (int i{ 0 }; i < num_variables; i++) {
+		appendInt32(buffer, variable_values[i]);
+	}
+
+	return buffer;
+}
+
+
+// Restore the execution state from a snapshot previously returned by snapshot().
+// The next call to executeProgram() resumes from the restored program counter.
+// A message is generated and false is returned if the snapshot is malformed or does not match
+// the parse tables of this program.
+
+bool FlightPlanExecute::restore(const string& snapshot_data)
+{
+	if ((snapshot_data.length() < SNAPSHOT_HEADER_SIZE) ||
+		(snapshot_data.compare(0, 4, SNAPSHOT_SIGNATURE) != 0) ||
+		(static_cast<uint8_t>(snapshot_data[4]) != SNAPSHOT_VERSION)) {
+		cout << "Snapshot format not recognized - restore failed" << endl;
+		return false;
+	}
+
+	const uint8_t flags{ static_cast<uint8_t>(snapshot_data[5]) };
+	const int     saved_program_counter{ readInt32(snapshot_data, 6) };
+	const int     saved_clock_ms{ readInt32(snapshot_data, 10) };
+	const int     saved_num_variables{ readInt32(snapshot_data, 14) };
+
+	if ((saved_num_variables != int_variable_table.numVariables()) ||
+		(snapshot_data.length() != SNAPSHOT_HEADER_SIZE + 4 * size_t(saved_num_variables))) {
+		cout << "Snapshot does not match the integer variable table - restore failed" << endl;
+		return false;
+	}
+
+	if (!instruction_table.validIndex(saved_program_counter)) {
+		cout << "Snapshot program counter (" << saved_program_counter
+			 << ") is not a valid instruction index - restore failed" << endl;
+		return false;
+	}
+
+	loadVariables();
+
+	for (int i{ 0 }; i < num_variables; i++) {
+		variable_values[i] = readInt32(snapshot_data, SNAPSHOT_HEADER_SIZE + 4 * size_t(i));
+	}
+
+	program_counter       = saved_program_counter;
+	restored_clock_ms     = saved_clock_ms;
+	compare_returns_equal = ((flags & FLAG_COMPARE_EQUAL) != 0);
+	drone_initialized     = ((flags & FLAG_INITIALIZED) != 0);
+	drone_armed           = ((flags & FLAG_ARMED) != 0);
+	drone_airborne        = ((flags & FLAG_AIRBORNE) != 0);
+	resume_pending        = true;
+
+	return true;
+}
+
+
+// Write a snapshot to the named file after every CMD instruction completes.
+// An empty file name disables snapshot recording.
+
+void FlightPlanExecute::recordSnapshots(const string& file_name)
+{
+	snapshot_file_name = file_name;
+}
+
+
+// Restore the execution state from the most recent snapshot written to the named file.
+// Returns whether the snapshot was read and restored.
+
+bool FlightPlanExecute::restoreFromFile(const string& file_name)
+{
+	ifstream snapshot_file(file_name, ios::binary);
+
+	if (!snapshot_file.is_open()) {
+		cout << "Snapshot file " << file_name << " not found" << endl;
+		return false;
+	}
+
+	ostringstream contents;
+	contents << snapshot_file.rdbuf();
+
+	return restore(contents.str());
+}
+
+
+// Replace the snapshot file with the current execution state.
+// The snapshot is written to a temporary file which is then renamed over the snapshot file, so a
+// crash while writing leaves the previous snapshot intact.
+
+void FlightPlanExecute::writeSnapshotFile() const
+{
+	const string buffer{ snapshot() };
+	const string temporary_name{ snapshot_file_name + ".tmp" };
+
+	{
+		ofstream snapshot_file(temporary_name, ios::binary | ios::trunc);
+
+		if (!snapshot_file.write(buffer.data(), buffer.length()) || !snapshot_file.flush()) {
+			cout << "Unable to write snapshot file " << temporary_name << endl;
+			return;
+		}
+	}
+
+#ifdef _WIN32
+	const bool renamed{ MoveFileExA(temporary_name.c_str(), snapshot_file_name.c_str(), MOVEFILE_REPLACE_EXISTING) != 0 };
+#else
+	const bool renamed{ std::rename(temporary_name.c_str(), snapshot_file_name.c_str()) == 0 };
+#endif
+
+	if (!renamed) {
+		cout << "Unable to replace snapshot file " << snapshot_file_name << endl;
+	}
+}
+
+
+// Track the drone state implied by the drone commands executed so far, so that a resumed
+// program can bring a freshly connected drone back to the same state.
+
+void FlightPlanExecute::recordDroneState(const DroneCommand& command)
+{
+	switch (command.kind) {
+	case DroneCommandKind::INITIALIZE:
+		drone_initialized = true;
+		break;
+	case DroneCommandKind::ARM:
+		drone_armed = true;
+		break;
+	case DroneCommandKind::TAKEOFF:
+		drone_airborne = true;
+		break;
+	case DroneCommandKind::LAND:
+		drone_airborne = false;
+		break;
+	default:
+		break;
+	}
+}
+
+
+// Re-issue the drone commands needed to reproduce the drone state recorded in a restored snapshot.
+
+void FlightPlanExecute::resumeDroneState()
+{
+	if (trace_mode != TraceMode::OFF) {
+		cout << "Resuming at location " << program_counter << endl;
+	}
+
+	if (drone_initialized) {
+		sendDroneCommand(droneCommandOfKind(DroneCommandKind::INITIALIZE));
+	}
+	if (drone_armed) {
+		sendDroneCommand(droneCommandOfKind(DroneCommandKind::ARM));
+	}
+	if (drone_airborne) {
+		sendDroneCommand(droneCommandOfKind(DroneCommandKind::TAKEOFF));
+	}
+}
@@ -0,0 +1,163 @@
+#include "FlightPlanExecute.h"
+#include "KinematicModel.h"
+#include <cmath>
+#include <iostream>
+
+
+// FlightPlanExecute class version 1.2
+
+// This subset of the FlightPlanExecute member functions concentrates on planning the speed of each
+// move from the time the program allows before its next NOP deadline, instead of flying every move
+// at the drone's own speed.
+// The drone commands sent before a NOP instruction are held back until the NOP is reached, which
+// happens as soon as the instructions between them have executed, so the planner knows every move
+// that has to be completed by the NOP's deadline. The same speed is planned for all of those
+// moves, using the motion of the drone simulator's KinematicModel: each move accelerates from rest
+// to its speed and brakes to rest at its target.
+
+
+using std::cout;
+using std::endl;
+using std::vector;
+
+
+static const int    MIN_MOVE_SPEED{ 10 };		// slowest and fastest speeds of the Tello "go" command in cm/s
+static const int    MAX_MOVE_SPEED{ 100 };
+static const double VERTICAL_DISTANCE{ 80.0 };	// climb of a takeoff and descent of a landing in cm
+static const double VERTICAL_SPEED{ 50.0 };		// takeoff and landing speed in cm/s
+static const double COMMAND_SECONDS{ 0.1 };		// allowance for each command's round trip
+
+
+// Return the time taken to fly a distance (in cm) from rest to rest at a cruise speed (in cm/s),
+// accelerating and braking as the KinematicModel does.
+
+static double motionSeconds(double distance, double speed)
+{
+	const double acceleration{ KinematicModel::ACCELERATION };
+
+	if (distance >= speed * speed / acceleration) {
+		return (distance / speed) + (speed / acceleration);
+	}
+
+	return 2.0 * std::sqrt(distance / acceleration);
+}
+
+
+// Return the time taken to carry out the commands with every move flown at the given speed.
+
+static double commandSeconds(const vector<DroneCommand>& commands, int speed)
+{
+	double seconds{ 0.0 };
+
+	for (const DroneCommand& command : commands) {
+		seconds += COMMAND_SECONDS;
+		if (command.kind == DroneCommandKind::MOVE) {
+			const double x{ static_cast<double>(command.arguments[0]) };
+			const double y{ static_cast<double>(command.arguments[1]) };
+			const double z{ static_cast<double>(command.arguments[2]) };
+			seconds += motionSeconds(std::sqrt(x * x + y * y + z * z), speed);
+		}
+		else if ((command.kind == DroneCommandKind::TAKEOFF) || (command.kind == DroneCommandKind::LAND)) {
+			seconds += motionSeconds(VERTICAL_DISTANCE, VERTICAL_SPEED);
+		}
+	}
+
+	return seconds;
+}
+
+
+// Select how the speed of each move is chosen in subsequent program executions:
+// SpeedPolicy::FIXED flies every move at the drone's own speed, as set by "arm" or "speed" commands
+// (30 cm/s for "arm"); SpeedPolicy::FASTEST flies every move at the maximum speed; and
+// SpeedPolicy::CONSERVE flies the moves before each NOP instruction at the lowest speed that still
+// completes them by the NOP's deadline, saving the drone's battery.
+// The maximum speed, in cm/s, is limited to the Tello's range of 10 to 100.
+
+void FlightPlanExecute::setSpeedPolicy(SpeedPolicy policy, int max_speed)
+{
+	speed_policy   = policy;
+	max_move_speed = (max_speed < MIN_MOVE_SPEED) ? MIN_MOVE_SPEED :
+					 (max_speed > MAX_MOVE_SPEED) ? MAX_MOVE_SPEED : max_speed;
+}
+
+
+// Plan the speed of every move held back since the drones were last waited for, and send the held
+// back commands to the drone backends. The deadline is the mission time (in ms) by which the
+// commands should be completed, or -1 if there is none.
+
+void FlightPlanExecute::planSpeeds(long long deadline_ms)
+{
+	const int speed{ plannedSpeed(deadline_ms) };
+
+	for (DroneCommand& command : planned_commands) {
+		if ((command.kind == DroneCommandKind::MOVE) && (speed > 0)) {
+			command.speed = speed;
+			planned_moves++;
+			planned_speed_total += speed;
+		}
+		sendToBackends(command);
+	}
+
+	planned_commands.clear();
+}
+
+
+// Return the speed planned for the moves held back, or 0 for the drone's own speed.
+// Without a deadline SpeedPolicy::CONSERVE keeps the drone's own speed. A deadline that cannot be
+// met even at the maximum speed is counted, and the maximum speed is used.
+
+int FlightPlanExecute::plannedSpeed(long long deadline_ms)
+{
+	bool moves{ false };
+
+	for (const DroneCommand& command : planned_commands) {
+		if (command.kind == DroneCommandKind::MOVE) {
+			moves = true;
+			break;
+		}
+	}
+
+	if (!moves) {
+		return 0;
+	}
+
+	if (deadline_ms < 0) {
+		return (speed_policy == SpeedPolicy::FASTEST) ? max_move_speed : 0;
+	}
+
+	const double available_seconds{ (deadline_ms - missionMilliseconds()) / 1000.0 };
+
+	if (speed_policy == SpeedPolicy::CONSERVE) {
+		for (int speed{ MIN_MOVE_SPEED }; speed < max_move_speed; speed++) {
+			if (commandSeconds(planned_commands, speed) <= available_seconds) {
+				return speed;
+			}
+		}
+	}
+
+	if (commandSeconds(planned_commands, max_move_speed) > available_seconds) {
+		missed_deadlines++;
+	}
+
+	return max_move_speed;
+}
+
+
+// Display how many moves were given a planned speed, their mean speed, and how many NOP deadlines
+// could not be met even at the maximum speed.
+
+void FlightPlanExecute::displaySpeedReport() const
+{
+	cout << endl << "Speed planner (" << ((speed_policy == SpeedPolicy::FASTEST) ? "fastest" : "conserve") << "): ";
+
+	if (planned_moves == 0) {
+		cout << "no move speeds were planned" << endl;
+	}
+	else {
+		cout << planned_moves << " moves planned at a mean speed of " << (planned_speed_total / planned_moves) << " cm/s" << endl;
+	}
+
+	if (missed_deadlines > 0) {
+		cout << missed_deadlines << " NOP deadlines cannot be met even at " << max_move_speed << " cm/s" << endl;
+	}
+}
@@ -0,0 +1,46 @@
+#include "FlightPlanExecute.h"
+#include "TrajectoryRecorder.h"
+
+
+// FlightPlanExecute class version 1.2
+
+// This subset of the FlightPlanExecute member functions concentrates on writing trajectory files,
+// which record every drone command sent so that fpl-viewer can replay the mission without
+// executing the program again.
+
+
+using std::string;
+
+
+// Record every drone command sent during subsequent calls to executeProgram() in the named
+// trajectory file, which is replaced by each execution. An empty file name disables recording.
+// When no drone is controlled (DroneMode::NONE) NOP instructions do not wait, so a trajectory
+// file can be written as fast as the program executes.
+
+void FlightPlanExecute::recordTrajectory(const string& file_name)
+{
+	trajectory_file_name = file_name;
+}
+
+
+// Create the trajectory recorder.
+// Recording is skipped if the trajectory file cannot be created.
+
+void FlightPlanExecute::startTrajectoryRecording()
+{
+	trajectory_recorder = new TrajectoryRecorder();
+
+	if (!trajectory_recorder->open(trajectory_file_name)) {
+		delete trajectory_recorder;
+		trajectory_recorder = nullptr;
+	}
+}
+
+
+// Record a drone command with the mission time it was sent at and the location of the CMD
+// instruction that sent it.
+
+void FlightPlanExecute::recordDroneCommand(const DroneCommand& command)
+{
+	trajectory_recorder->recordCommand(command.time_ms, command.instruction, command);
+}
@@ -0,0 +1,215 @@
+#include "KinematicModel.h"
+#include <algorithm>
+#include <cmath>
+
+
+// Kinematic Model class version 1.4
+
+
+using std::max;
+using std::size_t;
+
+
+// Branch-free minimum and maximum of two values, which compile to vector selects.
+
+static inline float lower(float a, float b)
+{
+	return (b < a) ? b : a;
+}
+
+static inline float higher(float a, float b)
+{
+	return (a < b) ? b : a;
+}
+
+
+// Static data member definitions:
+
+const double KinematicModel::STEP{ 0.01 };				// seconds advanced by each step()
+const float  KinematicModel::ACCELERATION{ 200.0f };	// maximum acceleration and braking in cm/s/s
+const float  KinematicModel::DEFAULT_SPEED{ 30.0f };	// cruise speed until one is set, in cm/s
+
+
+// Add a drone at rest at a position, the origin by default, and return its index, starting at 0.
+
+int KinematicModel::addDrone(float x, float y, float z)
+{
+	for (std::vector<float>* values : { &direction_x, &direction_y, &direction_z,
+										&length, &travelled, &speed, &motion_speed }) {
+		values->push_back(0.0f);
+	}
+
+	start_x.push_back(x);
+	start_y.push_back(y);
+	start_z.push_back(z);
+	target_x.push_back(x);
+	target_y.push_back(y);
+	target_z.push_back(z);
+
+	cruise_speed.push_back(DEFAULT_SPEED);
+
+	return int(cruise_speed.size()) - 1;
+}
+
+
+// Returns the number of drones in the model.
+
+int KinematicModel::numDrones() const
+{
+	return int(cruise_speed.size());
+}
+
+
+// Set the cruise speed used by later moveBy() calls.
+
+void KinematicModel::setCruiseSpeed(int drone, float speed)
+{
+	cruise_speed[drone] = max(speed, 1.0f);
+}
+
+
+// Start a move to a target relative to the drone's current target at the given speed, or at its
+// cruise speed if the speed is 0, like the Tello's "go" command.
+// If the drone is still moving it turns towards the new target from where it is, starting again
+// from rest.
+
+void KinematicModel::moveBy(int drone, float dx, float dy, float dz, float speed)
+{
+	const float move_speed{ (speed > 0.0f) ? speed : cruise_speed[drone] };
+
+	startMotion(drone, target_x[drone] + dx, target_y[drone] + dy, target_z[drone] + dz, move_speed);
+}
+
+
+// Start a move to an absolute target at the given cruise speed, such as a climb to take off.
+
+void KinematicModel::moveTo(int drone, float x, float y, float z, float speed)
+{
+	startMotion(drone, x, y, z, max(speed, 1.0f));
+}
+
+
+// Put the drone at rest at the end of its current motion at once.
+
+void KinematicModel::finishMotion(int drone)
+{
+	start_x[drone]     = target_x[drone];
+	start_y[drone]     = target_y[drone];
+	start_z[drone]     = target_z[drone];
+	direction_x[drone] = 0.0f;
+	direction_y[drone] = 0.0f;
+	direction_z[drone] = 0.0f;
+	length[drone]      = 0.0f;
+	travelled[drone]   = 0.0f;
+	speed[drone]       = 0.0f;
+}
+
+
+// Advance every drone by STEP seconds.
+// Only the distance travelled and the speed are updated; positions are worked out when asked for.
+// A drone's speed is the lowest of its cruise speed, its speed after accelerating for one step, and
+// the highest speed from which it can still brake to rest at the target.
+
+void KinematicModel::step()
+{
+	const size_t n{ cruise_speed.size() };
+	const float  dt{ float(STEP) };
+	const float  dv{ ACCELERATION * dt };
+	const float  two_a{ 2.0f * ACCELERATION };
+
+	// Plain pointers let the compiler see that the loop body only touches element i of each array.
+	float* const       s{ travelled.data() };
+	float* const       v{ speed.data() };
+	const float* const l{ length.data() };
+	const float* const cruise{ motion_speed.data() };
+
+	for (size_t i{ 0 }; i < n; i++) {
+		const float remaining{ higher(l[i] - s[i], 0.0f) };
+		const float braking_speed{ std::sqrt(two_a * remaining) };
+		const float new_speed{ lower(lower(cruise[i], braking_speed), v[i] + dv) };
+		const float distance{ lower(new_speed * dt, remaining) };
+		s[i] += distance;
+		v[i]  = (distance < remaining) ? new_speed : 0.0f;
+	}
+
+	simulated_time += STEP;
+}
+
+
+// Returns the number of seconds simulated so far.
+
+double KinematicModel::time() const
+{
+	return simulated_time;
+}
+
+
+// Set the number of seconds simulated so far, such as when a replay seeks backwards.
+// The drones are left where they are.
+
+void KinematicModel::setTime(double seconds)
+{
+	simulated_time = seconds;
+}
+
+
+// Returns whether the drone has not yet reached its target.
+
+bool KinematicModel::moving(int drone) const
+{
+	return travelled[drone] < length[drone];
+}
+
+
+// Returns the distance from the drone to its target along its path.
+
+float KinematicModel::remainingDistance(int drone) const
+{
+	return max(length[drone] - travelled[drone], 0.0f);
+}
+
+
+// Return the drone's current position.
+
+float KinematicModel::x(int drone) const
+{
+	return start_x[drone] + direction_x[drone] * travelled[drone];
+}
+
+float KinematicModel::y(int drone) const
+{
+	return start_y[drone] + direction_y[drone] * travelled[drone];
+}
+
+float KinematicModel::z(int drone) const
+{
+	return start_z[drone] + direction_z[drone] * travelled[drone];
+}
+
+
+// Start a straight-line motion from the drone's current position to a target, from rest.
+
+void KinematicModel::startMotion(int drone, float new_target_x, float new_target_y, float new_target_z, float new_speed)
+{
+	const float current_x{ x(drone) };
+	const float current_y{ y(drone) };
+	const float current_z{ z(drone) };
+	const float dx{ new_target_x - current_x };
+	const float dy{ new_target_y - current_y };
+	const float dz{ new_target_z - current_z };
+	const float distance{ std::sqrt(dx * dx + dy * dy + dz * dz) };
+
+	start_x[drone]      = current_x;
+	start_y[drone]      = current_y;
+	start_z[drone]      = current_z;
+	target_x[drone]     = new_target_x;
+	target_y[drone]     = new_target_y;
+	target_z[drone]     = new_target_z;
+	direction_x[drone]  = (distance > 0.0f) ? dx / distance : 0.0f;
+	direction_y[drone]  = (distance > 0.0f) ? dy / distance : 0.0f;
+	direction_z[drone]  = (distance > 0.0f) ? dz / distance : 0.0f;
+	length[drone]       = distance;
+	travelled[drone]    = 0.0f;
+	speed[drone]        = 0.0f;
+	motion_speed[drone] = new_speed;
+}
@@ -0,0 +1,71 @@
+#ifndef KINEMATIC_MODEL_H
+#define KINEMATIC_MODEL_H
+
+
+#include <vector>
+
+
+// Kinematic Model class version 1.4
+
+// A fixed-timestep model of the motion of any number of simulated drones.
+// Each drone flies in a straight line from where it is to its target at no more than its cruise
+// speed, accelerating and braking at no more than ACCELERATION, so that it comes to rest exactly
+// on the target (a trapezoidal speed profile).
+// The state of every drone is kept in separate arrays, one per quantity, and step() advances all
+// drones with the same branch-free loop, which the compiler can vectorize. (GCC and Clang only
+// vectorize its square root and selects with -fno-math-errno and -fno-trapping-math.)
+// Distances are in centimetres and times in seconds, like the Tello drone's commands.
+
+
+class KinematicModel
+{
+public:		// member functions intended to be used by clients of the class
+
+	int  addDrone(float x = 0.0f, float y = 0.0f, float z = 0.0f);
+	int  numDrones() const;
+
+	void setCruiseSpeed(int drone, float speed);
+	void moveBy(int drone, float dx, float dy, float dz, float speed = 0.0f);
+	void moveTo(int drone, float x, float y, float z, float speed);
+	void finishMotion(int drone);
+
+	void   step();
+	double time() const;
+	void   setTime(double seconds);
+
+	bool  moving(int drone) const;
+	float remainingDistance(int drone) const;
+	float x(int drone) const;
+	float y(int drone) const;
+	float z(int drone) const;
+
+	static const double STEP;				// seconds advanced by each step()
+	static const float  ACCELERATION;		// maximum acceleration and braking in cm/s/s
+	static const float  DEFAULT_SPEED;		// cruise speed until one is set, in cm/s
+
+private:	// member functions not intended to be used by clients of the class
+
+	void startMotion(int drone, float target_x, float target_y, float target_z, float speed);
+
+private:	// data members should always have private scope
+
+	double simulated_time{ 0.0 };			// seconds simulated so far
+
+	std::vector<float> start_x;				// where the current motion started
+	std::vector<float> start_y;
+	std::vector<float> start_z;
+	std::vector<float> direction_x;			// unit vector from the start to the target
+	std::vector<float> direction_y;
+	std::vector<float> direction_z;
+	std::vector<float> target_x;			// where the current motion ends
+	std::vector<float> target_y;
+	std::vector<float> target_z;
+	std::vector<float> length;				// distance from the start to the target
+	std::vector<float> travelled;			// distance travelled from the start
+	std::vector<float> speed;				// current speed
+	std::vector<float> motion_speed;		// cruise speed of the current motion
+	std::vector<float> cruise_speed;		// cruise speed for moves
+};
+
+
+#endif // KINEMATIC_MODEL_H
@@ -0,0 +1,121 @@
+#include "SeparationMonitor.h"
+#include "KinematicModel.h"
+#include <cmath>
+
+
+// Separation Monitor class version 1.0
+
+
+using std::int64_t;
+using std::uint64_t;
+using std::vector;
+
+
+// Set the minimum separation between drones, or 0 to stop checking.
+// Pairs that were already too close are reported again if they are still too close.
+
+void SeparationMonitor::setMinimumSeparation(float separation)
+{
+	minimum_separation = (separation > 0.0f) ? separation : 0.0f;
+
+	close_pairs.clear();
+}
+
+
+// Check the current positions of the active drones in the model, and append to started every pair
+// of active drones that is now closer than the minimum separation but was not at the previous check.
+// The active vector has one entry per drone in the model; inactive drones (such as landed drones)
+// are ignored.
+
+void SeparationMonitor::check(const KinematicModel& model, const vector<char>& active, vector<Violation>& started)
+{
+	const int num_drones{ model.numDrones() };
+
+	if ((minimum_separation <= 0.0f) || (num_drones < 2)) {
+		close_pairs.clear();
+		return;
+	}
+
+	// Broad phase: put each active drone in the list for its cell.
+	// Clearing the map keeps its bucket array, so it is not rehashed at every check.
+	cell_heads.clear();
+	next_in_cell.assign(num_drones, -1);
+
+	cells.resize(3 * std::size_t(num_drones));
+
+	for (int d{ 0 }; d < num_drones; d++) {
+		if (!active[d]) {
+			continue;
+		}
+		cells[3 * d]     = cellIndex(model.x(d));
+		cells[3 * d + 1] = cellIndex(model.y(d));
+		cells[3 * d + 2] = cellIndex(model.z(d));
+		const auto inserted{ cell_heads.emplace(cellKey(cells[3 * d], cells[3 * d + 1], cells[3 * d + 2]), d) };
+		if (!inserted.second) {
+			next_in_cell[d]        = inserted.first->second;
+			inserted.first->second = d;
+		}
+	}
+
+	// Narrow phase: any drone closer than the cell size is in the same or a neighbouring cell.
+	// Each pair is measured once, from its lower drone index.
+	const float limit{ minimum_separation * minimum_separation };
+
+	now_close.clear();
+
+	for (int a{ 0 }; a < num_drones; a++) {
+		if (!active[a]) {
+			continue;
+		}
+		const float ax{ model.x(a) };
+		const float ay{ model.y(a) };
+		const float az{ model.z(a) };
+		for (int64_t i{ -1 }; i <= 1; i++) {
+			for (int64_t j{ -1 }; j <= 1; j++) {
+				for (int64_t k{ -1 }; k <= 1; k++) {
+					const auto cell{ cell_heads.find(cellKey(cells[3 * a] + i, cells[3 * a + 1] + j, cells[3 * a + 2] + k)) };
+					if (cell == cell_heads.end()) {
+						continue;
+					}
+					for (int b{ cell->second }; b >= 0; b = next_in_cell[b]) {
+						if (b <= a) {
+							continue;
+						}
+						const float dx{ model.x(b) - ax };
+						const float dy{ model.y(b) - ay };
+						const float dz{ model.z(b) - az };
+						const float squared{ dx * dx + dy * dy + dz * dz };
+						if (squared >= limit) {
+							continue;
+						}
+						const uint64_t pair{ (uint64_t(a) << 32) | uint64_t(b) };
+						now_close.insert(pair);
+						if (close_pairs.count(pair) == 0) {
+							started.push_back({ a, b, std::sqrt(squared) });
+						}
+					}
+				}
+			}
+		}
+	}
+
+	close_pairs.swap(now_close);
+}
+
+
+// Returns the index of the cell containing a coordinate along one axis.
+
+int64_t SeparationMonitor::cellIndex(float coordinate) const
+{
+	return int64_t(std::floor(coordinate / minimum_separation));
+}
+
+
+// Returns the hash key of a cell, packing 21 bits of each cell index.
+
+uint64_t SeparationMonitor::cellKey(int64_t x, int64_t y, int64_t z)
+{
+	const uint64_t mask{ (uint64_t(1) << 21) - 1 };
+
+	return (uint64_t(x) & mask) | ((uint64_t(y) & mask) << 21) | ((uint64_t(z) & mask) << 42);
+}
@@ -0,0 +1,58 @@
+#ifndef SEPARATION_MONITOR_H
+#define SEPARATION_MONITOR_H
+
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+
+// Separation Monitor class version 1.0
+
+// Finds every pair of drones in a KinematicModel closer together than a minimum separation, and
+// reports each pair once when it first comes too close.
+// The drones are indexed in a spatial hash of cubic cells whose side is the minimum separation,
+// so only drones in the same or neighbouring cells are ever compared (the broad phase) before
+// their actual distance is checked (the narrow phase). Each check takes O(n) expected time for n
+// drones that are spread out, instead of the O(n * n) time of comparing every pair.
+// Distances are in centimetres, like the Tello drone's commands.
+
+
+class KinematicModel;
+
+
+class SeparationMonitor
+{
+public:		// member functions intended to be used by clients of the class
+
+	// A pair of drones that has just come closer together than the minimum separation.
+
+	struct Violation
+	{
+		int   drone_a{ 0 };			// the lower drone index in the model
+		int   drone_b{ 0 };			// the higher drone index in the model
+		float distance{ 0.0f };		// distance between the drones
+	};
+
+	void setMinimumSeparation(float separation);
+	void check(const KinematicModel& model, const std::vector<char>& active, std::vector<Violation>& started);
+
+private:	// member functions not intended to be used by clients of the class
+
+	std::int64_t cellIndex(float coordinate) const;
+	static std::uint64_t cellKey(std::int64_t x, std::int64_t y, std::int64_t z);
+
+private:	// data members should always have private scope
+
+	float minimum_separation{ 0.0f };						// 0 disables checking
+
+	std::unordered_map<std::uint64_t, int> cell_heads;		// first drone in each occupied cell
+	std::vector<int>                       next_in_cell;	// next drone in the same cell, or -1
+	std::vector<std::int64_t>              cells;			// x, y and z cell indexes of each drone
+	std::unordered_set<std::uint64_t>      close_pairs;		// pairs too close at the previous check
+	std::unordered_set<std::uint64_t>      now_close;		// pairs too close at this check
+};
+
+
+#endif // SEPARATION_MONITOR_H
@@ -0,0 +1,84 @@
+#ifndef SEQ_LOCK_H
+#define SEQ_LOCK_H
+
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+
+// SeqLock class template version 1.0
+
+// Holds the latest value published by one writer thread for any number of reader threads, without
+// locks. The writer never waits. A reader that overlaps a write notices that the sequence number
+// changed and copies the value again, so it always receives a complete value.
+// The value is held as atomic 32-bit words so that reading it while it is written is not a data
+// race; T must therefore be trivially copyable.
+
+
+template <typename T>
+class SeqLock
+{
+	static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+public:		// member functions intended to be used by clients of the class
+
+	// Publish a new value, replacing the previous one.
+	// Only the writer thread may call store().
+
+	void store(const T& value)
+	{
+		std::uint32_t value_words[NUM_WORDS]{};
+		std::memcpy(value_words, &value, sizeof(T));
+
+		const unsigned sequence_number{ sequence.load(std::memory_order_relaxed) };
+
+		// An odd sequence number tells readers that a write is in progress.
+		sequence.store(sequence_number + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		for (unsigned i{ 0 }; i < NUM_WORDS; i++) {
+			words[i].store(value_words[i], std::memory_order_relaxed);
+		}
+
+		sequence.store(sequence_number + 2, std::memory_order_release);
+	}
+
+	// Copy the latest value into the argument and return true, or return false if no value has been
+	// published yet.
+
+	bool load(T& value) const
+	{
+		std::uint32_t value_words[NUM_WORDS];
+		unsigned      before;
+		unsigned      after;
+
+		do {
+			before = sequence.load(std::memory_order_acquire);
+			for (unsigned i{ 0 }; i < NUM_WORDS; i++) {
+				value_words[i] = words[i].load(std::memory_order_relaxed);
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			after = sequence.load(std::memory_order_relaxed);
+		} while (((before & 1) != 0) || (before != after));
+
+		if (before == 0) {
+			return false;
+		}
+
+		std::memcpy(&value, value_words, sizeof(T));
+
+		return true;
+	}
+
+private:	// data members should always have private scope
+
+	static const unsigned NUM_WORDS{ (sizeof(T) + sizeof(std::uint32_t) - 1) / sizeof(std::uint32_t) };
+
+	std::atomic<unsigned>      sequence{ 0 };		// odd while a write is in progress, 0 before the first
+	std::atomic<std::uint32_t> words[NUM_WORDS]{};	// the latest value
+};
+
+
+#endif // SEQ_LOCK_H
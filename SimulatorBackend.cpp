@@ -0,0 +1,200 @@
+#include "SimulatorBackend.h"
+#include "DroneSimulatorApi.h"
+#include "SimulatorScene.h"
+#include "SimulatorLink.h"
+#include <iostream>
+
+
+// SimulatorBackend class version 1.4
+
+
+using std::cout;
+using std::endl;
+using std::string;
+
+
+// The SimulatorBackend constructor records where the simulated drone is to be displayed, without
+// creating the simulator. For the headless scene the output name, if not empty, is the image file
+// (such as "mission.png") in which the flight paths are saved at the end of each execution; for
+// fpl-viewer it is the name of the shared memory the viewer is started with, or empty for a name
+// unique to this process.
+
+SimulatorBackend::SimulatorBackend(SimulatorOutput output, const string& output_name) :
+	output(output),
+	output_name(output_name)
+{}
+
+
+// The SimulatorBackend destructor deallocates the simulator or link if one was created.
+
+SimulatorBackend::~SimulatorBackend()
+{
+	delete drone_simulator;
+	delete simulator_link;
+}
+
+
+// Return the name of the backend in profiles.
+
+const char* SimulatorBackend::name() const
+{
+	return "simulator";
+}
+
+
+// Execute a drone command with the drone simulator.
+// A simulator object, or with SimulatorOutput::VIEWER a link to an fpl-viewer process, is created
+// when an "<initialize>" drone command is executed.
+
+void SimulatorBackend::sendCommand(const DroneCommand& command)
+{
+	if (command.kind == DroneCommandKind::INITIALIZE) {
+		initialize();
+		return;
+	}
+
+	if ((drone_simulator == nullptr) && (simulator_link == nullptr)) {
+		cout << "Drone simulator not initialized - <" << formatDroneCommand(command) << "> command skipped" << endl;
+		return;
+	}
+
+	const SimulatorCommand simulator_command{ toSimulatorCommand(command) };
+
+	if (simulator_link != nullptr) {
+		simulator_link->sendCommand(simulator_command);
+	}
+	else {
+		drone_simulator->sendCommand(simulator_command);
+	}
+}
+
+
+// Set where the simulated drone starts on the ground, the origin by default.
+// Only a simulator or link created by a later "<initialize>" drone command starts there.
+
+void SimulatorBackend::setStartPosition(const Coordinate3D& start)
+{
+	start_position = start;
+}
+
+
+// Return whether NOP instructions must wait in real time: only the headless scene follows the
+// mission clock.
+
+bool SimulatorBackend::needsRealTime() const
+{
+	return output != SimulatorOutput::HEADLESS;
+}
+
+
+// Report the outcome of a program execution: any drone commands dropped on their way to the
+// simulator, every drone command that was sent before the simulated drone had finished its previous
+// motion, every time it came too close to another simulated drone and, for the headless scene, the
+// simulated drone's state and optionally an image of the flight paths.
+
+void SimulatorBackend::finishExecution()
+{
+	if ((simulator_link != nullptr) && (simulator_link->droppedCommands() > 0)) {
+		cout << endl << simulator_link->droppedCommands() << " drone simulator commands were dropped because fpl-viewer fell behind"
+			 << endl;
+	}
+
+	if (drone_simulator == nullptr) {
+		return;
+	}
+
+	if (drone_simulator->droppedCommands() > 0) {
+		cout << endl << drone_simulator->droppedCommands()
+			 << " drone simulator commands were dropped because the simulator window fell behind" << endl;
+	}
+
+	drone_simulator->displayMotionReport();
+	drone_simulator->displaySeparationReport();
+
+	if (output != SimulatorOutput::HEADLESS) {
+		return;
+	}
+
+	drone_simulator->displayState();
+
+	if (!output_name.empty() && drone_simulator->saveImage(output_name)) {
+		cout << "Simulated flight path saved in " << output_name << endl;
+	}
+}
+
+
+// Convert a drone command into the simulator's own command, which keeps only what the simulated
+// drone's motion depends on: commands other than the generic FPL drone commands are of type OTHER.
+
+SimulatorCommand SimulatorBackend::toSimulatorCommand(const DroneCommand& command)
+{
+	SimulatorCommand simulator_command;
+
+	switch (command.kind) {
+	case DroneCommandKind::MOVE:
+		simulator_command.type     = SimulatorCommandType::MOVE;
+		simulator_command.offset.x = command.arguments[0];
+		simulator_command.offset.y = command.arguments[1];
+		simulator_command.offset.z = command.arguments[2];
+		simulator_command.value    = command.speed;
+		break;
+	case DroneCommandKind::TAKEOFF:
+		simulator_command.type = SimulatorCommandType::TAKEOFF;
+		break;
+	case DroneCommandKind::LAND:
+		simulator_command.type = SimulatorCommandType::LAND;
+		break;
+	case DroneCommandKind::ARM:
+		simulator_command.type = SimulatorCommandType::ARM;
+		break;
+	case DroneCommandKind::SPEED:
+		simulator_command.type  = SimulatorCommandType::SPEED;
+		simulator_command.value = command.arguments[0];
+		break;
+	default:
+		simulator_command.type = SimulatorCommandType::OTHER;
+		break;
+	}
+
+	simulator_command.instruction = command.instruction;
+	simulator_command.time_ms     = command.time_ms;
+
+	return simulator_command;
+}
+
+
+// Create the simulated drone, or the link to fpl-viewer, unless an earlier execution created it.
+
+void SimulatorBackend::initialize()
+{
+	if ((drone_simulator != nullptr) || (simulator_link != nullptr)) {
+		cout << "The drone simulator is already initialized" << endl;
+	}
+	else if (output == SimulatorOutput::VIEWER) {
+		initializeLink();
+	}
+	else if (output == SimulatorOutput::HEADLESS) {
+		drone_simulator = new DroneSimulator(SimulatorScene::headlessScene(), start_position);
+	}
+	else {
+		drone_simulator = new DroneSimulator(start_position);
+	}
+}
+
+
+// Create the shared memory that carries simulator commands to an fpl-viewer process.
+
+void SimulatorBackend::initializeLink()
+{
+	simulator_link = new SimulatorLink;
+
+	const string link_name{ output_name.empty() ? SimulatorLink::defaultName() : output_name };
+
+	if (simulator_link->create(link_name, start_position)) {
+		cout << "Drone simulator commands are sent to fpl-viewer through " << link_name << endl;
+	}
+	else {
+		delete simulator_link;
+		simulator_link = nullptr;
+	}
+}
@@ -0,0 +1,63 @@
+#ifndef SIMULATOR_BACKEND_H
+#define SIMULATOR_BACKEND_H
+
+
+#include "DroneBackend.h"
+#include "DroneSimulatorApi.h"
+#include <string>
+
+
+// SimulatorBackend class version 1.4
+
+// Sends FPL drone commands to the drone simulator, displayed in this process's window, in the
+// headless scene, or by a separate fpl-viewer process reached through a SimulatorLink.
+// The simulator or link is created when an "<initialize>" drone command is executed.
+// Sending a command only queues it for the rendering thread (or applies it at once in the headless
+// scene), so the simulator never holds up the other backends.
+
+
+// Select where the simulated drone is displayed.
+
+enum class SimulatorOutput { WINDOW, HEADLESS, VIEWER };
+
+
+class SimulatorLink;
+
+
+class SimulatorBackend : public DroneBackend
+{
+public:		// member functions intended to be used by clients of the class
+
+	SimulatorBackend(SimulatorOutput    output = SimulatorOutput::WINDOW,
+	                 const std::string& output_name = "");	// constructor
+	~SimulatorBackend();	// destructor
+
+	SimulatorBackend(const SimulatorBackend&) = delete;
+	SimulatorBackend& operator=(const SimulatorBackend&) = delete;
+
+	const char* name() const override;
+	void        sendCommand(const DroneCommand& command) override;
+	bool        needsRealTime() const override;
+	void        finishExecution() override;
+
+	void setStartPosition(const Coordinate3D& start);
+
+	static SimulatorCommand toSimulatorCommand(const DroneCommand& command);
+
+private:	// member functions not intended to be used by clients of the class
+
+	void initialize();
+	void initializeLink();
+
+private:	// data members should always have private scope
+
+	const SimulatorOutput output;				// where the simulated drone is displayed
+	const std::string     output_name;			// headless image file name or fpl-viewer link name, if any
+	Coordinate3D          start_position;		// where the simulated drone starts
+
+	DroneSimulator* drone_simulator{ nullptr };	// dynamically instantiated drone simulator object
+	SimulatorLink*  simulator_link{ nullptr };	// dynamically instantiated link to fpl-viewer
+};
+
+
+#endif // SIMULATOR_BACKEND_H
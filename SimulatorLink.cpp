@@ -0,0 +1,314 @@
+#include "SimulatorLink.h"
+#include <iostream>
+#include <new>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+// Simulator Link class version 1.1
+
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::to_string;
+
+
+// The SimulatorLink constructor creates a link that is not yet open.
+
+SimulatorLink::SimulatorLink()
+{}
+
+
+// The SimulatorLink destructor closes the link.
+
+SimulatorLink::~SimulatorLink()
+{
+	close();
+}
+
+
+// Create a new shared memory segment with the given name, such as defaultName(), and open the
+// link as its producer of the commands of a simulated drone with the given starting position.
+// Returns false, after writing a message, if the segment cannot be created, including when a
+// segment with that name is still in use.
+
+bool SimulatorLink::create(const string& name, const Coordinate3D& start)
+{
+	close();
+
+	const string system_name{ systemName(name) };
+	void*        memory{ nullptr };
+
+#ifdef _WIN32
+	HANDLE handle{ CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0,
+									  DWORD(sizeof(SimulatorLinkSegment)), system_name.c_str()) };
+	if ((handle != nullptr) && (GetLastError() == ERROR_ALREADY_EXISTS)) {
+		CloseHandle(handle);
+		handle = nullptr;
+	}
+	if (handle != nullptr) {
+		memory = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(SimulatorLinkSegment));
+		if (memory == nullptr) {
+			CloseHandle(handle);
+		}
+		else {
+			mapping = handle;
+		}
+	}
+#else
+	int fd{ shm_open(system_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600) };
+	if ((fd < 0) && (errno == EEXIST)) {
+		// Remove a segment left behind by a process that exited without closing it.
+		SimulatorLink old_link;
+		if (old_link.attach(name, true) && old_link.senderFinished()) {
+			old_link.close();
+			shm_unlink(system_name.c_str());
+			fd = shm_open(system_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		}
+	}
+	if (fd >= 0) {
+		if (ftruncate(fd, sizeof(SimulatorLinkSegment)) == 0) {
+			memory = mmap(nullptr, sizeof(SimulatorLinkSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (memory == MAP_FAILED) {
+				memory = nullptr;
+			}
+		}
+		::close(fd);
+		if (memory == nullptr) {
+			shm_unlink(system_name.c_str());
+		}
+	}
+#endif
+
+	if (memory == nullptr) {
+		cout << "Unable to create the drone simulator shared memory " << name << endl;
+		return false;
+	}
+
+	segment              = new (memory) SimulatorLinkSegment;
+	segment->producer_id = processId();
+	segment->start       = start;
+	segment->signature.store(SimulatorLinkSegment::SIGNATURE, std::memory_order_release);
+	segment_name         = name;
+	is_creator           = true;
+
+	return true;
+}
+
+
+// Open the link as the consumer of an existing shared memory segment created by another process.
+// Returns false if the segment does not exist or is not a drone simulator segment, writing a
+// message unless quiet is true.
+
+bool SimulatorLink::attach(const string& name, bool quiet)
+{
+	close();
+
+	const string system_name{ systemName(name) };
+	void*        memory{ nullptr };
+
+#ifdef _WIN32
+	HANDLE handle{ OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, system_name.c_str()) };
+	if (handle != nullptr) {
+		memory = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(SimulatorLinkSegment));
+		if (memory == nullptr) {
+			CloseHandle(handle);
+		}
+		else {
+			mapping = handle;
+		}
+	}
+#else
+	const int fd{ shm_open(system_name.c_str(), O_RDWR, 0600) };
+	if (fd >= 0) {
+		struct stat status;
+		if ((fstat(fd, &status) == 0) && (status.st_size >= off_t(sizeof(SimulatorLinkSegment)))) {
+			memory = mmap(nullptr, sizeof(SimulatorLinkSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (memory == MAP_FAILED) {
+				memory = nullptr;
+			}
+		}
+		::close(fd);
+	}
+#endif
+
+	if (memory == nullptr) {
+		if (!quiet) {
+			cout << "Unable to open the drone simulator shared memory " << name << endl;
+		}
+		return false;
+	}
+
+	segment      = static_cast<SimulatorLinkSegment*>(memory);
+	segment_name = name;
+	is_creator   = false;
+
+	if ((segment->signature.load(std::memory_order_acquire) != SimulatorLinkSegment::SIGNATURE) ||
+		(segment->version != SimulatorLinkSegment::VERSION)) {
+		if (!quiet) {
+			cout << "Shared memory " << name << " is not a drone simulator link" << endl;
+		}
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+
+// Close the link. The creator marks the segment closed and removes its name, so that no other
+// viewer can attach, but a viewer that is already attached keeps its mapping.
+
+void SimulatorLink::close()
+{
+	if (segment == nullptr) {
+		return;
+	}
+
+	if (is_creator) {
+		segment->closed.store(true, std::memory_order_release);
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(segment);
+	CloseHandle(static_cast<HANDLE>(mapping));
+	mapping = nullptr;
+#else
+	munmap(segment, sizeof(SimulatorLinkSegment));
+	if (is_creator) {
+		shm_unlink(systemName(segment_name).c_str());
+	}
+#endif
+
+	segment    = nullptr;
+	is_creator = false;
+}
+
+
+// Return whether the link is open.
+
+bool SimulatorLink::isOpen() const
+{
+	return segment != nullptr;
+}
+
+
+// Return the name of the segment given to create() or attach().
+
+const string& SimulatorLink::name() const
+{
+	return segment_name;
+}
+
+
+// Append a command to the ring without waiting, returning false if the ring was full and the
+// command was dropped. Only the creator may send commands.
+
+bool SimulatorLink::sendCommand(const SimulatorCommand& command)
+{
+	if (!is_creator) {
+		return false;
+	}
+
+	if (!segment->commands.push(command)) {
+		segment->dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	return true;
+}
+
+
+// Remove the oldest command from the ring, returning false if there was none.
+// Only an attached viewer may receive commands.
+
+bool SimulatorLink::receiveCommand(SimulatorCommand& command)
+{
+	return (segment != nullptr) && !is_creator && segment->commands.pop(command);
+}
+
+
+// Return whether the creator has closed the segment or exited without closing it.
+// Commands may remain in the ring after the creator has finished.
+
+bool SimulatorLink::senderFinished() const
+{
+	return (segment == nullptr) || segment->closed.load(std::memory_order_acquire) ||
+		   !processRunning(segment->producer_id);
+}
+
+
+// Return the starting position of the simulated drone given by the creator.
+
+Coordinate3D SimulatorLink::startPosition() const
+{
+	return (segment == nullptr) ? Coordinate3D() : segment->start;
+}
+
+
+// Return the number of commands dropped because the ring was full.
+
+unsigned long long SimulatorLink::droppedCommands() const
+{
+	return (segment == nullptr) ? 0 : segment->dropped.load(std::memory_order_relaxed);
+}
+
+
+// Returns a segment name that is unique to this process, such as "fpl-simulator-1234".
+
+string SimulatorLink::defaultName()
+{
+	return "fpl-simulator-" + to_string(processId());
+}
+
+
+// Returns the operating system's name for a segment: POSIX shared memory names start with a '/'.
+
+string SimulatorLink::systemName(const string& name)
+{
+#ifdef _WIN32
+	return "Local\\" + name;
+#else
+	return ((!name.empty()) && (name[0] == '/')) ? name : "/" + name;
+#endif
+}
+
+
+// Returns the ID of this process.
+
+long long SimulatorLink::processId()
+{
+#ifdef _WIN32
+	return GetCurrentProcessId();
+#else
+	return getpid();
+#endif
+}
+
+
+// Return whether a process is still running.
+
+bool SimulatorLink::processRunning(long long process_id)
+{
+#ifdef _WIN32
+	HANDLE process{ OpenProcess(SYNCHRONIZE, FALSE, DWORD(process_id)) };
+	if (process == nullptr) {
+		return false;
+	}
+	const bool running{ WaitForSingleObject(process, 0) == WAIT_TIMEOUT };
+	CloseHandle(process);
+	return running;
+#else
+	return (kill(pid_t(process_id), 0) == 0) || (errno == EPERM);
+#endif
+}
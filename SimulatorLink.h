@@ -0,0 +1,88 @@
+#ifndef SIMULATOR_LINK_H
+#define SIMULATOR_LINK_H
+
+
+#include "DroneSimulatorApi.h"
+#include "SpscRing.h"
+#include <atomic>
+#include <string>
+#include <type_traits>
+
+
+// Simulator Link class version 1.1
+
+// Carries drone simulator commands from a process executing an FPL program to a separate viewer
+// process (see fpl-viewer.cpp) through a named shared memory segment, so that a slow or crashed
+// viewer cannot hold up or end the mission.
+// The executing process creates the segment and is its only producer; one viewer attaches to it
+// and is its only consumer. Commands pass through a lock-free ring inside the segment, and a
+// command that finds the ring full is counted and dropped rather than waited for, so sending a
+// command never blocks. The segment is removed when its creator closes it, although an attached
+// viewer can still take the commands remaining in the ring. The segment also holds the simulated
+// drone's starting position, so the viewer can place the drone where the sender expects it.
+// POSIX shared memory (shm_open) is used, or a named file mapping on Windows.
+
+
+// The contents of the shared memory segment.
+
+struct SimulatorLinkSegment
+{
+	static const unsigned SIGNATURE{ 0x534c5046 };	// "FPLS" in little-endian order
+	static const unsigned VERSION{ 3 };
+
+	std::atomic<unsigned>           signature{ 0 };		// SIGNATURE once the segment is ready
+	unsigned                        version{ VERSION };	// layout version
+	long long                       producer_id{ 0 };	// process ID of the creator
+	std::atomic<bool>               closed{ false };	// the creator has finished sending
+	std::atomic<unsigned long long> dropped{ 0 };		// commands dropped because the ring was full
+	Coordinate3D                    start;				// where the simulated drone starts
+	SpscRing<SimulatorCommand, 4096> commands;			// commands not yet taken by the viewer
+};
+
+static_assert(std::is_trivially_copyable<SimulatorCommand>::value,
+			  "SimulatorCommand must be trivially copyable to pass through shared memory");
+static_assert((ATOMIC_BOOL_LOCK_FREE == 2) && (ATOMIC_INT_LOCK_FREE == 2) && (ATOMIC_LLONG_LOCK_FREE == 2),
+			  "Atomics in shared memory must be lock-free to work between processes");
+
+
+class SimulatorLink
+{
+public:		// member functions intended to be used by clients of the class
+
+	SimulatorLink();		// constructor
+	~SimulatorLink();		// destructor
+
+	SimulatorLink(const SimulatorLink&) = delete;
+	SimulatorLink& operator=(const SimulatorLink&) = delete;
+
+	bool create(const std::string& name, const Coordinate3D& start = Coordinate3D());
+	bool attach(const std::string& name, bool quiet = false);
+	void close();
+
+	bool               isOpen() const;
+	const std::string& name() const;
+
+	bool               sendCommand(const SimulatorCommand& command);
+	bool               receiveCommand(SimulatorCommand& command);
+	bool               senderFinished() const;
+	Coordinate3D       startPosition() const;
+	unsigned long long droppedCommands() const;
+
+	static std::string defaultName();
+
+private:	// member functions not intended to be used by clients of the class
+
+	static std::string systemName(const std::string& name);
+	static long long   processId();
+	static bool        processRunning(long long process_id);
+
+private:	// data members should always have private scope
+
+	std::string           segment_name;			// the name given to create() or attach()
+	SimulatorLinkSegment* segment{ nullptr };	// the mapped segment, or nullptr if not open
+	void*                 mapping{ nullptr };	// the file mapping handle on Windows
+	bool                  is_creator{ false };	// whether this process created the segment
+};
+
+
+#endif // SIMULATOR_LINK_H
@@ -0,0 +1,1015 @@
+#include "SimulatorScene.h"
+#include "FlightPath.h"
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+
+
+using std::cout;
+using std::endl;
+using std::lock_guard;
+using std::make_shared;
+using std::make_unique;
+using std::max;
+using std::min;
+using std::mutex;
+using std::shared_ptr;
+using std::size_t;
+using std::stable_sort;
+using std::string;
+using std::thread;
+using std::to_string;
+using std::vector;
+
+
+// Simulator Scene class version 1.10
+
+
+// Path and waypoint colours given to drones in order of creation.
+// The first drone keeps the original black path with blue waypoints.
+
+static const sf::Color path_colours[]{ sf::Color::Black, sf::Color::Blue, sf::Color::Magenta,
+									   sf::Color::Yellow, sf::Color::Cyan, sf::Color::White };
+static const sf::Color waypoint_colours[]{ sf::Color::Blue, sf::Color::Blue, sf::Color::Magenta,
+										   sf::Color::Yellow, sf::Color::Cyan, sf::Color::White };
+static const int num_colours{ 6 };
+
+
+// The pan and zoom state of the window's view of the drones, controlled with the mouse and keyboard.
+
+struct ViewControl
+{
+	sf::View     view;						// the part of the drone coordinate space displayed
+	float        units_per_pixel{ 1.0f };	// the current zoom
+	bool         dragging{ false };			// whether the view is being dragged with the mouse
+	sf::Vector2i drag_pixel;				// the mouse position when the view was last dragged
+};
+
+
+// Zoom the view by a factor, keeping the drone coordinates under the given window pixel fixed.
+
+static void zoomView(ViewControl& control, const sf::RenderWindow& window, const sf::Vector2i& pixel, float factor)
+{
+	const float MIN_UNITS_PER_PIXEL{ 1.0f / 16.0f };
+	const float MAX_UNITS_PER_PIXEL{ 65536.0f };
+
+	factor = min(max(factor, MIN_UNITS_PER_PIXEL / control.units_per_pixel), MAX_UNITS_PER_PIXEL / control.units_per_pixel);
+
+	const sf::Vector2f before{ window.mapPixelToCoords(pixel, control.view) };
+	control.view.zoom(factor);
+	control.units_per_pixel *= factor;
+	const sf::Vector2f after{ window.mapPixelToCoords(pixel, control.view) };
+	control.view.move(before - after);
+}
+
+
+// Update the view from a window event and return whether the view changed:
+// The mouse wheel zooms about the mouse position and dragging with the left button pans.
+// The arrow keys pan, the + and - keys zoom about the centre of the window, and Home restores
+// the original view.
+
+static bool controlView(const sf::Event& event, const sf::RenderWindow& window, ViewControl& control,
+						sf::View& overlay_view)
+{
+	const sf::Vector2u  window_size{ window.getSize() };
+	const sf::Vector2i  centre_pixel(int(window_size.x / 2), int(window_size.y / 2));
+	const sf::Vector2f& view_size{ control.view.getSize() };
+
+	switch (event.type) {
+	case sf::Event::Resized:
+		control.view.setSize(event.size.width * control.units_per_pixel, event.size.height * control.units_per_pixel);
+		overlay_view.reset(sf::FloatRect(0.0f, 0.0f, float(event.size.width), float(event.size.height)));
+		return true;
+	case sf::Event::MouseWheelScrolled:
+		if (event.mouseWheelScroll.wheel != sf::Mouse::VerticalWheel) {
+			return false;
+		}
+		zoomView(control, window, sf::Vector2i(event.mouseWheelScroll.x, event.mouseWheelScroll.y),
+				 std::pow(1.25f, -event.mouseWheelScroll.delta));
+		return true;
+	case sf::Event::MouseButtonPressed:
+		if (event.mouseButton.button == sf::Mouse::Left) {
+			control.dragging   = true;
+			control.drag_pixel = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+		}
+		return false;
+	case sf::Event::MouseButtonReleased:
+		if (event.mouseButton.button == sf::Mouse::Left) {
+			control.dragging = false;
+		}
+		return false;
+	case sf::Event::MouseMoved:
+		if (!control.dragging) {
+			return false;
+		}
+		control.view.move(float(control.drag_pixel.x - event.mouseMove.x) * control.units_per_pixel,
+						  float(control.drag_pixel.y - event.mouseMove.y) * control.units_per_pixel);
+		control.drag_pixel = sf::Vector2i(event.mouseMove.x, event.mouseMove.y);
+		return true;
+	case sf::Event::KeyPressed:
+		switch (event.key.code) {
+		case sf::Keyboard::Left:
+			control.view.move(-view_size.x / 10.0f, 0.0f);
+			return true;
+		case sf::Keyboard::Right:
+			control.view.move(view_size.x / 10.0f, 0.0f);
+			return true;
+		case sf::Keyboard::Up:
+			control.view.move(0.0f, -view_size.y / 10.0f);
+			return true;
+		case sf::Keyboard::Down:
+			control.view.move(0.0f, view_size.y / 10.0f);
+			return true;
+		case sf::Keyboard::Add:
+		case sf::Keyboard::Equal:
+			zoomView(control, window, centre_pixel, 0.8f);
+			return true;
+		case sf::Keyboard::Subtract:
+		case sf::Keyboard::Hyphen:
+			zoomView(control, window, centre_pixel, 1.25f);
+			return true;
+		case sf::Keyboard::Home:
+			control.view.reset(sf::FloatRect(0.0f, 0.0f, float(window_size.x), float(window_size.y)));
+			control.units_per_pixel = 1.0f;
+			return true;
+		default:
+			return false;
+		}
+	default:
+		return false;
+	}
+}
+
+
+// A drone command sent to the headless scene and the scene time at which it is applied.
+
+struct TimedCommand
+{
+	long long        time_ms{ 0 };		// scene time
+	SimulatorCommand command;			// the command, with the mission time at which it was sent
+};
+
+
+// The rendering thread's own record of a drone's flight, updated from the drone's commands.
+// The headless scene also keeps every command sent, so that they can be applied again after the
+// model has been rewound.
+
+struct SimulatorScene::DroneView
+{
+	shared_ptr<SimulatorDrone> drone;										// the drone being displayed
+	bool                       airborne{ false };							// between takeoff and land
+	long long                  num_commands{ 0 };							// commands applied
+	long long                  time_offset_ms{ 0 };							// from mission to model time (headless)
+	int                        motion_instruction{ -1 };					// FPL instruction of the current motion
+	int                        motion_reports_made{ 0 };					// motion reports since the model started
+	std::unique_ptr<FlightPath> flight_path;								// the drone's flight path graphics
+	vector<TimedCommand>       history;										// every command sent (headless)
+	size_t                     num_applied{ 0 };							// commands in history applied
+};
+
+
+// Returns the scene shared by every DroneSimulator in the process, creating it and its rendering
+// thread when first called.
+// The scene is never destroyed because its detached rendering thread runs until the window is
+// closed or the process exits. Once the rendering thread has exited, the next drone added to the
+// scene starts a new one with a new window.
+
+SimulatorScene& SimulatorScene::sharedScene()
+{
+	static SimulatorScene* const scene{ new SimulatorScene(false) };
+
+	return *scene;
+}
+
+
+// Returns the headless scene shared by every DroneSimulator created with it, creating it when first
+// called.
+
+SimulatorScene& SimulatorScene::headlessScene()
+{
+	static SimulatorScene* const scene{ new SimulatorScene(true) };
+
+	return *scene;
+}
+
+
+// The SimulatorScene constructor creates the rendering thread, unless the scene is headless.
+
+SimulatorScene::SimulatorScene(bool headless) :
+	is_headless(headless),
+	epoch(std::chrono::steady_clock::now())
+{
+	if (!is_headless) {
+		startRenderingThread();
+	}
+}
+
+
+// The SimulatorScene destructor is defined here, where DroneView is a complete type.
+
+SimulatorScene::~SimulatorScene() = default;
+
+
+// Add a drone on the ground at a starting position to the scene and return the part of it shared
+// with the rendering thread.
+// The rendering thread starts displaying the drone at its next frame. If the rendering thread has
+// exited, because its window was closed or the font file could not be loaded, a new rendering
+// thread is started, which displays every drone in the scene.
+
+shared_ptr<SimulatorDrone> SimulatorScene::addDrone(const Coordinate3D& start)
+{
+	const shared_ptr<SimulatorDrone> drone{ make_shared<SimulatorDrone>() };
+
+	drone->start   = start;
+	drone->start.z = 0;
+
+	lock_guard<mutex> lock(drones_mutex);
+
+	num_drones++;
+	drone->number = num_drones;
+
+	if (is_headless) {
+		views.push_back(makeView(drone));
+	}
+	else {
+		new_drones.push_back(drone);
+		drones_added.store(true, std::memory_order_release);
+		if (!is_rendering.load(std::memory_order_acquire)) {
+			startRenderingThread();
+		}
+		wake();
+	}
+
+	return drone;
+}
+
+
+// Return whether the scene has no window.
+
+bool SimulatorScene::headless() const
+{
+	return is_headless;
+}
+
+
+// Return whether the rendering thread is still taking drone commands.
+// The headless scene always takes drone commands.
+
+bool SimulatorScene::rendering() const
+{
+	return is_headless || is_rendering.load(std::memory_order_acquire);
+}
+
+
+// Wake the rendering thread if it is idle.
+// Called after each drone command is queued; the condition variable is only notified for the
+// first command since the rendering thread last went idle.
+
+void SimulatorScene::wake()
+{
+	if (!wake_pending.exchange(true, std::memory_order_acq_rel)) {
+		wake_condition.notify_one();
+	}
+}
+
+
+// Set the maximum number of frames drawn per second, or 0 for no limit.
+// The default limit is 60 frames per second.
+
+void SimulatorScene::setFrameRateLimit(unsigned frames_per_second)
+{
+	frame_rate_limit.store(frames_per_second);
+	frame_settings_changed.store(true, std::memory_order_release);
+	wake();
+}
+
+
+// Set whether frames are synchronized with the display's vertical refresh, which is off by default.
+
+void SimulatorScene::setVerticalSync(bool enabled)
+{
+	vertical_sync.store(enabled);
+	frame_settings_changed.store(true, std::memory_order_release);
+	wake();
+}
+
+
+// Set the minimum separation between airborne drones in centimetres, or 0 to stop checking it.
+// The default minimum separation is DEFAULT_SEPARATION.
+
+void SimulatorScene::setMinimumSeparation(int centimetres)
+{
+	minimum_separation.store(centimetres);
+	separation_changed.store(true, std::memory_order_release);
+}
+
+
+// Return the number of milliseconds since the scene was created, or the time last set with
+// setClock(), the time given to drone commands sent to the windowed scene.
+
+long long SimulatorScene::milliseconds() const
+{
+	const long long driven_ms{ clock_ms.load(std::memory_order_acquire) };
+
+	if (driven_ms >= 0) {
+		return driven_ms;
+	}
+
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+
+// Drive the windowed scene's clock from now on, instead of following real time, so that the drones
+// fly according to another clock, such as the mission time of a replay (in ms). Drone commands then
+// keep the times they were sent with. The clock may be set back, such as when a replay seeks
+// backwards, and the drones stay where they are until later commands move them.
+
+void SimulatorScene::setClock(long long time_ms)
+{
+	clock_ms.store(max(time_ms, 0LL), std::memory_order_release);
+	wake();
+}
+
+
+// Return whether the scene's clock is driven by setClock() rather than following real time.
+
+bool SimulatorScene::clockDriven() const
+{
+	return clock_ms.load(std::memory_order_acquire) >= 0;
+}
+
+
+// Record a drone command sent to a drone in the headless scene, to be applied when the state of
+// the drones is next needed.
+// The command's mission time is its scene time, except that when a drone's mission clock starts
+// again, because its program is executed again, the new execution starts once the drone has
+// finished the motions of the previous one.
+
+void SimulatorScene::executeCommand(const SimulatorDrone& drone, const SimulatorCommand& command)
+{
+	lock_guard<mutex> lock(drones_mutex);
+
+	const int  d{ drone.number - 1 };
+	DroneView& view{ views[d] };
+	long long  offset_ms{ 0 };
+
+	if (!view.history.empty()) {
+		const TimedCommand& last{ view.history.back() };
+		offset_ms = last.time_ms - last.command.time_ms;
+		if (command.time_ms < last.command.time_ms) {
+			simulate();
+			while (model.moving(d)) {
+				stepModel();
+			}
+			offset_ms = max(std::llround(model.time() * 1000.0), last.time_ms) - command.time_ms;
+		}
+	}
+
+	view.history.push_back({ command.time_ms + offset_ms, command });
+}
+
+
+// Display the state of a drone in the headless scene once every drone has finished its motion.
+
+void SimulatorScene::displayDrone(const SimulatorDrone& drone)
+{
+	lock_guard<mutex> lock(drones_mutex);
+
+	if (!is_headless) {
+		cout << "The state of a drone is only available in the headless drone simulator" << endl;
+		return;
+	}
+
+	simulate();
+
+	while (anyDroneMoving()) {
+		stepModel();
+	}
+
+	const int          d{ drone.number - 1 };
+	const DroneView&   view{ views[d] };
+	const Coordinate3D position{ view.flight_path->position() };
+
+	cout << endl << "Simulated drone " << drone.number << ": position (" << position.x << ", " << position.y
+		 << ", " << std::lround(model.z(d)) << "), " << (view.airborne ? "airborne" : "landed") << " after "
+		 << view.num_commands << " commands" << endl;
+}
+
+
+// Display every move, takeoff or land command sent to a drone before the drone had finished its
+// previous motion, with the FPL instruction that sent it when known, since the drone's report
+// was last displayed. Only the first MAX_REPORT_LINES are listed.
+
+void SimulatorScene::displayMotionReport(const SimulatorDrone& drone)
+{
+	const char* const command_names[]{ "move", "takeoff", "land", "arm", "speed", "reset", "command" };
+
+	if (is_headless) {
+		lock_guard<mutex> lock(drones_mutex);
+		simulate();
+	}
+
+	lock_guard<mutex> lock(reports_mutex);
+
+	int num_reports{ 0 };
+
+	for (const MotionReport& report : motion_reports) {
+		if (report.drone != drone.number) {
+			continue;
+		}
+		if (num_reports == 0) {
+			cout << endl << "Simulated drone " << drone.number
+				 << " commands sent before the previous motion finished: [time | location | command | distance left]"
+				 << endl << endl;
+		}
+		num_reports++;
+		if (num_reports > MAX_REPORT_LINES) {
+			continue;
+		}
+		cout << std::right << std::setw(10) << report.time_ms << " ms  ";
+		if (report.instruction >= 0) {
+			cout << std::setw(6) << report.instruction << "  ";
+		}
+		else {
+			cout << std::setw(6) << "-" << "  ";
+		}
+		cout << std::left << std::setw(8) << command_names[static_cast<int>(report.type)] << std::right
+			 << std::fixed << std::setprecision(1) << report.remaining << " cm" << std::defaultfloat << endl;
+	}
+
+	if (num_reports == 0) {
+		cout << endl << "Simulated drone " << drone.number << " finished every motion before its next command" << endl;
+	}
+	else if (num_reports > MAX_REPORT_LINES) {
+		cout << "    and " << (num_reports - MAX_REPORT_LINES) << " more" << endl;
+	}
+
+	if (shown_motion_reports.size() < size_t(drone.number)) {
+		shown_motion_reports.resize(drone.number, 0);
+	}
+	shown_motion_reports[drone.number - 1] += num_reports;
+
+	motion_reports.erase(std::remove_if(motion_reports.begin(), motion_reports.end(),
+										[&drone](const MotionReport& report) { return report.drone == drone.number; }),
+						 motion_reports.end());
+}
+
+
+// Display every time the drone came closer to another airborne drone than the minimum separation,
+// since the drone's report was last displayed, with the FPL instructions that sent both drones on
+// their motions when known. Times are in each drone's own mission time in the headless scene.
+// Only the first MAX_REPORT_LINES are listed.
+
+void SimulatorScene::displaySeparationReport(const SimulatorDrone& drone)
+{
+	if (is_headless) {
+		lock_guard<mutex> lock(drones_mutex);
+		simulate();
+	}
+
+	lock_guard<mutex> lock(reports_mutex);
+
+	int num_reports{ 0 };
+
+	for (SeparationReport& report : separation_reports) {
+		const bool is_a{ report.drone_a == drone.number };
+		if ((!is_a && (report.drone_b != drone.number)) || (is_a ? report.shown_a : report.shown_b)) {
+			continue;
+		}
+		if (num_reports == 0) {
+			cout << endl << "Simulated drone " << drone.number
+				 << " came too close to other drones: [time | location | other drone | its location | distance]"
+				 << endl << endl;
+		}
+		num_reports++;
+		(is_a ? report.shown_a : report.shown_b) = true;
+		shown_separations.insert(is_a ? std::make_tuple(report.drone_a, report.time_ms_a, report.drone_b)
+									  : std::make_tuple(report.drone_b, report.time_ms_b, report.drone_a));
+		if (num_reports > MAX_REPORT_LINES) {
+			continue;
+		}
+		const int other_instruction{ is_a ? report.instruction_b : report.instruction_a };
+		cout << std::right << std::setw(10) << (is_a ? report.time_ms_a : report.time_ms_b) << " ms  "
+			 << std::setw(6) << (is_a ? report.instruction_a : report.instruction_b) << "  drone "
+			 << std::left << std::setw(4) << (is_a ? report.drone_b : report.drone_a) << std::right
+			 << std::setw(6) << other_instruction << "  " << std::fixed << std::setprecision(1)
+			 << report.distance << " cm" << std::defaultfloat << endl;
+	}
+
+	if (num_reports > MAX_REPORT_LINES) {
+		cout << "    and " << (num_reports - MAX_REPORT_LINES) << " more" << endl;
+	}
+
+	separation_reports.erase(std::remove_if(separation_reports.begin(), separation_reports.end(),
+											[](const SeparationReport& report) { return report.shown_a && report.shown_b; }),
+							 separation_reports.end());
+}
+
+
+// Draw the flight paths of every drone in the headless scene off screen, at one pixel per unit
+// unless that would exceed MAX_IMAGE_SIZE pixels, and save the image to a file whose format is
+// given by its extension (such as .png).
+// Returns false, after writing a message, if the image cannot be drawn or saved.
+
+bool SimulatorScene::saveImage(const string& file_name)
+{
+	const float MAX_IMAGE_SIZE{ 4096.0f };
+	const float MARGIN{ 20.0f };
+
+	lock_guard<mutex> lock(drones_mutex);
+
+	if (!is_headless || views.empty()) {
+		cout << "Only the flight paths of the headless drone simulator can be saved as an image" << endl;
+		return false;
+	}
+
+	simulate();
+
+	sf::FloatRect bounds{ views[0].flight_path->bounds() };
+
+	for (const DroneView& view : views) {
+		const sf::FloatRect path_bounds{ view.flight_path->bounds() };
+		const float         right{ max(bounds.left + bounds.width, path_bounds.left + path_bounds.width) };
+		const float         bottom{ max(bounds.top + bounds.height, path_bounds.top + path_bounds.height) };
+		bounds.left   = min(bounds.left, path_bounds.left);
+		bounds.top    = min(bounds.top, path_bounds.top);
+		bounds.width  = right - bounds.left;
+		bounds.height = bottom - bounds.top;
+	}
+
+	const sf::FloatRect area(bounds.left - MARGIN, bounds.top - MARGIN, bounds.width + 2.0f * MARGIN,
+							 bounds.height + 2.0f * MARGIN);
+	const float         units_per_pixel{ max(1.0f, max(area.width, area.height) / MAX_IMAGE_SIZE) };
+
+	sf::RenderTexture image;
+
+	if (!image.create(unsigned(std::ceil(area.width / units_per_pixel)), unsigned(std::ceil(area.height / units_per_pixel)))) {
+		cout << "Unable to draw the drone simulator image" << endl;
+		return false;
+	}
+
+	const sf::Texture marker_texture{ FlightPath::createMarkerTexture() };
+
+	image.setView(sf::View(area));
+	image.clear(sf::Color::Green);
+	for (DroneView& view : views) {
+		view.flight_path->draw(image, marker_texture);
+	}
+	drawDrones(image, marker_texture);
+	image.display();
+
+	if (!image.getTexture().copyToImage().saveToFile(file_name)) {
+		cout << "Unable to write image file " << file_name << endl;
+		return false;
+	}
+
+	return true;
+}
+
+
+// Create the record of a drone's flight, giving it the colours for its drone number, and add the
+// drone to the kinematic model at its starting position.
+
+SimulatorScene::DroneView SimulatorScene::makeView(const shared_ptr<SimulatorDrone>& drone)
+{
+	DroneView view;
+	view.drone       = drone;
+	view.flight_path = makeFlightPath(*drone);
+
+	model.addDrone(float(drone->start.x), float(drone->start.y), 0.0f);
+	airborne_drones.push_back(0);
+
+	return view;
+}
+
+
+// Create an empty flight path from a drone's starting position in the colours for its number.
+
+std::unique_ptr<FlightPath> SimulatorScene::makeFlightPath(const SimulatorDrone& drone)
+{
+	const int colour{ (drone.number - 1) % num_colours };
+
+	return make_unique<FlightPath>(sf::Vector2f(WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f),
+								   path_colours[colour], waypoint_colours[colour], drone.start);
+}
+
+
+// Update the record of a drone's flight with a drone command sent at a scene time (in ms).
+// The kinematic model is first advanced to that time, and a command that starts a new motion
+// before the previous one has finished is recorded in motion_reports, unless it was displayed
+// before the model was rewound.
+// An instant command puts the drone at the end of its motion at once and is never reported, and a
+// RESET command returns the drone to the ground at its starting position with an empty flight path.
+
+void SimulatorScene::applyCommand(DroneView& view, const SimulatorCommand& command, long long time_ms)
+{
+	const int d{ view.drone->number - 1 };
+
+	advanceModel(time_ms);
+
+	view.num_commands++;
+
+	const bool starts_motion{ (command.type == SimulatorCommandType::MOVE) ||
+							  (command.type == SimulatorCommandType::TAKEOFF) ||
+							  (command.type == SimulatorCommandType::LAND) };
+
+	if (starts_motion && !command.instant && model.moving(d)) {
+		view.motion_reports_made++;
+		lock_guard<mutex> lock(reports_mutex);
+		if ((size_t(d) >= shown_motion_reports.size()) || (view.motion_reports_made > shown_motion_reports[d])) {
+			motion_reports.push_back({ view.drone->number, command.time_ms, command.instruction, command.type,
+									   model.remainingDistance(d) });
+		}
+	}
+
+	if (starts_motion) {
+		view.motion_instruction = command.instruction;
+	}
+
+	switch (command.type) {
+	case SimulatorCommandType::MOVE:
+		view.flight_path->addMove(command.offset);
+		model.moveBy(d, float(command.offset.x), float(command.offset.y), float(command.offset.z), float(command.value));
+		break;
+	case SimulatorCommandType::TAKEOFF:
+		view.airborne = true;
+		model.moveTo(d, model.x(d), model.y(d), float(TAKEOFF_ALTITUDE), float(VERTICAL_SPEED));
+		break;
+	case SimulatorCommandType::LAND:
+		view.airborne = false;
+		model.moveTo(d, model.x(d), model.y(d), 0.0f, float(VERTICAL_SPEED));
+		break;
+	case SimulatorCommandType::ARM:
+		model.setCruiseSpeed(d, float(ARM_SPEED));
+		break;
+	case SimulatorCommandType::SPEED:
+		model.setCruiseSpeed(d, float(command.value));
+		break;
+	case SimulatorCommandType::RESET:
+		view.flight_path        = makeFlightPath(*view.drone);
+		view.airborne           = false;
+		view.motion_instruction = -1;
+		model.moveTo(d, float(view.drone->start.x), float(view.drone->start.y), 0.0f, KinematicModel::DEFAULT_SPEED);
+		model.setCruiseSpeed(d, KinematicModel::DEFAULT_SPEED);
+		model.finishMotion(d);
+		break;
+	default:
+		break;
+	}
+
+	if (command.instant) {
+		model.finishMotion(d);
+	}
+}
+
+
+// Take every drone command received since the previous frame and apply them in the order they were
+// sent, returning whether there were any.
+// Each drone's commands arrive in order, so a stable sort by time keeps them in that order.
+
+bool SimulatorScene::applyCommands()
+{
+	vector<std::pair<size_t, SimulatorCommand>> received;
+
+	for (size_t v{ 0 }; v < views.size(); v++) {
+		SimulatorCommand command;
+		while (views[v].drone->commands.pop(command)) {
+			received.emplace_back(v, command);
+		}
+	}
+
+	stable_sort(received.begin(), received.end(),
+				[](const std::pair<size_t, SimulatorCommand>& a, const std::pair<size_t, SimulatorCommand>& b)
+				{ return a.second.time_ms < b.second.time_ms; });
+
+	for (const std::pair<size_t, SimulatorCommand>& command : received) {
+		applyCommand(views[command.first], command.second, command.second.time_ms);
+	}
+
+	return !received.empty();
+}
+
+
+// Apply every command recorded by the headless scene but not yet applied, in order of scene time.
+// If any of them is for a time the model has already passed, such as the commands of a program
+// executed after the others, the model is first rewound and every command is applied again.
+
+void SimulatorScene::simulate()
+{
+	const long long reached_ms{ max(applied_ms, std::llround(model.time() * 1000.0)) };
+
+	for (const DroneView& view : views) {
+		if ((view.num_applied < view.history.size()) && (view.history[view.num_applied].time_ms < reached_ms)) {
+			rewindModel();
+			break;
+		}
+	}
+
+	// The scene time, view index and history index of each command.
+	vector<std::tuple<long long, size_t, size_t>> pending;
+
+	for (size_t v{ 0 }; v < views.size(); v++) {
+		for (size_t i{ views[v].num_applied }; i < views[v].history.size(); i++) {
+			pending.emplace_back(views[v].history[i].time_ms, v, i);
+		}
+		views[v].num_applied = views[v].history.size();
+	}
+
+	std::sort(pending.begin(), pending.end());
+
+	for (const std::tuple<long long, size_t, size_t>& entry : pending) {
+		DroneView&          view{ views[std::get<1>(entry)] };
+		const TimedCommand& timed{ view.history[std::get<2>(entry)] };
+		view.time_offset_ms = timed.time_ms - timed.command.time_ms;
+		applyCommand(view, timed.command, timed.time_ms);
+		applied_ms = timed.time_ms;
+	}
+}
+
+
+// Return the headless scene's model to time 0, with every drone on the ground at its starting
+// position and an empty flight path, so that every recorded command can be applied again.
+// The reports are recorded again as the commands are applied, except those already displayed.
+
+void SimulatorScene::rewindModel()
+{
+	model              = KinematicModel();
+	separation_monitor = SeparationMonitor();
+	separation_changed.store(true, std::memory_order_release);
+	applied_ms         = 0;
+
+	for (DroneView& view : views) {
+		view.airborne            = false;
+		view.num_commands        = 0;
+		view.time_offset_ms      = 0;
+		view.motion_instruction  = -1;
+		view.motion_reports_made = 0;
+		view.flight_path         = makeFlightPath(*view.drone);
+		view.num_applied         = 0;
+		model.addDrone(float(view.drone->start.x), float(view.drone->start.y), 0.0f);
+	}
+
+	lock_guard<mutex> lock(reports_mutex);
+
+	motion_reports.clear();
+	separation_reports.clear();
+}
+
+
+// Advance the kinematic model to a scene time in milliseconds, in whole steps.
+
+void SimulatorScene::advanceModel(long long time_ms)
+{
+	const double time{ time_ms / 1000.0 };
+
+	while (model.time() + KinematicModel::STEP <= time) {
+		stepModel();
+	}
+}
+
+
+// Advance the kinematic model by one step and record every pair of drones that has just come
+// closer together than the minimum separation, unless it was displayed before the model was
+// rewound.
+// A drone is checked from takeoff until it has landed, and in the headless scene only until the
+// motion started by its last command has finished.
+
+void SimulatorScene::stepModel()
+{
+	model.step();
+
+	if (separation_changed.exchange(false, std::memory_order_acq_rel)) {
+		separation_monitor.setMinimumSeparation(float(minimum_separation.load()));
+	}
+
+	const int num_drones{ model.numDrones() };
+
+	if (num_drones < 2) {
+		return;
+	}
+
+	const long long time_ms{ std::llround(model.time() * 1000.0) };
+
+	for (int d{ 0 }; d < num_drones; d++) {
+		const DroneView& view{ views[d] };
+		const bool       in_mission{ !is_headless || model.moving(d) ||
+									 (!view.history.empty() && (time_ms <= view.history.back().time_ms)) };
+		airborne_drones[d] = ((view.airborne || model.moving(d)) && in_mission) ? 1 : 0;
+	}
+
+	violations.clear();
+	separation_monitor.check(model, airborne_drones, violations);
+
+	if (violations.empty()) {
+		return;
+	}
+
+	lock_guard<mutex> lock(reports_mutex);
+
+	for (const SeparationMonitor::Violation& violation : violations) {
+		const DroneView& view_a{ views[violation.drone_a] };
+		const DroneView& view_b{ views[violation.drone_b] };
+		SeparationReport report;
+		report.time_ms_a     = time_ms - view_a.time_offset_ms;
+		report.time_ms_b     = time_ms - view_b.time_offset_ms;
+		report.drone_a       = view_a.drone->number;
+		report.drone_b       = view_b.drone->number;
+		report.instruction_a = view_a.motion_instruction;
+		report.instruction_b = view_b.motion_instruction;
+		report.distance      = violation.distance;
+		report.shown_a       = shown_separations.count(std::make_tuple(report.drone_a, report.time_ms_a, report.drone_b)) > 0;
+		report.shown_b       = shown_separations.count(std::make_tuple(report.drone_b, report.time_ms_b, report.drone_a)) > 0;
+		if (!report.shown_a || !report.shown_b) {
+			separation_reports.push_back(report);
+		}
+	}
+}
+
+
+// Return whether any drone has not finished its motion.
+
+bool SimulatorScene::anyDroneMoving() const
+{
+	for (int d{ 0 }; d < model.numDrones(); d++) {
+		if (model.moving(d)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+// Draw a marker at the current position of each drone in the kinematic model, in one batch.
+
+void SimulatorScene::drawDrones(sf::RenderTarget& target, const sf::Texture& marker_texture) const
+{
+	const sf::Vector2f origin(WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT / 2.0f);
+
+	vector<sf::Vertex> markers;
+
+	for (int d{ 0 }; d < model.numDrones(); d++) {
+		FlightPath::appendMarker(markers, sf::Vector2f(origin.x + model.x(d), origin.y - model.y(d)), sf::Color::Red);
+	}
+
+	if (!markers.empty()) {
+		target.draw(markers.data(), markers.size(), sf::Triangles, sf::RenderStates(&marker_texture));
+	}
+}
+
+
+// Start the rendering thread and allow it to execute independently.
+// The frame settings are given to the rendering thread's new window.
+
+void SimulatorScene::startRenderingThread()
+{
+	is_rendering.store(true, std::memory_order_release);
+	frame_settings_changed.store(true, std::memory_order_release);
+
+	thread rendering_thread(&SimulatorScene::renderingThread, this);
+
+	// Detach the rendering thread so it runs concurrently with the main thread.
+	rendering_thread.detach();
+}
+
+
+// The window drawing thread that runs concurrently with the main thread.
+// However the thread will immediately exit if the font file is not found in the source code directory.
+// See https://www.sfml-dev.org for a description of the SFML API.
+
+void SimulatorScene::renderingThread()
+{
+	const string font_file_name{ "arial.ttf" };
+
+	// Every SFML resource is released before the thread reports that it has exited, so that a new
+	// rendering thread may be started at once.
+	std::unique_ptr<sf::Font> font{ make_unique<sf::Font>() };
+
+	if (font->loadFromFile(font_file_name)) {
+		// Initialize the altimeter text string.
+		sf::Text altimeter;
+		altimeter.setFont(*font);
+		altimeter.setCharacterSize(30);
+		altimeter.setFillColor(sf::Color::Black);
+		// Create the virtual drone window.
+		// See the SFML documentaton for an explanation of the drawing and event polling loops.
+		sf::RenderWindow window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "Virtual Drone");
+		// Create the circle drawn at each waypoint in the drones' flight paths.
+		const sf::Texture marker_texture{ FlightPath::createMarkerTexture() };
+		// Start with the original view, with the origin in the centre of the window and one
+		// pixel per unit. Text is drawn over the drones with a fixed overlay view.
+		ViewControl control;
+		control.view = sf::View(sf::FloatRect(0.0f, 0.0f, float(WINDOW_WIDTH), float(WINDOW_HEIGHT)));
+		sf::View overlay_view(sf::FloatRect(0.0f, 0.0f, float(WINDOW_WIDTH), float(WINDOW_HEIGHT)));
+		// Record whether anything displayed has changed since the window was last drawn.
+		bool redraw{ true };
+		while (window.isOpen()) {
+			if (frame_settings_changed.exchange(false, std::memory_order_acq_rel)) {
+				window.setFramerateLimit(frame_rate_limit.load());
+				window.setVerticalSyncEnabled(vertical_sync.load());
+			}
+			sf::Event event;
+			while (window.pollEvent(event)) {
+				if (event.type == sf::Event::Closed) {
+					window.close();
+				}
+				else if (controlView(event, window, control, overlay_view) || (event.type != sf::Event::MouseMoved)) {
+					redraw = true;
+				}
+			}
+			wake_pending.store(false, std::memory_order_release);
+			if (takeNewDrones()) {
+				redraw = true;
+			}
+			if (applyCommands()) {
+				redraw = true;
+			}
+			// Keep drawing while any drone is still flying to its latest waypoint.
+			// A driven clock that has been set back takes the model back with it.
+			const long long now_ms{ milliseconds() };
+			if (now_ms / 1000.0 < model.time()) {
+				model.setTime(now_ms / 1000.0);
+			}
+			if (anyDroneMoving()) {
+				advanceModel(now_ms);
+				redraw = true;
+			}
+			if (!redraw || !window.isOpen()) {
+				waitForWake();
+				continue;
+			}
+			redraw = false;
+			// Refresh the window.
+			window.clear(sf::Color::Green);
+			// Draw the flight paths and their waypoints.
+			window.setView(control.view);
+			for (DroneView& view : views) {
+				view.flight_path->draw(window, marker_texture);
+			}
+			drawDrones(window, marker_texture);
+			window.setView(overlay_view);
+			for (size_t d{ 0 }; d < views.size(); d++) {
+				const DroneView& view{ views[d] };
+				// Display the drone's current altitude, one line per drone.
+				const long altitude{ std::lround(model.z(int(d))) };
+				if (views.size() == 1) {
+					altimeter.setString("Altitude: " + to_string(altitude));
+				}
+				else {
+					altimeter.setString("Drone " + to_string(view.drone->number) + " altitude: " + to_string(altitude));
+				}
+				altimeter.setPosition(0.0f, 35.0f * d);
+				altimeter.setFillColor(path_colours[d % num_colours]);
+				window.draw(altimeter);
+			}
+			// Redraw the window with the updated waypoints and altitude.
+			window.display();
+		}
+	}
+	else {
+		cout << endl << "Unable to load font file " << font_file_name << " - drone simulator not started" << endl;
+	}
+
+	font.reset();
+	is_rendering.store(false, std::memory_order_release);
+}
+
+
+// Start displaying any drones added since the previous frame, returning whether there were any.
+// The lock is only taken when a drone has actually been added.
+
+bool SimulatorScene::takeNewDrones()
+{
+	if (!drones_added.load(std::memory_order_acquire)) {
+		return false;
+	}
+
+	lock_guard<mutex> lock(drones_mutex);
+
+	for (const shared_ptr<SimulatorDrone>& drone : new_drones) {
+		views.push_back(makeView(drone));
+	}
+
+	new_drones.clear();
+	drones_added.store(false, std::memory_order_relaxed);
+
+	return true;
+}
+
+
+// Sleep until a drone command arrives or IDLE_WAIT_MS milliseconds pass, whichever is first.
+// A command queued just before the wait starts may not end it early, but is still drawn within
+// IDLE_WAIT_MS milliseconds.
+
+void SimulatorScene::waitForWake()
+{
+	std::unique_lock<mutex> lock(wake_mutex);
+
+	wake_condition.wait_for(lock, std::chrono::milliseconds(IDLE_WAIT_MS),
+							[this] { return wake_pending.load(std::memory_order_acquire); });
+}
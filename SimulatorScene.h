@@ -0,0 +1,209 @@
+#ifndef SIMULATOR_SCENE_H
+#define SIMULATOR_SCENE_H
+
+
+#include "DroneSimulatorApi.h"
+#include "KinematicModel.h"
+#include "SeparationMonitor.h"
+#include "SpscRing.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+// Forward declarations to reduce the need for include files.
+
+class FlightPath;
+
+namespace sf
+{
+	class RenderTarget;
+	class Texture;
+}
+
+
+// Simulator Scene class version 1.10
+
+// The single SFML window shared by every DroneSimulator object in the process.
+// Each DroneSimulator registers a SimulatorDrone with the scene, and the scene's rendering thread
+// draws the flight path of every registered drone in its own colour, so several FPL programs
+// executing in one process can be watched together. If the window is closed, the next drone
+// registered opens a new one.
+//
+// The headless scene has no window or rendering thread, and needs no display or font file.
+// Drone commands are recorded as they are sent and applied to the drones' state when it is next
+// needed, and the flight paths of all its drones can be saved as an image drawn off screen.
+// Every program execution's mission clock starts at 0, and the headless scene flies every drone
+// on that one clock, so programs executed one after another are checked as if their drones had
+// flown together. When commands arrive for a time the model has already passed, the model is
+// rewound and every command is applied again.
+//
+// Each drone starts on the ground at its own starting position, the origin unless given.
+// The drones fly along their flight paths according to a KinematicModel, at the speed set by
+// "arm" (ARM_SPEED) or "speed" commands unless a move carries its own speed, climbing to
+// TAKEOFF_ALTITUDE on "takeoff" and descending to the ground on "land". Every move, takeoff or land
+// command that arrives before the drone has finished its previous motion is recorded, so FPL
+// programs can be checked for NOP instructions that do not allow enough time for the motion.
+// After every step of the model, each pair of airborne drones that comes closer together than the
+// minimum separation (DEFAULT_SEPARATION unless set) is recorded, with the FPL instructions that
+// sent the drones on their current motions. In the headless scene a drone's mission ends with the
+// motion started by its last command, so a drone left airborne is not checked against missions
+// that continue after its own.
+//
+// In the windowed scene:
+// A drone's flight path stays on display after its DroneSimulator object has been destroyed.
+// The scene's clock follows real time unless it is driven by setClock(), such as from the mission
+// time of a replay, when the drones fly at the replay's speed and stop while it is paused.
+// The window is only redrawn after a drone command or a window event, at no more than the
+// configured frame rate. While nothing changes the rendering thread sleeps until woken by a
+// command, checking for window events every IDLE_WAIT_MS milliseconds.
+// The view can be zoomed with the mouse wheel or the + and - keys, and panned by dragging with the
+// left mouse button or with the arrow keys. The Home key restores the original view.
+
+
+// The part of a simulated drone shared between its DroneSimulator and the rendering thread.
+// The command ring is not used in the headless scene.
+
+struct SimulatorDrone
+{
+	SpscRing<SimulatorCommand, 4096> commands;		// commands not yet taken by the rendering thread
+	int                              number{ 0 };	// drone number, starting at 1, in order of creation
+	Coordinate3D                     start;			// where the drone starts on the ground
+};
+
+
+class SimulatorScene
+{
+public:		// member functions intended to be used by clients of the class
+
+	static SimulatorScene& sharedScene();
+	static SimulatorScene& headlessScene();
+
+	~SimulatorScene();		// destructor
+
+	std::shared_ptr<SimulatorDrone> addDrone(const Coordinate3D& start = Coordinate3D());
+	bool                            headless() const;
+	bool                            rendering() const;
+	void                            wake();
+
+	long long milliseconds() const;
+	void      setClock(long long time_ms);
+	bool      clockDriven() const;
+
+	void executeCommand(const SimulatorDrone& drone, const SimulatorCommand& command);
+	void displayDrone(const SimulatorDrone& drone);
+	void displayMotionReport(const SimulatorDrone& drone);
+	void displaySeparationReport(const SimulatorDrone& drone);
+	bool saveImage(const std::string& file_name);
+
+	void setFrameRateLimit(unsigned frames_per_second);
+	void setVerticalSync(bool enabled);
+	void setMinimumSeparation(int centimetres);
+
+private:	// member functions not intended to be used by clients of the class
+
+	struct DroneView;
+
+	// A command that arrived before the drone had finished its previous motion.
+
+	struct MotionReport
+	{
+		int                  drone{ 0 };								// drone number
+		long long            time_ms{ 0 };								// scene time of the command
+		int                  instruction{ -1 };							// FPL instruction location
+		SimulatorCommandType type{ SimulatorCommandType::OTHER };		// the command
+		float                remaining{ 0.0f };						// distance left of the previous motion
+	};
+
+	// Two airborne drones that came closer together than the minimum separation.
+
+	struct SeparationReport
+	{
+		long long time_ms_a{ 0 };			// when the drones came too close, in each drone's time
+		long long time_ms_b{ 0 };
+		int       drone_a{ 0 };				// drone numbers
+		int       drone_b{ 0 };
+		int       instruction_a{ -1 };		// FPL instruction locations of the drones' current motions
+		int       instruction_b{ -1 };
+		float     distance{ 0.0f };			// distance between the drones
+		bool      shown_a{ false };			// whether displayed for each drone
+		bool      shown_b{ false };
+	};
+
+	explicit SimulatorScene(bool headless);		// constructor
+
+	DroneView makeView(const std::shared_ptr<SimulatorDrone>& drone);
+
+	static std::unique_ptr<FlightPath> makeFlightPath(const SimulatorDrone& drone);
+
+	void applyCommand(DroneView& view, const SimulatorCommand& command, long long time_ms);
+	bool applyCommands();
+	void simulate();
+	void rewindModel();
+	void advanceModel(long long time_ms);
+	void stepModel();
+	bool anyDroneMoving() const;
+	void drawDrones(sf::RenderTarget& target, const sf::Texture& marker_texture) const;
+
+	void startRenderingThread();
+	void renderingThread();
+	bool takeNewDrones();
+	void waitForWake();
+
+private:	// data members should always have private scope
+
+	static const int WINDOW_WIDTH{ 1200 };			// fixed width  of the drone simulator window in pixels
+	static const int WINDOW_HEIGHT{ 900 };			// fixed height of the drone simulator window in pixels
+	static const int IDLE_WAIT_MS{ 20 };			// longest sleep before checking for window events
+	static const int ARM_SPEED{ 30 };				// speed set by "arm" in cm/s, the same as for the Tello
+	static const int TAKEOFF_ALTITUDE{ 80 };		// altitude reached by "takeoff" in cm
+	static const int VERTICAL_SPEED{ 50 };			// takeoff and landing speed in cm/s
+	static const int DEFAULT_SEPARATION{ 50 };		// minimum separation between drones in cm
+	static const int MAX_REPORT_LINES{ 20 };		// most lines listed in each drone's reports
+
+	const bool                                  is_headless;	// whether the scene has no window
+	const std::chrono::steady_clock::time_point epoch;			// when the scene was created
+
+	std::mutex                                   drones_mutex;			// ensures thread-safe access to new_drones,
+																		// and to views in the headless scene
+	std::vector<std::shared_ptr<SimulatorDrone>> new_drones;			// drones added since the previous frame
+	std::atomic<bool>                            drones_added{ false };	// whether new_drones is not empty
+	int                                          num_drones{ 0 };		// number of drones ever added
+	std::vector<DroneView>                       views;					// every drone in the scene, only used by
+																		// the rendering thread in the windowed scene
+	KinematicModel                               model;					// drone motion, used like views
+	SeparationMonitor                            separation_monitor;	// checks the model, used like views
+	std::vector<char>                            airborne_drones;		// which drones separation_monitor checks
+	std::vector<SeparationMonitor::Violation>    violations;			// pairs that just came too close
+	std::atomic<int>                             minimum_separation{ DEFAULT_SEPARATION };	// in cm, 0 for none
+	std::atomic<bool>                            separation_changed{ true };	// not yet given to the monitor
+	long long                                    applied_ms{ 0 };		// time of the latest command applied
+
+	std::mutex                    reports_mutex;		// ensures thread-safe access to the reports
+	std::vector<MotionReport>     motion_reports;		// commands that interrupted a motion
+	std::vector<SeparationReport> separation_reports;	// pairs of drones that came too close
+	std::vector<int>              shown_motion_reports;	// motion reports displayed for each drone
+	std::set<std::tuple<int, long long, int>> shown_separations;	// drone, its time and the other drone
+																	// of each separation report displayed
+
+	std::atomic<bool> is_rendering{ true };		// false once the rendering thread has exited
+
+	std::atomic<long long> clock_ms{ -1 };		// scene time set by setClock(), or -1 for real time
+
+	std::mutex              wake_mutex;					// used with wake_condition
+	std::condition_variable wake_condition;				// wakes the idle rendering thread
+	std::atomic<bool>       wake_pending{ false };		// whether a command arrived since the last wait
+
+	std::atomic<unsigned> frame_rate_limit{ 60 };		// maximum frames per second, 0 for no limit
+	std::atomic<bool>     vertical_sync{ false };		// whether frames are synchronized with the display
+	std::atomic<bool>     frame_settings_changed{ true };	// whether the window needs the settings above
+};
+
+
+#endif // SIMULATOR_SCENE_H
@@ -0,0 +1,78 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+
+#include <atomic>
+
+
+// SpscRing class template version 1.0
+
+// A bounded lock-free ring buffer for exactly one producer thread and one consumer thread.
+// The producer calls push() and the consumer calls pop(); neither call ever blocks or locks.
+// CAPACITY must be a power of two, and one slot is sacrificed to tell a full ring from an empty one.
+// The slots are stored inline so that the ring can also be placed in memory shared between
+// processes, provided T is trivially copyable.
+
+
+template <typename T, unsigned CAPACITY>
+class SpscRing
+{
+	static_assert((CAPACITY >= 2) && ((CAPACITY & (CAPACITY - 1)) == 0), "CAPACITY must be a power of two");
+
+public:		// member functions intended to be used by clients of the class
+
+	// Append a copy of the item to the ring and return true, or return false if the ring is full.
+	// Only the producer thread may call push().
+
+	bool push(const T& item)
+	{
+		const unsigned head{ head_index.load(std::memory_order_relaxed) };
+		const unsigned next{ (head + 1) & MASK };
+
+		if (next == tail_index.load(std::memory_order_acquire)) {
+			return false;
+		}
+
+		slots[head] = item;
+		head_index.store(next, std::memory_order_release);
+
+		return true;
+	}
+
+	// Remove the oldest item from the ring into the argument and return true, or return false if
+	// the ring is empty.
+	// Only the consumer thread may call pop().
+
+	bool pop(T& item)
+	{
+		const unsigned tail{ tail_index.load(std::memory_order_relaxed) };
+
+		if (tail == head_index.load(std::memory_order_acquire)) {
+			return false;
+		}
+
+		item = slots[tail];
+		tail_index.store((tail + 1) & MASK, std::memory_order_release);
+
+		return true;
+	}
+
+	// Return whether the ring currently holds no items.
+	// The answer may be out of date by the time the caller acts on it.
+
+	bool empty() const
+	{
+		return tail_index.load(std::memory_order_acquire) == head_index.load(std::memory_order_acquire);
+	}
+
+private:	// data members should always have private scope
+
+	static const unsigned MASK{ CAPACITY - 1 };
+
+	alignas(64) std::atomic<unsigned> head_index{ 0 };		// next slot the producer writes
+	alignas(64) std::atomic<unsigned> tail_index{ 0 };		// next slot the consumer reads
+	alignas(64) T slots[CAPACITY];							// ring storage
+};
+
+
+#endif // SPSC_RING_H
@@ -1,42 +1,87 @@
 #include "TelloApi.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iostream>
-#include <thread>
+
+#ifdef _WIN32
 #include <ws2tcpip.h>
 
 #pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
 
 
-// Tello API class version 1.3
+// Tello API class version 1.12
 
 // This class provides a C++ class interface to communicate with the Tello drone using UDP.
 // A socket implements the communication endpoint.
 // See the Tello SDK 2.0 User Guide for a complete list of commands supported by the drone.
+//
+// Submitted commands are queued for a command thread, which sends each one and waits for its
+// response before sending the next. The caller only waits if it asks the returned future for the
+// result, so it can prepare later commands while the Tello is still responding to earlier ones.
+// Responses are received on a separate thread and passed to the command thread under
+// response_mutex, so the command thread sleeps on a condition variable rather than polling a buffer.
+// On Windows the receive thread blocks in recvfrom() and is stopped by closing the socket.
+// On Linux the socket is non-blocking and the receive thread sleeps in epoll_wait() until either a
+// response arrives or the destructor writes to an eventfd.
+// The Tello's responses carry no sequence numbers, so each response is matched to the command by
+// its form, and responses that arrive after a command was answered are discarded (see
+// exchangeCommand()).
 
 
 using std::cout;
 using std::endl;
+using std::future;
+using std::lock_guard;
+using std::mutex;
+using std::promise;
+using std::size_t;
 using std::string;
 using std::thread;
+using std::unique_lock;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
 
 
-// The Tello constructor allocates and clears the send and receive buffers.
+// Return a description of the last socket error.
 
-Tello::Tello()
+static string lastSocketError()
 {
-	send_buffer    = new char[BUFFER_SIZE];
-	receive_buffer = new char[BUFFER_SIZE];
-
-	memset(send_buffer,    0, BUFFER_SIZE);
-	memset(receive_buffer, 0, BUFFER_SIZE);
+#ifdef _WIN32
+	return "error code " + std::to_string(WSAGetLastError());
+#else
+	return strerror(errno);
+#endif
 }
 
 
-// The Tello destructor deallocates the send and receive buffers.
+// The Tello constructor records the Tello's address and the local ports to use, without creating
+// a socket; see canInitialize().
+// The defaults are those of a Tello reached through its own Wi-Fi access point.
+
+Tello::Tello(const string& tello_ip, unsigned short tello_port, unsigned short local_port,
+			 unsigned short state_port) :
+	tello_ip(tello_ip),
+	tello_port(tello_port),
+	local_port(local_port),
+	state_port(state_port)
+{}
+
+
+// The Tello destructor stops the receive thread and closes the socket.
 
 Tello::~Tello()
 {
-	delete[] send_buffer;
-	delete[] receive_buffer;
+	closeSocket();
 }
 
 
@@ -45,62 +90,304 @@ Tello::~Tello()
 
 bool Tello::canInitialize()
 {
-	const char LOCAL_IP[]{ "" };				// laptop IP address
-	const char TELLO_IP[]{ "192.168.10.1" };	// Tello IP address
+	// Define the client address structure, accepting responses on every local address.
 
-	const u_short LOCAL_PORT{ 8889 };			// laptop UDP port
-	const u_short TELLO_PORT{ 8889 };			// Tello UDP port
+	client_addr.sin_family = AF_INET;
+	client_addr.sin_port = htons(local_port);
+	client_addr.sin_addr.s_addr = htonl(INADDR_ANY);
 
-	// All processes (applications or DLLs) that call Winsock functions must initialize
-	// the use of the Windows Sockets DLL before making other Winsock functions calls.
-	
-	int result{ WSAStartup(MAKEWORD(2, 2), &wsa_data) };
+	// Define the server address structure.
 
-	if (result != 0) {
-		cout << "Tello connection WSAStartup failed (error code " << result << ')' << endl;
+	server_addr.sin_family = AF_INET;
+	server_addr.sin_port = htons(tello_port);
+
+	if (inet_pton(AF_INET, tello_ip.c_str(), &server_addr.sin_addr.s_addr) != 1) {
+		cout << "Invalid Tello IP address " << tello_ip << endl;
 		return false;
 	}
 
-	// Define the client address structure.
+	if (!openSocket()) {
+		return false;
+	}
 
-	client_addr.sin_family = AF_INET;
-	client_addr.sin_port = htons(LOCAL_PORT);
-	inet_pton(AF_INET, LOCAL_IP, &client_addr.sin_addr.s_addr);
+	// Start the receive and command threads.
 
-	// Define the server address structure.
+	receive_thread = thread(&Tello::receiveThread, this);
+	command_thread = thread(&Tello::commandThread, this);
 
-	server_addr.sin_family = AF_INET;
-	server_addr.sin_port = htons(TELLO_PORT);
-	inet_pton(AF_INET, TELLO_IP, &server_addr.sin_addr.s_addr);
+	// Check if the Tello is responding to commands.
 
-	// Create a socket.
+	if (!sendCommand("command")) {
+		cout << "Tello not responding - is your laptop connected to it?" << endl;
+		return false;
+	}
 
-	socket_tello = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	// The Tello starts sending its state once it has accepted "command". Without the state every
+	// query is sent to the Tello, so this is not an initialization failure.
 
-	if (socket_tello == INVALID_SOCKET) {
-		cout << "Error creating Tello socket (error code " << WSAGetLastError() << ')' << endl;
-		return false;
+	if (!telemetry.start(state_port)) {
+		cout << "Tello state not available - queries will be sent to the Tello" << endl;
 	}
 
-	// Bind the socket to the local address and port.
+	return true;
+}
 
-	if (::bind(socket_tello, (sockaddr *)&client_addr, sizeof(client_addr)) == SOCKET_ERROR) {
-		cout << "Binding of Tello socket failed (error code " << WSAGetLastError() << ')' << endl;
-		return false;
+
+// Send the string parameter to the Tello, after any commands submitted earlier, and wait for the
+// result.
+// The function returns true if the Tello responds with "ok" within MAX_TIMEOUT seconds, plus the
+// flight time of a motion command (see responseTimeoutMs()); otherwise a diagnostic message is
+// written to the console and the function returns false.
+
+bool Tello::sendCommand(const string& command)
+{
+	return submit(command).get();
+}
+
+
+// Queue the string parameter to be sent to the Tello once it has responded to every command
+// submitted earlier, and return immediately.
+// The returned future becomes true if the Tello responds to the command with "ok" within
+// MAX_TIMEOUT seconds of it being sent, plus the flight time of a motion command; otherwise a
+// diagnostic message is written to the console and the future becomes false.
+// A query that can be answered from a recent state packet is not sent, and the future is already
+// true, unless earlier commands have not yet been carried out.
+
+future<bool> Tello::submit(const string& command)
+{
+	string answer;
+
+	if (!commandsPending() && telemetry.answerQuery(command, MAX_STATE_AGE_MS, answer)) {
+		if (command_echo) {
+			cout << "Answering \"" << command << "\" from the Tello state: " << answer << endl;
+		}
+		local_answers++;
+		promise<bool> answered;
+		answered.set_value(true);
+		return answered.get_future();
 	}
 
-	// Start the receive thread.
+	if (command_echo) {
+		cout << "Sending \"" << command << "\" to Tello" << endl;
+	}
 
-	thread receive_thread_tello(&Tello::receiveThread, this);
+	return queueCommand(command, nullptr);
+}
 
-	// Detach the receive thread so it runs concurrently with the main thread.
 
-	receive_thread_tello.detach();
+// Return whether any submitted command is still queued or awaiting the Tello's response.
 
-	// Check if the Tello is responding to commands.
+bool Tello::commandsPending()
+{
+	lock_guard<mutex> lock(queue_mutex);
 
-	if (!sendCommand("command")) {
-		cout << "Tello not responding - is your laptop connected to it?" << endl;
+	return command_in_flight || !command_queue.empty();
+}
+
+
+// Queue a command for the command thread, with the string to receive its response if answer is
+// not null, and return the future that receives its result.
+// Waits while MAX_QUEUED_COMMANDS commands are already queued.
+
+future<bool> Tello::queueCommand(const string& command, string* answer)
+{
+	QueuedCommand queued;
+	queued.command = command;
+	queued.answer  = answer;
+
+	future<bool> result{ queued.result.get_future() };
+
+	if (!command_thread.joinable()) {
+		cout << "Tello connection not established - \"" << command << "\" not sent" << endl;
+		queued.result.set_value(false);
+		return result;
+	}
+
+	{
+		unique_lock<mutex> lock(queue_mutex);
+		queue_space.wait(lock, [this] { return stopping || (command_queue.size() < MAX_QUEUED_COMMANDS); });
+		if (stopping) {
+			queued.result.set_value(false);
+			return result;
+		}
+		command_queue.push_back(std::move(queued));
+	}
+
+	command_queued.notify_one();
+
+	return result;
+}
+
+
+// This function runs as a separate thread from the main() thread to send the submitted commands
+// to the Tello one at a time, until the destructor stops it.
+// Commands still queued when it stops are reported as failed.
+
+void Tello::commandThread()
+{
+	while (true) {
+		QueuedCommand queued;
+		{
+			unique_lock<mutex> lock(queue_mutex);
+			command_queued.wait(lock, [this] { return stopping || !command_queue.empty(); });
+			if (stopping) {
+				for (QueuedCommand& abandoned : command_queue) {
+					abandoned.result.set_value(false);
+				}
+				command_queue.clear();
+				return;
+			}
+			queued = std::move(command_queue.front());
+			command_queue.pop_front();
+			command_in_flight = true;
+		}
+		queue_space.notify_one();
+		const bool succeeded{ exchangeCommand(queued.command, queued.answer) };
+		{
+			lock_guard<mutex> lock(queue_mutex);
+			command_in_flight = false;
+		}
+		queued.result.set_value(succeeded);
+	}
+}
+
+
+// Return the answer to a Tello query, such as "battery?", or an empty string if the Tello did not
+// answer it. The answer comes from the Tello state if a recent state packet answers the query and
+// every command submitted earlier has been carried out; otherwise the query is sent after those
+// commands and this waits for the response.
+
+string Tello::query(const string& query)
+{
+	string answer;
+
+	if (!commandsPending() && telemetry.answerQuery(query, MAX_STATE_AGE_MS, answer)) {
+		local_answers++;
+		return answer;
+	}
+
+	if (command_echo) {
+		cout << "Sending \"" << query << "\" to Tello" << endl;
+	}
+
+	if (!queueCommand(query, &answer).get()) {
+		answer.clear();
+	}
+
+	return answer;
+}
+
+
+// Copy the latest state received from the Tello into the argument and return true, or return
+// false if no state has been received.
+
+bool Tello::latestState(TelloState& state) const
+{
+	return telemetry.latestState(state);
+}
+
+
+// Send a command to the Tello and wait for its response, which is copied to the answer argument
+// if it is not null.
+// Returns true if the Tello responds with "ok" (or with a value, for a query) within MAX_TIMEOUT
+// seconds, plus the flight time of a motion command; otherwise a diagnostic message is written to
+// the console and false is returned.
+// A repeatable command is sent again, with the retransmission timeout doubled each time, whenever
+// no response arrives within the retransmission timeout. Only the round trip times of commands
+// answered without being sent again update the timeout, as it is otherwise unknown which
+// transmission was answered (Karn's algorithm).
+
+bool Tello::exchangeCommand(const string& command, string* answer)
+{
+	const bool                     repeatable{ isRepeatableCommand(command) };
+	const steady_clock::time_point first_sent{ steady_clock::now() };
+	const int                      response_timeout_ms{ responseTimeoutMs(command, MAX_TIMEOUT * 1000) };
+	const steady_clock::time_point give_up{ first_sent + milliseconds(response_timeout_ms) };
+
+	unique_lock<mutex> lock(response_mutex);
+
+	// Anything received since the previous command finished belongs to an earlier command.
+
+	link_statistics.responsesDiscarded(responses.size());
+	responses.clear();
+
+	int    transmissions{ 0 };
+	double timeout_ms{ link_statistics.retransmissionTimeout() };
+	string response;
+	bool   responded{ false };
+
+	while (!responded) {
+		if (sendto(socket_tello, command.c_str(), static_cast<int>(command.length()), 0,
+			(sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+			cout << "Failed to send \"" << command << "\" to Tello (" << lastSocketError() << ')' << endl;
+			return false;
+		}
+		transmissions++;
+
+		// Sleep until a matching response arrives, the retransmission timeout of a repeatable
+		// command expires or the response timeout has passed.
+
+		const steady_clock::time_point retransmit_at{ steady_clock::now() +
+			std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double, std::milli>(timeout_ms)) };
+		const steady_clock::time_point wait_until{ repeatable ? std::min(retransmit_at, give_up) : give_up };
+
+		while (!responded && !stopping) {
+			if (!response_ready.wait_until(lock, wait_until, [this] { return !responses.empty() || stopping; })) {
+				break;
+			}
+			while (!responses.empty() && !responded) {
+				if (responseMatchesCommand(command, responses.front())) {
+					response  = responses.front();
+					responded = true;
+				}
+				else {
+					link_statistics.responsesDiscarded(1);
+				}
+				responses.pop_front();
+			}
+		}
+
+		if (stopping) {		// the destructor is stopping the command thread
+			return false;
+		}
+
+		if (!responded) {
+			if (steady_clock::now() >= give_up) {
+				cout << "Tello did not respond to \"" << command << "\" after "
+					 << (response_timeout_ms / 1000.0) << " seconds" << endl;
+				link_statistics.commandTimedOut();
+				if (transmissions > 1) {
+					discardLateResponses(lock);
+				}
+				return false;
+			}
+			timeout_ms = std::min(2.0 * timeout_ms, MAX_TIMEOUT * 1000.0);
+			link_statistics.commandRetransmitted();
+		}
+	}
+
+	const double latency_ms{ std::chrono::duration<double, std::milli>(steady_clock::now() - first_sent).count() };
+
+	link_statistics.commandAnswered(repeatable, latency_ms);
+
+	if (repeatable) {
+		if (transmissions == 1) {
+			link_statistics.roundTripMeasured(latency_ms);
+		}
+		else {
+			link_statistics.timeoutBackedOff(timeout_ms);
+			discardLateResponses(lock);
+		}
+	}
+
+	if (answer != nullptr) {
+		*answer = response;
+	}
+
+	// Ensure that the Tello responds with "ok" (or a value) rather than "error".
+
+	if (response.compare(0, 5, "error") == 0) {
+		cout << "Tello returned \"" << response << "\" for \"" << command << "\" command" << endl;
 		return false;
 	}
 
@@ -108,64 +395,234 @@ bool Tello::canInitialize()
 }
 
 
-// Send the string parameter to the Tello.
-// The function returns true if the Tello responds with "ok" within MAX_TIMEOUT seconds;
-// otherwise a diagnostic message is written to the console and the function returns false.
+// Wait for one retransmission timeout after a command that was sent more than once, discarding the
+// responses to its other transmissions so that they are not taken as the response to the next
+// command.
 
-bool Tello::sendCommand(const string& command)
+void Tello::discardLateResponses(unique_lock<mutex>& lock)
 {
-	cout << "Sending \"" << command << "\" to Tello" << endl;
+	const steady_clock::time_point discard_until{ steady_clock::now() +
+		std::chrono::duration_cast<steady_clock::duration>(
+			std::chrono::duration<double, std::milli>(link_statistics.retransmissionTimeout())) };
 
-	// Clear out the receive buffer.
+	while (!stopping && response_ready.wait_until(lock, discard_until, [this] { return !responses.empty() || stopping; })) {
+		link_statistics.responsesDiscarded(responses.size());
+		responses.clear();
+	}
+}
+
+
+// Select whether each command sent, or query answered from the Tello state, is written to the
+// console. Diagnostic messages are always written.
+
+void Tello::setCommandEcho(bool echo)
+{
+	command_echo = echo;
+}
 
-	memset(receive_buffer, 0, BUFFER_SIZE);
 
-	// Convert the send command to type char* and convert to UTF-8 using the sendto() function.
+// Display the response times of the commands sent so far and the retransmission counts.
 
-	strcpy_s(send_buffer, BUFFER_SIZE, command.c_str());
+void Tello::displayLatencyReport()
+{
+	lock_guard<mutex> lock(response_mutex);
+
+	link_statistics.display(local_answers, telemetry.packetsReceived());
+}
 
-	if (sendto(socket_tello, send_buffer, (int)strlen(send_buffer), 0,
-		(sockaddr*)&server_addr, sizeof(server_addr)) == SOCKET_ERROR) {
-		cout << "Failed to send \"" << command << "\" to Tello (error code "
-			 << WSAGetLastError() << ')' << endl;
+
+// Create the socket and bind it to the local address and port, and on Linux create the epoll
+// instance watching it and the eventfd used to stop the receive thread.
+// Returns false, after writing a diagnostic message, if any of these fail.
+
+bool Tello::openSocket()
+{
+#ifdef _WIN32
+	// All processes (applications or DLLs) that call Winsock functions must initialize
+	// the use of the Windows Sockets DLL before making other Winsock functions calls.
+
+	int result{ WSAStartup(MAKEWORD(2, 2), &wsa_data) };
+
+	if (result != 0) {
+		cout << "Tello connection WSAStartup failed (error code " << result << ')' << endl;
 		return false;
 	}
 
-	// Wait for maximum timeout when awaiting response from Tello.
+	wsa_started = true;
 
-	clock_t start_time{ clock() };
+	socket_tello = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
 
-	while (receive_buffer[1] == '\0') {
-		if (((clock() - start_time) / CLOCKS_PER_SEC) > MAX_TIMEOUT) {
-			cout << "Tello did not respond to \"" << command << "\" after "
-				 << MAX_TIMEOUT << " seconds" << endl;
-			return false;
-		}
+	if (socket_tello == INVALID_SOCKET) {
+		cout << "Error creating Tello socket (" << lastSocketError() << ')' << endl;
+		return false;
+	}
+#else
+	socket_tello = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+
+	if (socket_tello < 0) {
+		cout << "Error creating Tello socket (" << lastSocketError() << ')' << endl;
+		return false;
+	}
+#endif
+
+	// Bind the socket to the local address and port.
+
+	if (::bind(socket_tello, (sockaddr *)&client_addr, sizeof(client_addr)) != 0) {
+		cout << "Binding of Tello socket failed (" << lastSocketError() << ')' << endl;
+		return false;
+	}
+
+#ifndef _WIN32
+	wake_fd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+	if ((wake_fd < 0) || (epoll_fd < 0)) {
+		cout << "Error creating Tello event loop (" << lastSocketError() << ')' << endl;
+		return false;
 	}
 
-	// Ensure that the Tello responds with "ok" rather than "error".
+	epoll_event event{};
+
+	event.events  = EPOLLIN;
+	event.data.fd = socket_tello;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket_tello, &event) != 0) {
+		cout << "Error watching Tello socket (" << lastSocketError() << ')' << endl;
+		return false;
+	}
 
-	if (strcmp(receive_buffer, "ok") != 0) {
-		cout << "Tello returned \"" << receive_buffer << "\" for \"" << command << "\" command" << endl;
+	event.data.fd = wake_fd;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event) != 0) {
+		cout << "Error watching Tello stop event (" << lastSocketError() << ')' << endl;
 		return false;
 	}
-	
+#endif
+
 	return true;
 }
 
 
-// This function runs as a separate thread from the main() thread to receive and record
-// responses from the Tello.
+// Stop the command and receive threads if they are running and close everything opened by
+// openSocket().
+
+void Tello::closeSocket()
+{
+	// Setting stopping while holding both mutexes ensures that neither waiting thread misses it.
+	{
+		lock_guard<mutex> queue_lock(queue_mutex);
+		lock_guard<mutex> response_lock(response_mutex);
+		stopping = true;
+	}
+	command_queued.notify_one();
+	queue_space.notify_all();
+	response_ready.notify_one();
+
+	if (command_thread.joinable()) {
+		command_thread.join();
+	}
+
+#ifdef _WIN32
+	// Closing the socket makes the receive thread's recvfrom() call fail.
+	if (socket_tello != INVALID_SOCKET) {
+		closesocket(socket_tello);
+		socket_tello = INVALID_SOCKET;
+	}
+	if (receive_thread.joinable()) {
+		receive_thread.join();
+	}
+	if (wsa_started) {
+		WSACleanup();
+		wsa_started = false;
+	}
+#else
+	if (receive_thread.joinable()) {
+		const eventfd_t stop{ 1 };
+		if (write(wake_fd, &stop, sizeof(stop)) != sizeof(stop)) {
+			cout << "Failed to stop the Tello receive thread (" << lastSocketError() << ')' << endl;
+		}
+		receive_thread.join();
+	}
+	for (int* fd : { &epoll_fd, &wake_fd, &socket_tello }) {
+		if (*fd >= 0) {
+			::close(*fd);
+			*fd = -1;
+		}
+	}
+#endif
+}
+
+
+// This function runs as a separate thread from the main() thread to receive responses from the
+// Tello and pass them to the command thread, until the destructor stops it.
 
 void Tello::receiveThread()
 {
+	char        receive_buffer[BUFFER_SIZE];
+	sockaddr_in tello_addr{};
+
+#ifdef _WIN32
 	int tello_addr_length{ sizeof(tello_addr) };
 
+	while (!stopping) {
+		const int length{ recvfrom(socket_tello, receive_buffer, BUFFER_SIZE - 1, 0,
+			(sockaddr *)&tello_addr, &tello_addr_length) };
+		if (length != SOCKET_ERROR) {
+			responseReceived(receive_buffer, length);
+		}
+		else if (!stopping) {
+			cout << "Failed to receive Tello response (" << lastSocketError() << ')' << endl;
+		}
+	}
+#else
+	const int   MAX_EVENTS{ 2 };	// the socket and the eventfd
+	epoll_event events[MAX_EVENTS];
+
 	while (true) {
-		if (recvfrom(socket_tello, receive_buffer, BUFFER_SIZE, 0,
-			(sockaddr *)&tello_addr, &tello_addr_length) == SOCKET_ERROR) {
-			cout << "Failed to receive Tello response (error code "
-				 << WSAGetLastError() << ')' << endl;
+		const int num_events{ epoll_wait(epoll_fd, events, MAX_EVENTS, -1) };
+
+		if (num_events < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			cout << "Failed to wait for Tello response (" << lastSocketError() << ')' << endl;
+			return;
+		}
+
+		for (int i{ 0 }; i < num_events; i++) {
+			if (events[i].data.fd == wake_fd) {
+				return;
+			}
+
+			// Take every datagram waiting on the socket.
+			while (true) {
+				socklen_t     tello_addr_length{ sizeof(tello_addr) };
+				const ssize_t length{ recvfrom(socket_tello, receive_buffer, BUFFER_SIZE - 1, 0,
+					(sockaddr*)&tello_addr, &tello_addr_length) };
+				if (length >= 0) {
+					responseReceived(receive_buffer, static_cast<int>(length));
+				}
+				else {
+					if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+						cout << "Failed to receive Tello response (" << lastSocketError() << ')' << endl;
+					}
+					if (errno != EINTR) {
+						break;
+					}
+				}
+			}
 		}
 	}
+#endif
+}
+
+
+// Record a response from the Tello and wake the command thread waiting for it.
+
+void Tello::responseReceived(const char* received, int length)
+{
+	{
+		lock_guard<mutex> lock(response_mutex);
+		responses.emplace_back(received, length);
+	}
+
+	response_ready.notify_one();
 }
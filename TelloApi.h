@@ -2,43 +2,131 @@
 #define TELLO_API_H
 
 
+#include "TelloLink.h"
+#include "TelloTelemetry.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
 #include <string>
+#include <thread>
+
+#ifdef _WIN32
 #include <winsock2.h>
+#else
+#include <netinet/in.h>
+#endif
 
 
-// Tello API class version 1.3
+// Tello API class version 1.12
 
 // A very basic class to communicate with and control a Tello drone.
+// Commands can be submitted without waiting for the Tello's response: they are queued and sent by
+// a command thread one at a time, as the Tello only accepts a new command once it has responded to
+// the previous one, and the returned future becomes ready with the result. sendCommand() submits a
+// command and waits for its result. At most MAX_QUEUED_COMMANDS commands wait to be sent; a
+// command submitted when the queue is full waits for space, so a program that submits commands
+// faster than the Tello carries them out is held back rather than using ever more memory.
+// The command thread sleeps until the receive thread hands it the Tello's response. The receive
+// thread uses Winsock on Windows and a non-blocking socket driven by epoll on Linux.
+// Commands that can safely be repeated, such as "speed 50" or "battery?", are sent again when no
+// response arrives within a retransmission timeout estimated from the measured round trip times.
+// Motion commands are never sent twice, as a lost response would then move the drone twice.
+// Once the Tello is initialized its state stream is received by a TelloTelemetry object, and
+// queries that the state answers, such as "battery?", are answered from it without being sent,
+// unless earlier commands are still queued or awaiting a response: the query is then queued behind
+// them, so its answer never comes from before they were carried out.
+// The Tello's address and the local ports can be given to the constructor, so that a Tello emulator
+// (see tello-emulator.cpp) or several Tellos can be reached.
 
 
 class Tello
 {
 public:			// member functions intended to be used by clients of the class
 
-	Tello();	// constructor
+	Tello(const std::string& tello_ip = "192.168.10.1", unsigned short tello_port = 8889,
+		  unsigned short local_port = 8889, unsigned short state_port = 8890);	// constructor
 	~Tello();	// destructor
 
-	bool canInitialize();
-	bool sendCommand(const std::string& command);
-	
+	Tello(const Tello&) = delete;
+	Tello& operator=(const Tello&) = delete;
+
+	bool              canInitialize();
+	bool              sendCommand(const std::string& command);
+	std::future<bool> submit(const std::string& command);
+	std::string       query(const std::string& query);
+	bool              latestState(TelloState& state) const;
+
+	void setCommandEcho(bool echo);
+	void displayLatencyReport();
+
 private:		// member functions not intended to be used by clients of the class
 
-	void receiveThread();
+	bool              openSocket();
+	void              closeSocket();
+	std::future<bool> queueCommand(const std::string& command, std::string* answer);
+	bool              commandsPending();
+	void              commandThread();
+	bool              exchangeCommand(const std::string& command, std::string* answer);
+	void              discardLateResponses(std::unique_lock<std::mutex>& lock);
+	void              receiveThread();
+	void              responseReceived(const char* received, int length);
 
 private:		// data members should always have private scope
 
-	const int      MAX_TIMEOUT{ 5 };	// maximum number of seconds allowed for Tello responses
-	const unsigned BUFFER_SIZE{ 256 };	// Tello send and receive buffer sizes
+	// A submitted command waiting for the command thread.
+
+	struct QueuedCommand
+	{
+		std::string         command;			// the Tello command text
+		std::promise<bool>  result;				// set once the Tello has responded or the command failed
+		std::string*        answer{ nullptr };	// if not null, receives the response before result is set
+	};
+
+	const int             MAX_TIMEOUT{ 5 };		// maximum number of seconds allowed for Tello responses
+	static const unsigned BUFFER_SIZE{ 256 };	// Tello receive buffer size
+	static const unsigned MAX_QUEUED_COMMANDS{ 256 };	// most commands waiting to be sent
+
+	const long long MAX_STATE_AGE_MS{ 500 };	// oldest state used to answer a query locally
+
+	const std::string    tello_ip;				// Tello IP address
+	const unsigned short tello_port;			// Tello UDP port
+	const unsigned short local_port;			// laptop UDP port, or 0 for any free port
+	const unsigned short state_port;			// laptop UDP port receiving the Tello state
+	bool                 command_echo{ true };	// write each command sent to the console
+
+	std::mutex              response_mutex;		// ensures thread-safe access to the response and statistics members
+	std::condition_variable response_ready;		// notified by the receive thread for each response
+	std::deque<std::string> responses;			// responses not yet matched to a command, oldest first
+
+	TelloLinkStatistics     link_statistics;	// retransmission timeout and response times
+
+	TelloTelemetry         telemetry;			// receives the Tello state stream
+	std::atomic<long long> local_answers{ 0 };	// queries answered from the state stream
+
+	std::mutex                queue_mutex;		// ensures thread-safe access to command_queue
+	std::condition_variable   command_queued;	// notified when a command is submitted or on stopping
+	std::condition_variable   queue_space;		// notified when a command is taken or on stopping
+	std::deque<QueuedCommand> command_queue;	// submitted commands not yet sent, oldest first
+	bool                      command_in_flight{ false };	// the command thread is awaiting a response
 
-	char* send_buffer{ nullptr };		// used for sending commands to the Tello
-	char* receive_buffer{ nullptr };	// used for receiving responses from the Tello
+	std::thread       command_thread;			// runs commandThread() once the socket is bound
+	std::thread       receive_thread;			// runs receiveThread() once the socket is bound
+	std::atomic<bool> stopping{ false };		// the destructor is stopping the threads
 
+#ifdef _WIN32
 	WSADATA wsa_data;					// used by WSAStartup to indicate the use of sockets
-	SOCKET  socket_tello;				// socket for connecting to Tello
+	bool    wsa_started{ false };		// WSAStartup succeeded and WSACleanup is needed
+	SOCKET  socket_tello{ INVALID_SOCKET };	// socket for connecting to Tello
+#else
+	int socket_tello{ -1 };				// non-blocking socket for connecting to Tello
+	int epoll_fd{ -1 };					// waits for responses or the stop request
+	int wake_fd{ -1 };					// eventfd written by the destructor to stop the receive thread
+#endif
 
 	sockaddr_in client_addr{};			// structure for generating client internet address
 	sockaddr_in server_addr{};			// structure for generating server internet address
-	sockaddr_in tello_addr{};			// used by receiveThread()'s recvfrom() call
 };
 
 
@@ -0,0 +1,138 @@
+#include "TelloBackend.h"
+#include "TelloApi.h"
+#include "TelloSwarm.h"
+#include <iostream>
+
+
+// TelloBackend class version 1.3
+
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::to_string;
+
+
+// The TelloBackend constructor prepares to control a Tello reached through its own Wi-Fi access
+// point, which is connected to when an "<initialize>" drone command is executed.
+
+TelloBackend::TelloBackend()
+{}
+
+
+// This TelloBackend constructor sends the commands to one drone of a started swarm instead of
+// creating a Tello object, so that many programs, each executed on its own thread, can control the
+// drones of one swarm through its single event loop. The swarm must outlive the backend.
+
+TelloBackend::TelloBackend(TelloSwarm& swarm, int drone) :
+	tello_swarm(&swarm),
+	swarm_drone(drone)
+{}
+
+
+// The TelloBackend destructor waits for the commands submitted and deallocates the Tello object if
+// one was created.
+
+TelloBackend::~TelloBackend()
+{
+	waitForCommands();
+	delete tello_drone;
+}
+
+
+// Return the name of the backend in profiles.
+
+const char* TelloBackend::name() const
+{
+	return "Tello";
+}
+
+
+// Translate a drone command into the text of a Tello command and submit it.
+// The "go" command always carries a speed, so the speed of the latest "arm" or "speed" command is
+// remembered for moves that have no planned speed.
+
+void TelloBackend::sendCommand(const DroneCommand& command)
+{
+	static const int default_speed{ 30 };		// Tello's default speed in cm/sec
+
+	if (command.kind == DroneCommandKind::INITIALIZE) {
+		move_speed = default_speed;
+		initialize();
+		return;
+	}
+
+	if ((tello_drone == nullptr) && (tello_swarm == nullptr)) {
+		cout << "Tello not initialized - <" << formatDroneCommand(command) << "> command skipped" << endl;
+		return;
+	}
+
+	string tello_command;
+
+	if (command.kind == DroneCommandKind::MOVE) {
+		const int speed{ (command.speed > 0) ? command.speed : move_speed };
+		tello_command = "go " + to_string(command.arguments[0]) + ' ' + to_string(command.arguments[1]) + ' ' +
+						to_string(command.arguments[2]) + ' ' + to_string(speed);
+	}
+	else if (command.kind == DroneCommandKind::ARM) {
+		move_speed    = default_speed;
+		tello_command = "speed " + to_string(default_speed);
+	}
+	else {
+		if (command.kind == DroneCommandKind::SPEED) {
+			move_speed = command.arguments[0];
+		}
+		tello_command = formatDroneCommand(command);
+	}
+
+	tello_pending = (tello_swarm != nullptr) ? tello_swarm->submit(swarm_drone, tello_command) :
+											   tello_drone->submit(tello_command);
+}
+
+
+// Wait until the Tello has responded to every command submitted to it.
+// As the Tello handles commands in the order they were submitted, this only needs to wait for the
+// last one.
+
+void TelloBackend::waitForCommands()
+{
+	if (tello_pending.valid()) {
+		tello_pending.get();
+	}
+}
+
+
+// Display the Tello's response times once it has responded to every command.
+
+void TelloBackend::finishExecution()
+{
+	waitForCommands();
+
+	if (tello_swarm != nullptr) {
+		tello_swarm->displayLatencyReport(swarm_drone);
+	}
+	else if (tello_drone != nullptr) {
+		tello_drone->displayLatencyReport();
+	}
+}
+
+
+// Connect to the Tello, or put the swarm's drone into SDK mode by sending it "command".
+
+void TelloBackend::initialize()
+{
+	if (tello_swarm != nullptr) {
+		tello_pending = tello_swarm->submit(swarm_drone, "command");
+	}
+	else if (tello_drone == nullptr) {
+		tello_drone = new Tello();
+		if (!tello_drone->canInitialize()) {
+			cout << "Tello initialization failed" << endl;
+			delete tello_drone;
+			tello_drone = nullptr;
+		}
+	}
+	else {
+		cout << "Tello is already initialized" << endl;
+	}
+}
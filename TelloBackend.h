@@ -0,0 +1,56 @@
+#ifndef TELLO_BACKEND_H
+#define TELLO_BACKEND_H
+
+
+#include "DroneBackend.h"
+#include <chrono>
+#include <future>
+#include <string>
+
+
+// TelloBackend class version 1.3
+
+// Sends FPL drone commands to a Tello, either through a Tello object created when an
+// "<initialize>" drone command is executed, or to one drone of a started TelloSwarm.
+// Generic FPL drone commands are translated into Tello-specific commands: "move" becomes the Tello
+// "go" command, at the speed planned for the move or else the speed set by the latest "arm" or
+// "speed" command, and "arm" (as used in the Tello smartphone app) becomes a "speed" command.
+// Commands other than "<initialize>" are submitted without waiting for the Tello's response, so the
+// program and the other backends can continue while the Tello responds; see waitForCommands().
+
+
+class Tello;
+class TelloSwarm;
+
+
+class TelloBackend : public DroneBackend
+{
+public:		// member functions intended to be used by clients of the class
+
+	TelloBackend();									// constructor
+	TelloBackend(TelloSwarm& swarm, int drone);		// constructor
+	~TelloBackend();								// destructor
+
+	TelloBackend(const TelloBackend&) = delete;
+	TelloBackend& operator=(const TelloBackend&) = delete;
+
+	const char* name() const override;
+	void        sendCommand(const DroneCommand& command) override;
+	void        waitForCommands() override;
+	void        finishExecution() override;
+
+private:	// member functions not intended to be used by clients of the class
+
+	void initialize();
+
+private:	// data members should always have private scope
+
+	Tello*            tello_drone{ nullptr };	// dynamically instantiated Tello object
+	TelloSwarm*       tello_swarm{ nullptr };	// if not null, commands go to a drone of this swarm
+	int               swarm_drone{ 0 };			// the swarm's number for the drone this backend controls
+	int               move_speed{ 30 };			// speed in cm/s of a move without a planned speed
+	std::future<bool> tello_pending;			// result of the last command submitted to the Tello
+};
+
+
+#endif // TELLO_BACKEND_H
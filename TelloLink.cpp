@@ -0,0 +1,241 @@
+#include "TelloLink.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+
+// TelloLinkStatistics class version 1.1
+
+
+using std::cout;
+using std::endl;
+using std::size_t;
+using std::string;
+using std::vector;
+
+
+// Return whether sending a command twice has the same effect as sending it once, so that it can be
+// sent again if its response appears to be lost. Queries (ending in '?') and settings can be
+// repeated; motion commands and anything unrecognized cannot, as a lost response would then move
+// the drone twice.
+
+bool isRepeatableCommand(const string& command)
+{
+	static const char* const REPEATABLE[]{ "command", "speed", "streamon", "streamoff", "mon", "moff",
+										   "mdirection", "wifi", "ap", "emergency" };
+
+	if (!command.empty() && (command.back() == '?')) {
+		return true;
+	}
+
+	const string name{ command.substr(0, command.find(' ')) };
+
+	for (const char* repeatable : REPEATABLE) {
+		if (name == repeatable) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+// Return the length of a vector.
+
+static double vectorLength(double x, double y, double z)
+{
+	return std::sqrt(x * x + y * y + z * z);
+}
+
+
+// Return how long to wait for the Tello's response to a command, in ms. The Tello only responds to
+// a motion command once the drone has stopped, so the time its flight takes at the command's speed
+// is added to the maximum response time. A move without a speed of its own, such as "forward 100",
+// is assumed to be flown at the Tello's slowest speed, as are "takeoff" and "land" over the height
+// of a takeoff, and a "curve" is taken to be as long as the two straight lines through its points.
+
+int responseTimeoutMs(const string& command, int max_timeout_ms)
+{
+	static const char* const DIRECTIONS[]{ "up", "down", "left", "right", "forward", "back" };
+	static const double      MIN_SPEED{ 10.0 };		// slowest Tello speed in cm/s
+	static const double      TAKEOFF_HEIGHT{ 80.0 };	// height the Tello climbs to on "takeoff" in cm
+
+	std::istringstream words(command);
+	string             name;
+	vector<double>     values;
+	double             value;
+
+	words >> name;
+	while (words >> value) {
+		values.push_back(value);
+	}
+
+	double distance{ 0.0 };
+	double speed{ MIN_SPEED };
+
+	if ((name == "go") && (values.size() >= 4)) {
+		distance = vectorLength(values[0], values[1], values[2]);
+		speed    = values[3];
+	}
+	else if ((name == "curve") && (values.size() >= 7)) {
+		distance = vectorLength(values[0], values[1], values[2]) +
+				   vectorLength(values[3] - values[0], values[4] - values[1], values[5] - values[2]);
+		speed    = values[6];
+	}
+	else if (((name == "takeoff") || (name == "land")) && values.empty()) {
+		distance = TAKEOFF_HEIGHT;
+	}
+	else if (values.size() == 1) {
+		for (const char* direction : DIRECTIONS) {
+			if (name == direction) {
+				distance = values[0];
+			}
+		}
+	}
+
+	if ((distance <= 0.0) || (speed <= 0.0)) {
+		return max_timeout_ms;
+	}
+
+	return max_timeout_ms + static_cast<int>(std::ceil(1000.0 * distance / speed));
+}
+
+
+// Return whether a response can belong to a command: a query is answered with a value or an
+// error, and any other command with "ok" or an error. A response that cannot belong to the command
+// was sent for an earlier one, after that command had timed out or had been sent twice.
+
+bool responseMatchesCommand(const string& command, const string& response)
+{
+	if (response.compare(0, 5, "error") == 0) {
+		return true;
+	}
+
+	if (!command.empty() && (command.back() == '?')) {
+		return response != "ok";
+	}
+
+	return response == "ok";
+}
+
+
+// Return the value below which the given fraction of the sorted latencies lie.
+
+static float percentile(const vector<float>& sorted_latencies, double fraction)
+{
+	const size_t index{ static_cast<size_t>(fraction * double(sorted_latencies.size() - 1) + 0.5) };
+
+	return sorted_latencies[index];
+}
+
+
+// Return the current retransmission timeout in milliseconds.
+
+double TelloLinkStatistics::retransmissionTimeout() const
+{
+	return rto_ms;
+}
+
+
+// Update the smoothed round trip time, its variation and the retransmission timeout with a new
+// round trip time measurement, as TCP does (RFC 6298).
+// Only commands answered without being sent again may be measured, as it is otherwise unknown
+// which transmission was answered (Karn's algorithm).
+
+void TelloLinkStatistics::roundTripMeasured(double round_trip_ms)
+{
+	if (!has_rtt_sample) {
+		srtt_ms        = round_trip_ms;
+		rttvar_ms      = round_trip_ms / 2.0;
+		has_rtt_sample = true;
+	}
+	else {
+		rttvar_ms = 0.75 * rttvar_ms + 0.25 * std::abs(srtt_ms - round_trip_ms);
+		srtt_ms   = 0.875 * srtt_ms + 0.125 * round_trip_ms;
+	}
+
+	rto_ms = srtt_ms + std::max(CLOCK_GRANULARITY_MS, 4.0 * rttvar_ms);
+	rto_ms = std::min(std::max(rto_ms, MIN_RTO_MS), MAX_RTO_MS);
+}
+
+
+// Keep the doubled timeout reached by a command that had to be sent again, until a round trip is
+// measured.
+
+void TelloLinkStatistics::timeoutBackedOff(double timeout_ms)
+{
+	rto_ms = std::min(timeout_ms, MAX_RTO_MS);
+}
+
+
+// Record the time from first sending a command to receiving its response.
+
+void TelloLinkStatistics::commandAnswered(bool repeatable, double response_ms)
+{
+	(repeatable ? setting_latencies : motion_latencies).push_back(float(response_ms));
+}
+
+
+// Count a command sent again after its retransmission timeout expired.
+
+void TelloLinkStatistics::commandRetransmitted()
+{
+	retransmissions++;
+}
+
+
+// Count a command that received no response.
+
+void TelloLinkStatistics::commandTimedOut()
+{
+	timeouts++;
+}
+
+
+// Count responses discarded because they belong to an earlier command.
+
+void TelloLinkStatistics::responsesDiscarded(long long num_responses)
+{
+	stale_responses += num_responses;
+}
+
+
+// Display the 50th, 90th and 99th percentile and maximum response times of the commands sent so
+// far, separately for repeatable commands (which measure the link) and for motion commands (to
+// which the Tello responds only once the motion is complete), together with the retransmission
+// counts and the number of queries answered from the Tello state instead.
+
+void TelloLinkStatistics::display(long long local_answers, long long state_packets) const
+{
+	if (setting_latencies.empty() && motion_latencies.empty()) {
+		return;
+	}
+
+	cout << endl << "Tello response times: [commands | count | 50% ms | 90% ms | 99% ms | max ms]" << endl << endl;
+
+	const std::pair<const char*, const vector<float>*> groups[]{ { "settings and queries", &setting_latencies },
+																 { "motion", &motion_latencies } };
+
+	cout << std::fixed << std::setprecision(1);
+	for (const auto& group : groups) {
+		vector<float> sorted_latencies{ *group.second };
+		if (sorted_latencies.empty()) {
+			continue;
+		}
+		std::sort(sorted_latencies.begin(), sorted_latencies.end());
+		cout << "    " << std::left << std::setw(22) << group.first << std::right
+			 << std::setw(8) << sorted_latencies.size()
+			 << std::setw(10) << percentile(sorted_latencies, 0.50)
+			 << std::setw(10) << percentile(sorted_latencies, 0.90)
+			 << std::setw(10) << percentile(sorted_latencies, 0.99)
+			 << std::setw(10) << sorted_latencies.back() << endl;
+	}
+
+	cout << endl << "    " << retransmissions << " retransmissions, " << timeouts << " timeouts, "
+		 << stale_responses << " late responses discarded, retransmission timeout " << rto_ms << " ms" << endl;
+	cout << "    " << local_answers << " queries answered from " << state_packets << " Tello state packets" << endl;
+	cout << std::defaultfloat << std::setprecision(6);
+}
@@ -0,0 +1,70 @@
+#ifndef TELLO_LINK_H
+#define TELLO_LINK_H
+
+
+#include <string>
+#include <vector>
+
+
+// TelloLinkStatistics class version 1.1
+
+// The Tello command protocol rules and link measurements shared by Tello, which talks to one
+// drone, and TelloSwarm, which talks to many from one event loop.
+// The Tello's responses carry no sequence numbers, so a response is matched to the command waiting
+// for it by its form, and only commands that can safely be repeated are ever sent twice.
+
+
+// Return whether sending a command twice has the same effect as sending it once.
+
+bool isRepeatableCommand(const std::string& command);
+
+
+// Return whether a response can be the Tello's response to a command.
+
+bool responseMatchesCommand(const std::string& command, const std::string& response);
+
+
+// Return how long to wait for the Tello's response to a command, in ms, allowing a motion command
+// the time its flight may take on top of the maximum response time.
+
+int responseTimeoutMs(const std::string& command, int max_timeout_ms);
+
+
+// The retransmission timeout and the response time measurements of the link to one Tello.
+
+class TelloLinkStatistics
+{
+public:		// member functions intended to be used by clients of the class
+
+	double retransmissionTimeout() const;
+
+	void roundTripMeasured(double round_trip_ms);
+	void timeoutBackedOff(double timeout_ms);
+	void commandAnswered(bool repeatable, double response_ms);
+	void commandRetransmitted();
+	void commandTimedOut();
+	void responsesDiscarded(long long num_responses);
+
+	void display(long long local_answers, long long state_packets) const;
+
+private:	// data members should always have private scope
+
+	const double INITIAL_RTO_MS{ 1000.0 };		// retransmission timeout before any round trip is measured
+	const double MIN_RTO_MS{ 100.0 };			// lower bound of the retransmission timeout
+	const double MAX_RTO_MS{ 5000.0 };			// upper bound of the retransmission timeout
+	const double CLOCK_GRANULARITY_MS{ 1.0 };	// lower bound of the round trip variation term
+
+	double srtt_ms{ 0.0 };						// smoothed round trip time
+	double rttvar_ms{ 0.0 };					// round trip time variation
+	double rto_ms{ INITIAL_RTO_MS };			// current retransmission timeout
+	bool   has_rtt_sample{ false };				// srtt_ms and rttvar_ms hold a measurement
+
+	std::vector<float> setting_latencies;		// response times in ms of commands that can be repeated
+	std::vector<float> motion_latencies;		// response times in ms of motion commands
+	long long          retransmissions{ 0 };	// commands sent again after a retransmission timeout
+	long long          timeouts{ 0 };			// commands that received no response
+	long long          stale_responses{ 0 };	// responses discarded as belonging to an earlier command
+};
+
+
+#endif // TELLO_LINK_H
@@ -0,0 +1,960 @@
+#include "TelloSwarm.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+
+// TelloSwarm class version 1.3
+
+// Submitted commands are handed to the event loop through a short mutex-protected list; the loop
+// moves them to the drones' queues, so the drones' protocol state belongs to the loop thread alone.
+// Each loop iteration takes the submitted commands, receives every datagram waiting, expires the
+// retransmission timeouts that have passed, starts the next command of every idle drone and then
+// sends every datagram this produced, before sleeping until the next datagram, submission or timer.
+// With many drones one iteration typically sends and receives many datagrams, which is why the
+// Linux version uses sendmmsg() and recvmmsg(): one system call per batch rather than per drone.
+
+
+using std::cout;
+using std::endl;
+using std::future;
+using std::lock_guard;
+using std::mutex;
+using std::promise;
+using std::size_t;
+using std::string;
+using std::vector;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+
+// Return a description of the last socket error.
+
+static string lastSocketError()
+{
+#ifdef _WIN32
+	return "error code " + std::to_string(WSAGetLastError());
+#else
+	return strerror(errno);
+#endif
+}
+
+
+// Return whether the last socket error means that the socket's send buffer is full.
+
+static bool sendWouldBlock()
+{
+#ifdef _WIN32
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return (errno == EAGAIN) || (errno == EWOULDBLOCK);
+#endif
+}
+
+
+// Return the key of an IPv4 address and port in drones_by_address.
+
+static unsigned long long addressKey(const sockaddr_in& address)
+{
+	return (static_cast<unsigned long long>(ntohl(address.sin_addr.s_addr)) << 16) | ntohs(address.sin_port);
+}
+
+
+// Return the time point a number of (possibly fractional) milliseconds after another.
+
+static steady_clock::time_point millisecondsAfter(steady_clock::time_point time, double interval_ms)
+{
+	return time + std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double, std::milli>(interval_ms));
+}
+
+
+// The TelloSwarm constructor records the local ports to use, without creating any socket; add the
+// drones with addDrone() and then call start().
+
+TelloSwarm::TelloSwarm(unsigned short local_port, unsigned short state_port) :
+	local_port(local_port),
+	state_port(state_port)
+{}
+
+
+// The TelloSwarm destructor stops the event loop and closes the sockets.
+
+TelloSwarm::~TelloSwarm()
+{
+	stop();
+}
+
+
+// Add a drone with the given IP address and command port and return its drone number, which is
+// used to submit its commands; drones are numbered from 0 in the order they are added.
+// Drones must be added before start(). Returns -1, after writing a diagnostic message, if the
+// address is invalid or already used by another drone.
+
+int TelloSwarm::addDrone(const string& tello_ip, unsigned short tello_port)
+{
+	if (loop_thread.joinable()) {
+		cout << "Tello " << tello_ip << " must be added before the swarm is started" << endl;
+		return -1;
+	}
+
+	std::unique_ptr<SwarmDrone> drone{ new SwarmDrone };
+
+	drone->address.sin_family = AF_INET;
+	drone->address.sin_port   = htons(tello_port);
+
+	if (inet_pton(AF_INET, tello_ip.c_str(), &drone->address.sin_addr.s_addr) != 1) {
+		cout << "Invalid Tello IP address " << tello_ip << endl;
+		return -1;
+	}
+
+	const int drone_number{ static_cast<int>(drones.size()) };
+
+	if (!drones_by_address.emplace(addressKey(drone->address), drone_number).second) {
+		cout << "Tello " << tello_ip << ':' << tello_port << " is already part of the swarm" << endl;
+		return -1;
+	}
+
+	// State packets are sent from a port of their own, so they are matched to a drone by IP address
+	// alone when the address is not shared (as it is with drones emulated on one computer).
+
+	const unsigned long ip{ ntohl(drone->address.sin_addr.s_addr) };
+	const auto          ip_entry{ drones_by_ip.emplace(ip, drone_number) };
+
+	if (!ip_entry.second) {
+		ip_entry.first->second = -1;
+	}
+
+	drones.push_back(std::move(drone));
+
+	return drone_number;
+}
+
+
+// Return the number of drones added.
+
+int TelloSwarm::numDrones() const
+{
+	return static_cast<int>(drones.size());
+}
+
+
+// Open the command and state sockets, start the event loop and put every drone into SDK mode by
+// sending it "command".
+// Returns true only if every drone responds; otherwise diagnostic messages name the drones that
+// did not, and the swarm remains started so that their commands still fail individually.
+
+bool TelloSwarm::start()
+{
+	if (drones.empty()) {
+		cout << "The Tello swarm has no drones" << endl;
+		return false;
+	}
+
+	stop();
+	stopping = false;
+
+	if (!openSockets()) {
+		closeSockets();
+		return false;
+	}
+
+	receive_buffers.assign(size_t(BATCH_SIZE) * BUFFER_SIZE, '\0');
+
+	{
+		lock_guard<mutex> lock(submit_mutex);
+		accepting = true;
+	}
+
+	loop_thread = std::thread(&TelloSwarm::eventLoop, this);
+
+	vector<future<bool>> responses;
+
+	for (int drone{ 0 }; drone < numDrones(); drone++) {
+		responses.push_back(submit(drone, "command"));
+	}
+
+	bool all_responded{ true };
+
+	for (int drone{ 0 }; drone < numDrones(); drone++) {
+		if (!responses[drone].get()) {
+			cout << "Tello " << drone << " of the swarm not responding" << endl;
+			all_responded = false;
+		}
+	}
+
+	return all_responded;
+}
+
+
+// Stop the event loop if it is running, failing the commands not yet finished, and close the
+// sockets. The drones' latest state and statistics remain available.
+
+void TelloSwarm::stop()
+{
+	{
+		lock_guard<mutex> lock(submit_mutex);
+		accepting = false;
+	}
+
+	stopping = true;
+
+	if (loop_thread.joinable()) {
+#ifndef _WIN32
+		const eventfd_t stop_request{ 1 };
+		if (write(wake_fd, &stop_request, sizeof(stop_request)) != sizeof(stop_request)) {
+			cout << "Failed to stop the Tello swarm event loop (" << lastSocketError() << ')' << endl;
+		}
+#endif
+		loop_thread.join();
+	}
+
+	// Commands submitted after the event loop last took them are failed here.
+
+	takeSubmittedCommands();
+	failCommands();
+	closeSockets();
+}
+
+
+// Queue a command for a drone and return a future that becomes ready with its result: true if the
+// drone responds with "ok" (or, for a query, a value) within MAX_TIMEOUT_MS, plus the flight time of
+// a motion command (see responseTimeoutMs()), otherwise false after a diagnostic message has been
+// written to the console.
+// Queries that the drone's state answers are answered without sending them.
+// Commands for one drone are sent in the order they are submitted, one at a time; commands for
+// different drones are sent independently of each other.
+
+future<bool> TelloSwarm::submit(int drone, const string& command)
+{
+	promise<bool> result;
+	future<bool>  ready{ result.get_future() };
+
+	if ((drone < 0) || (drone >= numDrones())) {
+		cout << "Tello " << drone << " is not part of the swarm - \"" << command << "\" not sent" << endl;
+		result.set_value(false);
+		return ready;
+	}
+
+	// Answer a query from the drone's state if a recent state packet holds the value, unless the
+	// drone has not yet carried out the commands submitted before it.
+
+	TelloState state;
+	string     answer;
+
+	if ((drones[drone]->pending_commands == 0) && drones[drone]->state.load(state) &&
+		(TelloTelemetry::steadyClockMilliseconds() - state.received_ms <= MAX_STATE_AGE_MS) &&
+		TelloTelemetry::formatQueryAnswer(state, command, answer)) {
+		drones[drone]->local_answers++;
+		if (command_echo) {
+			cout << "Answering \"" << command << "\" for Tello " << drone << " from its state: " << answer << endl;
+		}
+		result.set_value(true);
+		return ready;
+	}
+
+	if (command_echo) {
+		cout << "Sending \"" << command << "\" to Tello " << drone << endl;
+	}
+
+	bool queued{ false };
+
+	{
+		lock_guard<mutex> lock(submit_mutex);
+
+		if (accepting) {
+			QueuedCommand queued_command;
+
+			queued_command.drone   = drone;
+			queued_command.command = command;
+			queued_command.result  = std::move(result);
+			submitted.push_back(std::move(queued_command));
+			drones[drone]->pending_commands++;
+			queued = true;
+		}
+	}
+
+	if (!queued) {
+		cout << "Tello swarm not started - \"" << command << "\" not sent" << endl;
+		result.set_value(false);
+		return ready;
+	}
+
+#ifndef _WIN32
+	const eventfd_t submission{ 1 };
+	if (write(wake_fd, &submission, sizeof(submission)) != sizeof(submission)) {
+		cout << "Failed to wake the Tello swarm event loop (" << lastSocketError() << ')' << endl;
+	}
+#endif
+
+	return ready;
+}
+
+
+// Copy the latest state received from a drone into the argument and return true, or return false
+// if no state has been received from it yet. This never waits for the event loop.
+
+bool TelloSwarm::latestState(int drone, TelloState& state) const
+{
+	return (drone >= 0) && (drone < numDrones()) && drones[drone]->state.load(state);
+}
+
+
+// Select whether each command submitted, or query answered from a drone's state, is written to the
+// console. Diagnostic messages are always written.
+
+void TelloSwarm::setCommandEcho(bool echo)
+{
+	command_echo = echo;
+}
+
+
+// Display the response times of the commands sent to a drone so far and its retransmission counts.
+
+void TelloSwarm::displayLatencyReport(int drone)
+{
+	if ((drone < 0) || (drone >= numDrones())) {
+		return;
+	}
+
+	lock_guard<mutex> lock(statistics_mutex);
+
+	cout << endl << "Tello " << drone << " of the swarm:";
+	drones[drone]->statistics.display(drones[drone]->local_answers, drones[drone]->state_packets);
+}
+
+
+// Create the command and state sockets and bind them to the local ports, and on Linux create the
+// epoll instance watching them and the eventfd used to wake the event loop.
+// Returns false, after writing a diagnostic message, if any of these fail.
+
+bool TelloSwarm::openSockets()
+{
+	sockaddr_in command_addr{};
+	sockaddr_in state_addr{};
+
+	command_addr.sin_family      = AF_INET;
+	command_addr.sin_port        = htons(local_port);
+	command_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+	state_addr.sin_family      = AF_INET;
+	state_addr.sin_port        = htons(state_port);
+	state_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+#ifdef _WIN32
+	WSADATA wsa_data;
+
+	if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+		cout << "Tello swarm WSAStartup failed" << endl;
+		return false;
+	}
+
+	wsa_started    = true;
+	socket_command = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	socket_state   = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+	u_long non_blocking{ 1 };
+
+	if ((socket_command == INVALID_SOCKET) || (socket_state == INVALID_SOCKET) ||
+		(ioctlsocket(socket_command, FIONBIO, &non_blocking) != 0) ||
+		(ioctlsocket(socket_state, FIONBIO, &non_blocking) != 0)) {
+		cout << "Error creating Tello swarm sockets (" << lastSocketError() << ')' << endl;
+		return false;
+	}
+#else
+	socket_command = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+	socket_state   = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+
+	if ((socket_command < 0) || (socket_state < 0)) {
+		cout << "Error creating Tello swarm sockets (" << lastSocketError() << ')' << endl;
+		return false;
+	}
+#endif
+
+	if (::bind(socket_command, (sockaddr*)&command_addr, sizeof(command_addr)) != 0) {
+		cout << "Binding of Tello swarm socket to port " << local_port << " failed (" << lastSocketError() << ')' << endl;
+		return false;
+	}
+
+	if (::bind(socket_state, (sockaddr*)&state_addr, sizeof(state_addr)) != 0) {
+		cout << "Binding of Tello swarm state socket to port " << state_port << " failed (" << lastSocketError() << ')' << endl;
+		return false;
+	}
+
+#ifndef _WIN32
+	wake_fd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+	bool watching{ (wake_fd >= 0) && (epoll_fd >= 0) };
+
+	for (int fd : { socket_command, socket_state, wake_fd }) {
+		epoll_event event{};
+
+		event.events  = EPOLLIN;
+		event.data.fd = fd;
+		watching      = watching && (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0);
+	}
+
+	if (!watching) {
+		cout << "Error creating Tello swarm event loop (" << lastSocketError() << ')' << endl;
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+
+// Close the sockets and, on Linux, the epoll instance and the eventfd.
+
+void TelloSwarm::closeSockets()
+{
+#ifdef _WIN32
+	for (SOCKET* socket : { &socket_command, &socket_state }) {
+		if (*socket != INVALID_SOCKET) {
+			closesocket(*socket);
+			*socket = INVALID_SOCKET;
+		}
+	}
+	if (wsa_started) {
+		WSACleanup();
+		wsa_started = false;
+	}
+#else
+	for (int* fd : { &epoll_fd, &wake_fd, &socket_command, &socket_state }) {
+		if (*fd >= 0) {
+			::close(*fd);
+			*fd = -1;
+		}
+	}
+#endif
+}
+
+
+// This function runs as a separate thread, sending the commands of every drone and receiving
+// their responses and state, until stop() is called.
+
+void TelloSwarm::eventLoop()
+{
+#ifndef _WIN32
+	const int   MAX_EVENTS{ 3 };	// the two sockets and the eventfd
+	epoll_event events[MAX_EVENTS];
+#endif
+
+	while (!stopping) {
+		takeSubmittedCommands();
+
+		steady_clock::time_point now{ steady_clock::now() };
+
+		receiveDatagrams(false, now);
+		receiveDatagrams(true, now);
+		checkTimers(now);
+		startCommands(now);
+		sendDatagrams();
+
+		now = steady_clock::now();
+
+#ifdef _WIN32
+		const int timer_ms{ waitMilliseconds(now) };
+		const int wait_ms{ (timer_ms < 0) ? POLL_INTERVAL_MS : std::min(timer_ms, POLL_INTERVAL_MS) };
+
+		fd_set readable;
+		FD_ZERO(&readable);
+		FD_SET(socket_command, &readable);
+		FD_SET(socket_state, &readable);
+
+		fd_set writable;
+		FD_ZERO(&writable);
+		FD_SET(socket_command, &writable);
+
+		timeval timeout{ 0, wait_ms * 1000 };
+
+		if (select(0, &readable, send_blocked ? &writable : nullptr, nullptr, &timeout) == SOCKET_ERROR) {
+			if (stopping) {
+				break;
+			}
+			cout << "Failed to wait for Tello swarm datagrams (" << lastSocketError() << ')' << endl;
+			break;
+		}
+#else
+		const int num_events{ epoll_wait(epoll_fd, events, MAX_EVENTS, waitMilliseconds(now)) };
+
+		if (num_events < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			cout << "Failed to wait for Tello swarm datagrams (" << lastSocketError() << ')' << endl;
+			break;
+		}
+
+		for (int i{ 0 }; i < num_events; i++) {
+			if (events[i].data.fd == wake_fd) {
+				eventfd_t count;
+				if (read(wake_fd, &count, sizeof(count)) < 0) {
+					// Nothing to clear - another read already reset the counter.
+				}
+			}
+		}
+#endif
+	}
+}
+
+
+// Move the commands submitted since the last call to their drones' queues.
+
+void TelloSwarm::takeSubmittedCommands()
+{
+	vector<QueuedCommand> commands;
+
+	{
+		lock_guard<mutex> lock(submit_mutex);
+		commands.swap(submitted);
+	}
+
+	for (QueuedCommand& command : commands) {
+		drones[command.drone]->waiting.push_back(std::move(command));
+	}
+}
+
+
+// Receive every datagram waiting on the command socket, or on the state socket.
+
+void TelloSwarm::receiveDatagrams(bool state_datagrams, steady_clock::time_point now)
+{
+#ifdef _WIN32
+	const SOCKET socket_receive{ state_datagrams ? socket_state : socket_command };
+	sockaddr_in  source{};
+
+	while (true) {
+		int       source_length{ sizeof(source) };
+		const int length{ recvfrom(socket_receive, receive_buffers.data(), BUFFER_SIZE, 0,
+			(sockaddr*)&source, &source_length) };
+		if (length == SOCKET_ERROR) {
+			break;
+		}
+		datagramReceived(state_datagrams, source, receive_buffers.data(), length, now);
+	}
+#else
+	const int   socket_receive{ state_datagrams ? socket_state : socket_command };
+	mmsghdr     messages[BATCH_SIZE];
+	iovec       buffers[BATCH_SIZE];
+	sockaddr_in sources[BATCH_SIZE];
+	int         num_messages;
+
+	// A full batch suggests that more datagrams are waiting.
+
+	do {
+		for (unsigned i{ 0 }; i < BATCH_SIZE; i++) {
+			buffers[i].iov_base = &receive_buffers[size_t(i) * BUFFER_SIZE];
+			buffers[i].iov_len  = BUFFER_SIZE;
+
+			messages[i]                     = mmsghdr{};
+			messages[i].msg_hdr.msg_name    = &sources[i];
+			messages[i].msg_hdr.msg_namelen = sizeof(sources[i]);
+			messages[i].msg_hdr.msg_iov     = &buffers[i];
+			messages[i].msg_hdr.msg_iovlen  = 1;
+		}
+
+		num_messages = recvmmsg(socket_receive, messages, BATCH_SIZE, MSG_DONTWAIT, nullptr);
+
+		for (int i{ 0 }; i < num_messages; i++) {
+			datagramReceived(state_datagrams, sources[i], static_cast<const char*>(buffers[i].iov_base),
+							 static_cast<int>(messages[i].msg_len), now);
+		}
+	} while (num_messages == int(BATCH_SIZE));
+#endif
+}
+
+
+// Pass a datagram received from a drone to the drone it came from: publish a state packet, or
+// handle a response. Datagrams from unknown addresses are ignored.
+
+void TelloSwarm::datagramReceived(bool state_datagram, const sockaddr_in& source, const char* text, int length,
+								  steady_clock::time_point now)
+{
+	const int drone_number{ findDrone(source, state_datagram) };
+
+	if (drone_number < 0) {
+		return;
+	}
+
+	SwarmDrone& drone{ *drones[drone_number] };
+
+	if (state_datagram) {
+		TelloState state;
+		drone.state.load(state);		// keys missing from the packet keep their previous values
+		if (TelloTelemetry::parseState(text, length, state)) {
+			state.received_ms = TelloTelemetry::steadyClockMilliseconds();
+			drone.state.store(state);
+			drone.state_packets++;
+		}
+		return;
+	}
+
+	// Strip the line end some Tello firmware appends to responses.
+
+	while ((length > 0) && ((text[length - 1] == '\r') || (text[length - 1] == '\n'))) {
+		length--;
+	}
+
+	responseReceived(drone, string(text, length), now);
+}
+
+
+// Finish a drone's command if the response belongs to it, or discard the response as belonging to
+// an earlier command. Only repeatable commands answered without being sent again update the
+// retransmission timeout (Karn's algorithm).
+
+void TelloSwarm::responseReceived(SwarmDrone& drone, const string& response, steady_clock::time_point now)
+{
+	if (!drone.in_flight || (drone.transmissions == 0) || !responseMatchesCommand(drone.current.command, response)) {
+		lock_guard<mutex> lock(statistics_mutex);
+		drone.statistics.responsesDiscarded(1);
+		return;
+	}
+
+	const double latency_ms{ std::chrono::duration<double, std::milli>(now - drone.first_sent).count() };
+
+	{
+		lock_guard<mutex> lock(statistics_mutex);
+
+		drone.statistics.commandAnswered(drone.repeatable, latency_ms);
+
+		if (drone.repeatable) {
+			if (drone.transmissions == 1) {
+				drone.statistics.roundTripMeasured(latency_ms);
+			}
+			else {
+				drone.statistics.timeoutBackedOff(drone.timeout_ms);
+				drone.discard_until = millisecondsAfter(now, drone.statistics.retransmissionTimeout());
+			}
+		}
+	}
+
+	// Ensure that the Tello responds with "ok" (or a value) rather than "error".
+
+	const bool succeeded{ response.compare(0, 5, "error") != 0 };
+
+	if (!succeeded) {
+		cout << "Tello " << drone.current.drone << " returned \"" << response << "\" for \""
+			 << drone.current.command << "\" command" << endl;
+	}
+
+	drone.in_flight = false;
+	finishCommand(drone, drone.current, succeeded);
+}
+
+
+// Send again the repeatable commands whose retransmission timeout has expired, and fail the
+// commands that have not been answered within their response timeout. The timers of a command only
+// run once its first datagram has been sent, and a failed command's unsent datagram is dropped.
+
+void TelloSwarm::checkTimers(steady_clock::time_point now)
+{
+	for (const std::unique_ptr<SwarmDrone>& drone_pointer : drones) {
+		SwarmDrone& drone{ *drone_pointer };
+
+		if (!drone.in_flight || (drone.transmissions == 0)) {
+			continue;
+		}
+
+		if (now >= drone.give_up) {
+			cout << "Tello " << drone.current.drone << " did not respond to \"" << drone.current.command
+				 << "\" after " << (drone.response_timeout_ms / 1000.0) << " seconds" << endl;
+
+			if (drone.unsent) {
+				removeDatagrams(drone.current.drone);
+			}
+
+			lock_guard<mutex> lock(statistics_mutex);
+			drone.statistics.commandTimedOut();
+			if (drone.transmissions > 1) {
+				drone.discard_until = millisecondsAfter(now, drone.statistics.retransmissionTimeout());
+			}
+			drone.in_flight = false;
+			finishCommand(drone, drone.current, false);
+		}
+		else if (drone.repeatable && !drone.unsent && (now >= drone.retransmit_at)) {
+			drone.timeout_ms = std::min(2.0 * drone.timeout_ms, double(MAX_TIMEOUT_MS));
+			drone.unsent     = true;
+			outgoing.push_back(OutgoingDatagram{ drone.current.drone, drone.current.command });
+
+			lock_guard<mutex> lock(statistics_mutex);
+			drone.statistics.commandRetransmitted();
+		}
+	}
+}
+
+
+// Start the next command of every drone that has no command in flight and is not waiting for late
+// responses to a command sent more than once.
+
+void TelloSwarm::startCommands(steady_clock::time_point now)
+{
+	for (const std::unique_ptr<SwarmDrone>& drone_pointer : drones) {
+		SwarmDrone& drone{ *drone_pointer };
+
+		if (drone.in_flight || drone.waiting.empty() || (now < drone.discard_until)) {
+			continue;
+		}
+
+		drone.current = std::move(drone.waiting.front());
+		drone.waiting.pop_front();
+
+		{
+			lock_guard<mutex> lock(statistics_mutex);
+			drone.timeout_ms = drone.statistics.retransmissionTimeout();
+		}
+
+		drone.in_flight           = true;
+		drone.unsent              = true;
+		drone.repeatable          = isRepeatableCommand(drone.current.command);
+		drone.transmissions       = 0;
+		drone.response_timeout_ms = responseTimeoutMs(drone.current.command, MAX_TIMEOUT_MS);
+		outgoing.push_back(OutgoingDatagram{ drone.current.drone, drone.current.command });
+	}
+}
+
+
+// Send the datagrams queued during this loop iteration, starting the timers of their commands. A
+// datagram that cannot be sent fails its command, except that a repeatable command is left to its
+// retransmission timer. If the send buffer is full the unsent datagrams are kept, without failing
+// their commands, until the command socket becomes writable.
+
+void TelloSwarm::sendDatagrams()
+{
+	size_t num_sent{ 0 };
+	bool   would_block{ false };
+
+#ifdef _WIN32
+	for (; num_sent < outgoing.size(); num_sent++) {
+		const OutgoingDatagram& datagram{ outgoing[num_sent] };
+		if (sendto(socket_command, datagram.text.c_str(), static_cast<int>(datagram.text.length()), 0,
+			(sockaddr*)&drones[datagram.drone]->address, sizeof(sockaddr_in)) == SOCKET_ERROR) {
+			would_block = sendWouldBlock();
+			break;
+		}
+	}
+#else
+	mmsghdr messages[BATCH_SIZE];
+	iovec   buffers[BATCH_SIZE];
+
+	while (num_sent < outgoing.size()) {
+		const unsigned batch_size{ static_cast<unsigned>(std::min(outgoing.size() - num_sent, size_t(BATCH_SIZE))) };
+
+		for (unsigned i{ 0 }; i < batch_size; i++) {
+			OutgoingDatagram& datagram{ outgoing[num_sent + i] };
+
+			buffers[i].iov_base = &datagram.text[0];
+			buffers[i].iov_len  = datagram.text.length();
+
+			messages[i]                     = mmsghdr{};
+			messages[i].msg_hdr.msg_name    = &drones[datagram.drone]->address;
+			messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+			messages[i].msg_hdr.msg_iov     = &buffers[i];
+			messages[i].msg_hdr.msg_iovlen  = 1;
+		}
+
+		const int result{ sendmmsg(socket_command, messages, batch_size, 0) };
+
+		if (result <= 0) {
+			if ((result < 0) && (errno == EINTR)) {
+				continue;
+			}
+			would_block = (result < 0) && sendWouldBlock();
+			break;
+		}
+		num_sent += result;
+	}
+#endif
+
+	const steady_clock::time_point now{ steady_clock::now() };
+
+	for (size_t i{ 0 }; i < num_sent; i++) {
+		datagramSent(*drones[outgoing[i].drone], now);
+	}
+
+	// Report the datagram that could not be sent and retry the rest on the next iteration; a
+	// motion command that was never sent must not wait for its response.
+
+	if (would_block) {
+		watchWritable(true);
+	}
+	else if (num_sent < outgoing.size()) {
+		SwarmDrone& drone{ *drones[outgoing[num_sent].drone] };
+
+		cout << "Failed to send \"" << outgoing[num_sent].text << "\" to Tello " << outgoing[num_sent].drone
+			 << " (" << lastSocketError() << ')' << endl;
+
+		if (drone.repeatable) {
+			datagramSent(drone, now);
+		}
+		else {
+			drone.in_flight = false;
+			drone.unsent    = false;
+			finishCommand(drone, drone.current, false);
+		}
+		num_sent++;
+	}
+
+	outgoing.erase(outgoing.begin(), outgoing.begin() + num_sent);
+
+	if (outgoing.empty()) {
+		watchWritable(false);
+	}
+}
+
+
+// Start the timers of a drone's command once one of its datagrams has left the command socket: the
+// response timeout runs from the first transmission and the retransmission timeout from each one.
+
+void TelloSwarm::datagramSent(SwarmDrone& drone, steady_clock::time_point now)
+{
+	if (drone.transmissions == 0) {
+		drone.first_sent = now;
+		drone.give_up    = now + milliseconds(drone.response_timeout_ms);
+	}
+
+	drone.transmissions++;
+	drone.retransmit_at = millisecondsAfter(now, drone.timeout_ms);
+	drone.unsent        = false;
+}
+
+
+// Remove a drone's datagram from those waiting to be sent, once its command has failed.
+
+void TelloSwarm::removeDatagrams(int drone)
+{
+	outgoing.erase(std::remove_if(outgoing.begin(), outgoing.end(),
+		[drone](const OutgoingDatagram& datagram) { return datagram.drone == drone; }), outgoing.end());
+
+	drones[drone]->unsent = false;
+}
+
+
+// Start or stop waking the event loop when the command socket becomes writable, which it only needs
+// while datagrams are held back by a full send buffer.
+
+void TelloSwarm::watchWritable(bool writable)
+{
+	if (writable == send_blocked) {
+		return;
+	}
+
+	send_blocked = writable;
+
+#ifndef _WIN32
+	epoll_event event{};
+
+	event.events  = writable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+	event.data.fd = socket_command;
+
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, socket_command, &event) != 0) {
+		cout << "Failed to watch the Tello swarm command socket (" << lastSocketError() << ')' << endl;
+	}
+#endif
+}
+
+
+// Return how long the event loop can sleep before the next timer of a drone expires, or -1 if no
+// timer is running.
+
+int TelloSwarm::waitMilliseconds(steady_clock::time_point now) const
+{
+	if (!outgoing.empty() && !send_blocked) {
+		return 0;
+	}
+
+	bool                     has_timer{ false };
+	steady_clock::time_point next_timer{ steady_clock::time_point::max() };
+
+	for (const std::unique_ptr<SwarmDrone>& drone : drones) {
+		if (drone->in_flight) {
+			if (drone->transmissions > 0) {
+				const bool retransmitting{ drone->repeatable && !drone->unsent };
+				next_timer = std::min(next_timer, retransmitting ? std::min(drone->retransmit_at, drone->give_up) : drone->give_up);
+				has_timer  = true;
+			}
+		}
+		else if (!drone->waiting.empty()) {
+			next_timer = std::min(next_timer, drone->discard_until);
+			has_timer  = true;
+		}
+	}
+
+	if (!has_timer) {
+		return -1;
+	}
+	if (next_timer <= now) {
+		return 0;
+	}
+
+	// Round up, so that the loop does not wake just before the timer expires.
+
+	return static_cast<int>(std::chrono::duration_cast<milliseconds>(next_timer - now).count()) + 1;
+}
+
+
+// Return the number of the drone that sent a datagram, or -1 if it is not part of the swarm.
+// Responses come from the drone's command port; state packets are matched by IP address and port
+// first, as emulated drones share an IP address, and then by IP address alone.
+
+int TelloSwarm::findDrone(const sockaddr_in& source, bool state_datagram) const
+{
+	const auto by_address{ drones_by_address.find(addressKey(source)) };
+
+	if (by_address != drones_by_address.end()) {
+		return by_address->second;
+	}
+
+	if (state_datagram) {
+		const auto by_ip{ drones_by_ip.find(ntohl(source.sin_addr.s_addr)) };
+		if (by_ip != drones_by_ip.end()) {
+			return by_ip->second;
+		}
+	}
+
+	return -1;
+}
+
+
+// Fail every command in flight or waiting; used once the event loop has ended.
+
+void TelloSwarm::failCommands()
+{
+	for (const std::unique_ptr<SwarmDrone>& drone_pointer : drones) {
+		SwarmDrone& drone{ *drone_pointer };
+
+		if (drone.in_flight) {
+			drone.in_flight = false;
+			finishCommand(drone, drone.current, false);
+		}
+		for (QueuedCommand& command : drone.waiting) {
+			finishCommand(drone, command, false);
+		}
+		drone.waiting.clear();
+	}
+	outgoing.clear();
+	send_blocked = false;
+}
+
+
+// Set the result of a drone's command, which no longer holds back the queries submitted after it.
+
+void TelloSwarm::finishCommand(SwarmDrone& drone, QueuedCommand& command, bool succeeded)
+{
+	drone.pending_commands--;
+	command.result.set_value(succeeded);
+}
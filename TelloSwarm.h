@@ -0,0 +1,180 @@
+#ifndef TELLO_SWARM_H
+#define TELLO_SWARM_H
+
+
+#include "SeqLock.h"
+#include "TelloLink.h"
+#include "TelloTelemetry.h"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+
+// TelloSwarm class version 1.3
+
+// Controls many Tello drones from a single thread. Every drone is reached through one UDP socket,
+// and the drones' responses are told apart by their source address; their state packets all
+// arrive on one state socket. One event loop sends the commands of all the drones, receives all the
+// responses and state packets, and handles every retransmission and timeout, so the number of
+// threads does not grow with the number of drones.
+// On Linux the loop sleeps in epoll_wait(), sends all the datagrams that are ready with one
+// sendmmsg() call and receives with recvmmsg(); on Windows it polls the sockets with select().
+// When the command socket's send buffer is full the unsent datagrams are kept and the loop also
+// waits for the socket to become writable, sending them on the next iteration. A command's timers
+// only start once its datagram has left the socket.
+// Each drone follows the same protocol as a Tello object: one command at a time, repeatable
+// commands sent again on a retransmission timeout, responses matched to commands by their form
+// (see TelloLink.h) and queries answered from recent state packets once the drone has carried out
+// every command submitted before them.
+// Typically each FPL program executes on its own thread with FlightPlanExecute::useTelloSwarm()
+// selecting its drone.
+
+
+class TelloSwarm
+{
+public:			// member functions intended to be used by clients of the class
+
+	TelloSwarm(unsigned short local_port = 8889, unsigned short state_port = 8890);	// constructor
+	~TelloSwarm();	// destructor
+
+	TelloSwarm(const TelloSwarm&) = delete;
+	TelloSwarm& operator=(const TelloSwarm&) = delete;
+
+	int  addDrone(const std::string& tello_ip, unsigned short tello_port = 8889);
+	int  numDrones() const;
+	bool start();
+	void stop();
+
+	std::future<bool> submit(int drone, const std::string& command);
+	bool              latestState(int drone, TelloState& state) const;
+
+	void setCommandEcho(bool echo);
+	void displayLatencyReport(int drone);
+
+private:		// member functions not intended to be used by clients of the class
+
+	struct QueuedCommand;
+	struct SwarmDrone;
+
+	bool openSockets();
+	void closeSockets();
+	void eventLoop();
+	void takeSubmittedCommands();
+	void receiveDatagrams(bool state_datagrams, std::chrono::steady_clock::time_point now);
+	void datagramReceived(bool state_datagram, const sockaddr_in& source, const char* text, int length,
+						  std::chrono::steady_clock::time_point now);
+	void responseReceived(SwarmDrone& drone, const std::string& response, std::chrono::steady_clock::time_point now);
+	void checkTimers(std::chrono::steady_clock::time_point now);
+	void startCommands(std::chrono::steady_clock::time_point now);
+	void sendDatagrams();
+	void datagramSent(SwarmDrone& drone, std::chrono::steady_clock::time_point now);
+	void removeDatagrams(int drone);
+	void watchWritable(bool writable);
+	int  waitMilliseconds(std::chrono::steady_clock::time_point now) const;
+	int  findDrone(const sockaddr_in& source, bool state_datagram) const;
+	void failCommands();
+	void finishCommand(SwarmDrone& drone, QueuedCommand& command, bool succeeded);
+
+private:		// data members should always have private scope
+
+	// A submitted command waiting for its drone.
+
+	struct QueuedCommand
+	{
+		int                drone{ 0 };		// index of the drone
+		std::string        command;			// the Tello command text
+		std::promise<bool> result;			// set once the drone has responded or the command failed
+	};
+
+	// The address, protocol state and measurements of one drone.
+	// The protocol members are used only by the event loop thread.
+
+	struct SwarmDrone
+	{
+		sockaddr_in               address{};			// the drone's command address
+		std::deque<QueuedCommand> waiting;				// commands not yet sent, oldest first
+
+		bool        in_flight{ false };				// current was sent and has not finished
+		QueuedCommand current;						// the command being sent
+		bool        repeatable{ false };			// current can be sent again
+		int         transmissions{ 0 };				// times current was sent
+		bool        unsent{ false };				// a datagram of current is waiting in outgoing
+		double      timeout_ms{ 0.0 };				// current retransmission timeout of current
+		std::chrono::steady_clock::time_point first_sent;		// when current's first datagram left the socket
+		std::chrono::steady_clock::time_point retransmit_at;	// when current is sent again
+		int         response_timeout_ms{ 0 };		// time allowed for the response to current
+		std::chrono::steady_clock::time_point give_up;			// when current fails
+		std::chrono::steady_clock::time_point discard_until;	// responses to a repeated command may still arrive
+
+		TelloLinkStatistics    statistics;			// guarded by statistics_mutex
+		SeqLock<TelloState>    state;				// the latest state received
+		std::atomic<long long> state_packets{ 0 };	// state packets received
+		std::atomic<long long> local_answers{ 0 };	// queries answered from the state
+		std::atomic<int>       pending_commands{ 0 };	// commands submitted and not yet finished
+	};
+
+	// A datagram waiting to be sent by sendDatagrams().
+
+	struct OutgoingDatagram
+	{
+		int         drone;				// index of the destination drone
+		std::string text;				// the command text
+	};
+
+	const int       MAX_TIMEOUT_MS{ 5000 };		// maximum time allowed for Tello responses
+	const long long MAX_STATE_AGE_MS{ 500 };	// oldest state used to answer a query locally
+	static const unsigned BATCH_SIZE{ 64 };		// datagrams received with one recvmmsg() call
+	static const unsigned BUFFER_SIZE{ 512 };	// datagram receive buffer size
+#ifdef _WIN32
+	const int POLL_INTERVAL_MS{ 5 };			// longest sleep, as submit() cannot wake select()
+#endif
+
+	const unsigned short local_port;			// laptop UDP port for commands and responses
+	const unsigned short state_port;			// laptop UDP port receiving the state packets
+	std::atomic<bool>    command_echo{ true };	// write each command submitted to the console
+
+	std::vector<std::unique_ptr<SwarmDrone>> drones;		// the drones, indexed by drone number
+	std::unordered_map<unsigned long long, int> drones_by_address;	// drone indexes by IP address and port
+	std::unordered_map<unsigned long, int>      drones_by_ip;		// drone indexes by IP address, -1 if shared
+
+	std::mutex                 submit_mutex;	// ensures thread-safe access to submitted and accepting
+	std::vector<QueuedCommand> submitted;		// commands submitted since the event loop last took them
+	bool                       accepting{ false };	// the event loop is running
+
+	std::mutex statistics_mutex;				// ensures thread-safe access to the drones' statistics
+
+	std::vector<OutgoingDatagram> outgoing;		// datagrams to send at the end of the loop iteration
+	bool                          send_blocked{ false };	// the command socket's send buffer was full
+	std::vector<char>             receive_buffers;	// BATCH_SIZE receive buffers
+
+	std::thread       loop_thread;				// runs eventLoop() while started
+	std::atomic<bool> stopping{ false };		// stop() is ending the event loop
+
+#ifdef _WIN32
+	bool   wsa_started{ false };				// WSAStartup succeeded and WSACleanup is needed
+	SOCKET socket_command{ INVALID_SOCKET };	// sends commands to and receives responses from every drone
+	SOCKET socket_state{ INVALID_SOCKET };		// receives every drone's state packets
+#else
+	int socket_command{ -1 };					// sends commands to and receives responses from every drone
+	int socket_state{ -1 };						// receives every drone's state packets
+	int epoll_fd{ -1 };							// waits for datagrams, submissions or the stop request
+	int wake_fd{ -1 };							// eventfd written by submit() and stop()
+#endif
+};
+
+
+#endif // TELLO_SWARM_H
@@ -0,0 +1,425 @@
+#include "TelloTelemetry.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+
+// TelloTelemetry class version 1.1
+
+// The state packets are parsed directly from the receive buffer: keys are compared in place and
+// numbers are converted without creating strings, so receiving the state never allocates memory.
+// Keys that are not part of TelloState (such as the mission pad values) are skipped.
+
+
+using std::cout;
+using std::endl;
+using std::string;
+
+
+// Return the steady clock time in milliseconds.
+
+static long long steadyMilliseconds()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// Return a description of the last socket error.
+
+static string lastSocketError()
+{
+#ifdef _WIN32
+	return "error code " + std::to_string(WSAGetLastError());
+#else
+	return strerror(errno);
+#endif
+}
+
+
+// Convert the decimal number in [begin, end), with an optional sign and fraction, and return
+// whether the whole range is a number.
+
+static bool parseNumber(const char* begin, const char* end, double& value)
+{
+	bool negative{ false };
+
+	if ((begin < end) && ((*begin == '-') || (*begin == '+'))) {
+		negative = (*begin == '-');
+		begin++;
+	}
+
+	if (begin == end) {
+		return false;
+	}
+
+	double number{ 0.0 };
+	double scale{ 0.0 };	// place value of the next fraction digit, or 0 before the decimal point
+
+	for (const char* p{ begin }; p < end; p++) {
+		if ((*p >= '0') && (*p <= '9')) {
+			if (scale == 0.0) {
+				number = number * 10.0 + (*p - '0');
+			}
+			else {
+				number += scale * (*p - '0');
+				scale  /= 10.0;
+			}
+		}
+		else if ((*p == '.') && (scale == 0.0)) {
+			scale = 0.1;
+		}
+		else {
+			return false;
+		}
+	}
+
+	value = negative ? -number : number;
+
+	return true;
+}
+
+
+// The TelloTelemetry constructor creates a receiver with no socket; see start().
+
+TelloTelemetry::TelloTelemetry()
+{}
+
+
+// The TelloTelemetry destructor stops the receive thread and closes the socket.
+
+TelloTelemetry::~TelloTelemetry()
+{
+	stop();
+}
+
+
+// Bind a socket to the state port on every local address and start the receive thread.
+// Returns false, after writing a diagnostic message, if this fails.
+
+bool TelloTelemetry::start(unsigned short port)
+{
+	stop();
+	stopping = false;
+
+	sockaddr_in state_addr{};
+
+	state_addr.sin_family      = AF_INET;
+	state_addr.sin_port        = htons(port);
+	state_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+#ifdef _WIN32
+	WSADATA wsa_data;
+
+	if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+		cout << "Tello state WSAStartup failed" << endl;
+		return false;
+	}
+
+	wsa_started  = true;
+	socket_state = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+	if (socket_state == INVALID_SOCKET) {
+		cout << "Error creating Tello state socket (" << lastSocketError() << ')' << endl;
+		return false;
+	}
+#else
+	socket_state = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+
+	if (socket_state < 0) {
+		cout << "Error creating Tello state socket (" << lastSocketError() << ')' << endl;
+		return false;
+	}
+#endif
+
+	if (::bind(socket_state, (sockaddr*)&state_addr, sizeof(state_addr)) != 0) {
+		cout << "Binding of Tello state socket to port " << port << " failed (" << lastSocketError() << ')' << endl;
+		stop();
+		return false;
+	}
+
+#ifndef _WIN32
+	wake_fd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+	epoll_event event{};
+
+	event.events  = EPOLLIN;
+	event.data.fd = socket_state;
+
+	bool watching{ (wake_fd >= 0) && (epoll_fd >= 0) && (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, socket_state, &event) == 0) };
+
+	event.data.fd = wake_fd;
+	watching      = watching && (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event) == 0);
+
+	if (!watching) {
+		cout << "Error creating Tello state event loop (" << lastSocketError() << ')' << endl;
+		stop();
+		return false;
+	}
+#endif
+
+	receive_thread = std::thread(&TelloTelemetry::receiveThread, this);
+
+	return true;
+}
+
+
+// Stop the receive thread if it is running and close the socket.
+// The latest state remains available.
+
+void TelloTelemetry::stop()
+{
+	stopping = true;
+
+#ifdef _WIN32
+	// Closing the socket makes the receive thread's recvfrom() call fail.
+	if (socket_state != INVALID_SOCKET) {
+		closesocket(socket_state);
+		socket_state = INVALID_SOCKET;
+	}
+	if (receive_thread.joinable()) {
+		receive_thread.join();
+	}
+	if (wsa_started) {
+		WSACleanup();
+		wsa_started = false;
+	}
+#else
+	if (receive_thread.joinable()) {
+		const eventfd_t stop_request{ 1 };
+		if (write(wake_fd, &stop_request, sizeof(stop_request)) != sizeof(stop_request)) {
+			cout << "Failed to stop the Tello state receive thread (" << lastSocketError() << ')' << endl;
+		}
+		receive_thread.join();
+	}
+	for (int* fd : { &epoll_fd, &wake_fd, &socket_state }) {
+		if (*fd >= 0) {
+			::close(*fd);
+			*fd = -1;
+		}
+	}
+#endif
+}
+
+
+// Copy the latest state received into the argument and return true, or return false if no state
+// has been received yet. This never waits for the receive thread.
+
+bool TelloTelemetry::latestState(TelloState& state) const
+{
+	return latest_state.load(state);
+}
+
+
+// Answer a Tello query, such as "battery?" or "height?", in the form the Tello would, from the
+// latest state if it was received at most max_age_ms ago.
+// Returns false if the query cannot be answered from the state or no recent state was received.
+
+bool TelloTelemetry::answerQuery(const string& query, long long max_age_ms, string& answer) const
+{
+	TelloState state;
+
+	return latestState(state) && (steadyMilliseconds() - state.received_ms <= max_age_ms) &&
+		   formatQueryAnswer(state, query, answer);
+}
+
+
+// Answer a Tello query, such as "battery?", in the form the Tello would, from a state packet.
+// Returns false if the state does not answer the query.
+
+bool TelloTelemetry::formatQueryAnswer(const TelloState& state, const string& query, string& answer)
+{
+	char text[96];
+
+	if (query == "battery?") {
+		snprintf(text, sizeof(text), "%d", state.bat);
+	}
+	else if (query == "height?") {
+		snprintf(text, sizeof(text), "%ddm", state.h / 10);
+	}
+	else if (query == "time?") {
+		snprintf(text, sizeof(text), "%ds", state.time);
+	}
+	else if (query == "temp?") {
+		snprintf(text, sizeof(text), "%d~%dC", state.templ, state.temph);
+	}
+	else if (query == "attitude?") {
+		snprintf(text, sizeof(text), "pitch:%d;roll:%d;yaw:%d;", state.pitch, state.roll, state.yaw);
+	}
+	else if (query == "baro?") {
+		snprintf(text, sizeof(text), "%.2f", state.baro);
+	}
+	else if (query == "acceleration?") {
+		snprintf(text, sizeof(text), "agx:%.2f;agy:%.2f;agz:%.2f;", state.agx, state.agy, state.agz);
+	}
+	else if (query == "tof?") {
+		snprintf(text, sizeof(text), "%dmm", state.tof * 10);
+	}
+	else {
+		return false;
+	}
+
+	answer = text;
+
+	return true;
+}
+
+
+// Return the steady clock time in milliseconds, the clock of TelloState::received_ms.
+
+long long TelloTelemetry::steadyClockMilliseconds()
+{
+	return steadyMilliseconds();
+}
+
+
+// Return the number of state packets received and parsed.
+
+long long TelloTelemetry::packetsReceived() const
+{
+	return packets.load(std::memory_order_relaxed);
+}
+
+
+// Parse a state packet of the given length into the state argument, leaving the fields of keys
+// that are missing unchanged, and return whether the packet contained at least one known key with
+// a valid value. The text does not need to be null terminated.
+
+bool TelloTelemetry::parseState(const char* text, int length, TelloState& state)
+{
+	struct StateField
+	{
+		const char*       key;
+		int TelloState::* int_member;
+		float TelloState::* float_member;
+	};
+
+	static const StateField STATE_FIELDS[]{
+		{ "pitch", &TelloState::pitch, nullptr }, { "roll", &TelloState::roll, nullptr },
+		{ "yaw", &TelloState::yaw, nullptr },     { "vgx", &TelloState::vgx, nullptr },
+		{ "vgy", &TelloState::vgy, nullptr },     { "vgz", &TelloState::vgz, nullptr },
+		{ "templ", &TelloState::templ, nullptr }, { "temph", &TelloState::temph, nullptr },
+		{ "tof", &TelloState::tof, nullptr },     { "h", &TelloState::h, nullptr },
+		{ "bat", &TelloState::bat, nullptr },     { "time", &TelloState::time, nullptr },
+		{ "baro", nullptr, &TelloState::baro },   { "agx", nullptr, &TelloState::agx },
+		{ "agy", nullptr, &TelloState::agy },     { "agz", nullptr, &TelloState::agz } };
+
+	const char* position{ text };
+	const char* const end{ text + length };
+	int         num_fields{ 0 };
+
+	while (position < end) {
+		const char* const colon{ static_cast<const char*>(memchr(position, ':', end - position)) };
+		if (colon == nullptr) {
+			break;
+		}
+		const char* semicolon{ static_cast<const char*>(memchr(colon, ';', end - colon)) };
+		if (semicolon == nullptr) {
+			semicolon = end;
+		}
+
+		const size_t key_length{ size_t(colon - position) };
+
+		for (const StateField& field : STATE_FIELDS) {
+			double value;
+			if ((strlen(field.key) == key_length) && (memcmp(field.key, position, key_length) == 0) &&
+				parseNumber(colon + 1, semicolon, value)) {
+				if (field.int_member != nullptr) {
+					state.*field.int_member = int(value);
+				}
+				else {
+					state.*field.float_member = float(value);
+				}
+				num_fields++;
+				break;
+			}
+		}
+
+		// Skip the separator and the line end that follows the last value.
+		position = semicolon + 1;
+		while ((position < end) && ((*position == '\r') || (*position == '\n'))) {
+			position++;
+		}
+	}
+
+	return num_fields > 0;
+}
+
+
+// This function runs as a separate thread to receive and publish the state packets until stop()
+// is called.
+
+void TelloTelemetry::receiveThread()
+{
+	char        receive_buffer[BUFFER_SIZE];
+	sockaddr_in tello_addr{};
+	TelloState  state;
+
+#ifdef _WIN32
+	int tello_addr_length{ sizeof(tello_addr) };
+
+	while (!stopping) {
+		const int length{ recvfrom(socket_state, receive_buffer, BUFFER_SIZE, 0,
+			(sockaddr*)&tello_addr, &tello_addr_length) };
+		if ((length != SOCKET_ERROR) && parseState(receive_buffer, length, state)) {
+			state.received_ms = steadyMilliseconds();
+			latest_state.store(state);
+			packets++;
+		}
+	}
+#else
+	const int   MAX_EVENTS{ 2 };	// the socket and the eventfd
+	epoll_event events[MAX_EVENTS];
+
+	while (true) {
+		const int num_events{ epoll_wait(epoll_fd, events, MAX_EVENTS, -1) };
+
+		if (num_events < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			cout << "Failed to wait for Tello state (" << lastSocketError() << ')' << endl;
+			return;
+		}
+
+		for (int i{ 0 }; i < num_events; i++) {
+			if (events[i].data.fd == wake_fd) {
+				return;
+			}
+
+			// Take every packet waiting on the socket, publishing each as it is parsed.
+			while (true) {
+				socklen_t     tello_addr_length{ sizeof(tello_addr) };
+				const ssize_t length{ recvfrom(socket_state, receive_buffer, BUFFER_SIZE, 0,
+					(sockaddr*)&tello_addr, &tello_addr_length) };
+				if (length < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					break;
+				}
+				if (parseState(receive_buffer, static_cast<int>(length), state)) {
+					state.received_ms = steadyMilliseconds();
+					latest_state.store(state);
+					packets++;
+				}
+			}
+		}
+	}
+#endif
+}
@@ -0,0 +1,97 @@
+#ifndef TELLO_TELEMETRY_H
+#define TELLO_TELEMETRY_H
+
+
+#include "SeqLock.h"
+#include <atomic>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#endif
+
+
+// TelloTelemetry class version 1.1
+
+// Receives the state that a Tello broadcasts about ten times a second on UDP port 8890 once it has
+// accepted the "command" command, such as
+//   mid:-1;x:0;y:0;z:0;mpry:0,0,0;pitch:0;roll:0;yaw:0;vgx:0;vgy:0;vgz:0;templ:0;temph:0;tof:0;h:0;
+//   bat:0;baro:0.00;time:0;agx:0.00;agy:0.00;agz:0.00;
+// Each packet is parsed in place into a TelloState and published through a SeqLock, so any thread
+// can take a snapshot of the latest state without locks while the receive thread keeps updating it.
+// The receive thread uses Winsock on Windows and a non-blocking socket driven by epoll on Linux.
+
+
+// One Tello state packet. Units are those of the Tello SDK 2.0 User Guide.
+
+struct TelloState
+{
+	int   pitch{ 0 };				// attitude in degrees
+	int   roll{ 0 };
+	int   yaw{ 0 };
+	int   vgx{ 0 };					// speed in dm/s
+	int   vgy{ 0 };
+	int   vgz{ 0 };
+	int   templ{ 0 };				// lowest and highest temperature in degrees Celsius
+	int   temph{ 0 };
+	int   tof{ 0 };					// time of flight distance in cm
+	int   h{ 0 };					// height in cm
+	int   bat{ 0 };					// battery percentage
+	int   time{ 0 };				// motor on time in seconds
+	float baro{ 0.0f };				// barometer height in m
+	float agx{ 0.0f };				// acceleration in 0.001 g
+	float agy{ 0.0f };
+	float agz{ 0.0f };
+
+	long long received_ms{ 0 };		// steady clock time the packet was received, in ms
+};
+
+
+class TelloTelemetry
+{
+public:			// member functions intended to be used by clients of the class
+
+	TelloTelemetry();	// constructor
+	~TelloTelemetry();	// destructor
+
+	TelloTelemetry(const TelloTelemetry&) = delete;
+	TelloTelemetry& operator=(const TelloTelemetry&) = delete;
+
+	bool start(unsigned short port);
+	void stop();
+
+	bool      latestState(TelloState& state) const;
+	bool      answerQuery(const std::string& query, long long max_age_ms, std::string& answer) const;
+	long long packetsReceived() const;
+
+	static bool      parseState(const char* text, int length, TelloState& state);
+	static bool      formatQueryAnswer(const TelloState& state, const std::string& query, std::string& answer);
+	static long long steadyClockMilliseconds();
+
+private:		// member functions not intended to be used by clients of the class
+
+	void receiveThread();
+
+private:		// data members should always have private scope
+
+	static const unsigned BUFFER_SIZE{ 512 };	// state packet receive buffer size
+
+	SeqLock<TelloState>    latest_state;		// the latest state received
+	std::atomic<long long> packets{ 0 };		// state packets received and parsed
+
+	std::thread       receive_thread;			// runs receiveThread() once the socket is bound
+	std::atomic<bool> stopping{ false };		// stop() is stopping the receive thread
+
+#ifdef _WIN32
+	bool   wsa_started{ false };				// WSAStartup succeeded and WSACleanup is needed
+	SOCKET socket_state{ INVALID_SOCKET };		// socket receiving the state packets
+#else
+	int socket_state{ -1 };						// non-blocking socket receiving the state packets
+	int epoll_fd{ -1 };							// waits for packets or the stop request
+	int wake_fd{ -1 };							// eventfd written by stop() to end the receive thread
+#endif
+};
+
+
+#endif // TELLO_TELEMETRY_H
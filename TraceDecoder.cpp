@@ -0,0 +1,267 @@
+#include "TraceDecoder.h"
+#include "TraceLogger.h"
+#include "IntVariableTable.h"
+#include "DroneCommandTable.h"
+#include "InstructionTable.h"
+#include "Varint.h"
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+
+// TraceDecoder class version 1.0
+
+// See TraceRecorder.h for a description of the binary execution trace format.
+
+
+using std::cout;
+using std::endl;
+using std::ifstream;
+using std::ios;
+using std::ostringstream;
+using std::size_t;
+using std::string;
+using std::to_string;
+
+
+// The TraceDecoder constructor records references to the four parse tables of the FPL program
+// whose execution was recorded.
+
+TraceDecoder::TraceDecoder(const IntVariableTable&  variables,
+						   const LabelTable&        labels,
+						   const DroneCommandTable& drone_commands,
+						   const InstructionTable&  instructions) :
+	int_variable_table(variables),
+	label_table(labels),
+	drone_command_table(drone_commands),
+	instruction_table(instructions)
+{}
+
+
+// The TraceDecoder destructor deallocates the tracked variable values.
+
+TraceDecoder::~TraceDecoder()
+{
+	delete[] variable_values;
+}
+
+
+// Read the named trace file and its header.
+// Returns false, after writing a message, if the file cannot be read or was not recorded from a
+// program with the same integer variables.
+
+bool TraceDecoder::open(const string& file_name)
+{
+	ifstream trace_file(file_name, ios::binary);
+
+	if (!trace_file.is_open()) {
+		cout << "Trace file " << file_name << " not found" << endl;
+		return false;
+	}
+
+	ostringstream contents;
+	contents << trace_file.rdbuf();
+	trace_data = contents.str();
+
+	if ((trace_data.length() < 5) || (trace_data.compare(0, 4, "FPLT") != 0) || (trace_data[4] != 1)) {
+		cout << "Trace file " << file_name << " has an unrecognized format" << endl;
+		return false;
+	}
+
+	offset = 5;
+
+	long long start_index{ 0 };
+	long long compare_equal{ 0 };
+	long long saved_num_variables{ 0 };
+
+	if (!readValue(start_index) || !readValue(compare_equal) || !readValue(saved_num_variables) ||
+		(saved_num_variables != int_variable_table.numVariables())) {
+		cout << "Trace file " << file_name << " does not match the FPL program" << endl;
+		return false;
+	}
+
+	delete[] variable_values;
+
+	num_variables   = int(saved_num_variables);
+	variable_values = new int[num_variables > 0 ? num_variables : 1];
+
+	for (int i{ 0 }; i < num_variables; i++) {
+		long long value{ 0 };
+		if (!readValue(value)) {
+			cout << "Trace file " << file_name << " is truncated" << endl;
+			return false;
+		}
+		variable_values[i] = int(value);
+	}
+
+	previous_index    = int(start_index) - 1;
+	current_timestamp = 0;
+
+	return true;
+}
+
+
+// Decode the next executed instruction into the event argument.
+// Returns false at the end of the trace, or after writing a message if the trace is corrupt.
+
+bool TraceDecoder::readEvent(TraceEvent& event)
+{
+	if (offset >= trace_data.length()) {
+		return false;
+	}
+
+	long long index_change{ 0 };
+
+	if (!readValue(index_change)) {
+		cout << "Trace is truncated" << endl;
+		return false;
+	}
+
+	const int index{ int(previous_index + 1 + index_change) };
+
+	if (!instruction_table.validIndex(index)) {
+		cout << "Trace refers to invalid instruction location " << index << endl;
+		return false;
+	}
+
+	previous_index = index;
+
+	const InstructionEntry instruction{ instruction_table.getInstruction(index) };
+
+	event = TraceEvent();
+	event.program_counter = index;
+	event.opcode          = instruction.opcode;
+	event.operand1        = instruction.operand1;
+
+	long long value{ 0 };
+	bool      valid{ true };
+
+	switch (instruction.opcode) {
+	case Opcodes::INT:
+	case Opcodes::ADD:
+	case Opcodes::SUB:
+	case Opcodes::MUL:
+	case Opcodes::DIV:
+	case Opcodes::SET:
+		event.value1 = variable_values[instruction.operand1];
+		event.value2 = readOperand2(instruction.operand2, instruction.constant_operand2);
+		valid        = readValue(value);
+		event.result = int(event.value1 + value);
+		variable_values[instruction.operand1] = event.result;
+		break;
+	case Opcodes::CMP:
+		event.value1 = variable_values[instruction.operand1];
+		event.value2 = readOperand2(instruction.operand2, instruction.constant_operand2);
+		valid        = readValue(value);
+		event.taken  = (value != 0);
+		break;
+	case Opcodes::BEQ:
+	case Opcodes::BNE:
+	case Opcodes::BRA:
+		valid       = readValue(value);
+		event.taken = (value != 0);
+		break;
+	case Opcodes::CMD:
+		valid = readValue(value);
+		current_timestamp += value;
+		substituteValues(drone_command_table.getCommand(instruction.operand1), event);
+		break;
+	case Opcodes::NOP:
+		event.value2 = readOperand2(instruction.operand2, instruction.constant_operand2);
+		valid        = readValue(value);
+		current_timestamp += value;
+		break;
+	default:
+		break;
+	}
+
+	if (!valid) {
+		cout << "Trace is truncated" << endl;
+	}
+
+	return valid;
+}
+
+
+// Returns the mission time in milliseconds recorded for the most recent CMD or NOP event.
+// For a CMD this is when the command was issued, and for a NOP this is when the wait ended.
+
+long long TraceDecoder::timestamp() const
+{
+	return current_timestamp;
+}
+
+
+// Returns the drone command of the most recent CMD event with variable values inserted,
+// exactly as it was sent to the drone(s).
+
+string TraceDecoder::droneCommand() const
+{
+	return drone_command;
+}
+
+
+// Returns the value of an instruction's second operand using the tracked variable values.
+
+int TraceDecoder::readOperand2(int operand2, bool constant_operand2) const
+{
+	return constant_operand2 ? operand2 : variable_values[operand2];
+}
+
+
+// Read the next varint from the trace data.
+
+bool TraceDecoder::readValue(long long& value)
+{
+	int64_t decoded{ 0 };
+
+	if (!readSignedVarint(trace_data.data(), trace_data.length(), offset, decoded)) {
+		return false;
+	}
+
+	value = decoded;
+
+	return true;
+}
+
+
+// Insert the tracked variable values into a drone command in the order used by
+// FlightPlanExecute::resolveDroneCommand(), recording the values in the event and the
+// resulting command in drone_command.
+
+void TraceDecoder::substituteValues(const string& command, TraceEvent& event)
+{
+	drone_command.clear();
+
+	string variable_name;
+	bool   in_name{ false };
+
+	for (const char c : command) {
+		if (in_name) {
+			if ((c == ' ') || (c == '>')) {
+				const int index{ int_variable_table.lookupVariable(variable_name) };
+				int value{ 0 };
+				if (int_variable_table.validIndex(index)) {
+					value = variable_values[index];
+				}
+				drone_command += to_string(value);
+				drone_command += c;
+				if (event.num_values < MAX_TRACE_VALUES) {
+					event.values[event.num_values] = value;
+					event.num_values++;
+				}
+				in_name = false;
+			}
+			else {
+				variable_name += c;
+			}
+		}
+		else if (c == '%') {
+			variable_name.clear();
+			in_name = true;
+		}
+		else {
+			drone_command += c;
+		}
+	}
+}
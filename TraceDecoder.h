@@ -0,0 +1,67 @@
+#ifndef TRACE_DECODER_H
+#define TRACE_DECODER_H
+
+
+#include <cstddef>
+#include <string>
+
+
+// TraceDecoder class version 1.0
+
+// Reads a binary execution trace written by TraceRecorder and reconstructs one TraceEvent per
+// executed instruction, using the parse tables of the FPL program that was executed.
+// Operand values are not stored in the trace; they are recomputed from the starting variable
+// values in the trace header and the value changes recorded for each instruction.
+
+
+// Forward declarations to reduce the need for include files.
+
+class IntVariableTable;
+class LabelTable;
+class DroneCommandTable;
+class InstructionTable;
+
+struct TraceEvent;
+
+
+class TraceDecoder
+{
+public:		// member functions intended to be used by clients of the class
+
+	TraceDecoder(const IntVariableTable&  variables,
+				 const LabelTable&        labels,
+				 const DroneCommandTable& drone_commands,
+				 const InstructionTable&  instructions);	// constructor
+	~TraceDecoder();										// destructor
+
+	bool        open(const std::string& file_name);
+	bool        readEvent(TraceEvent& event);
+	long long   timestamp() const;
+	std::string droneCommand() const;
+
+private:	// member functions not intended to be used by clients of the class
+
+	int  readOperand2(int operand2, bool constant_operand2) const;
+	bool readValue(long long& value);
+	void substituteValues(const std::string& command, TraceEvent& event);
+
+private:	// data members should always have private scope
+
+	const IntVariableTable&  int_variable_table;	// records integer variables
+	const LabelTable&        label_table;			// records labels
+	const DroneCommandTable& drone_command_table;	// records drone commands
+	const InstructionTable&  instruction_table;		// records instructions
+
+	std::string trace_data;							// the complete contents of the trace file
+	std::size_t offset{ 0 };						// position of the next record in trace_data
+
+	int* variable_values{ nullptr };				// dynamically allocated variable values being tracked
+	int  num_variables{ 0 };						// number of entries in variable_values
+
+	int         previous_index{ -1 };				// program counter of the previous record
+	long long   current_timestamp{ 0 };				// mission time of the most recent CMD or NOP record
+	std::string drone_command;						// the most recent CMD with variable values inserted
+};
+
+
+#endif // TRACE_DECODER_H
@@ -0,0 +1,306 @@
+#include "TraceLogger.h"
+#include "IntVariableTable.h"
+#include "LabelTable.h"
+#include "DroneCommandTable.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+
+// TraceLogger class version 1.1
+
+// The execution thread records trace events with record(), which never formats text or touches
+// the console.
+// The writer thread drains the event ring, formats the events and writes them to the console in
+// batches.
+
+
+using std::cout;
+using std::endl;
+using std::ostringstream;
+using std::right;
+using std::setw;
+using std::size_t;
+using std::string;
+using std::thread;
+using std::to_string;
+
+
+// Return the drone command with each "%variable_name" identifier replaced by the next value
+// recorded in the trace event, in the order FlightPlanExecute::resolveDroneCommand() records them.
+
+static string substituteTraceValues(const string& command, const TraceEvent& event)
+{
+	string modified_command;
+	bool   skipping_name{ false };
+	int    next_value{ 0 };
+
+	for (const char c : command) {
+		if (skipping_name) {
+			if ((c == ' ') || (c == '>')) {
+				const int value{ (next_value < event.num_values) ? event.values[next_value] : 0 };
+				modified_command += to_string(value);
+				modified_command += c;
+				next_value++;
+				skipping_name = false;
+			}
+		}
+		else if (c == '%') {
+			skipping_name = true;
+		}
+		else {
+			modified_command += c;
+		}
+	}
+
+	return modified_command;
+}
+
+
+// Format a trace event into the text line that FlightPlanExecute writes for the instruction.
+// With TraceMode::ALL_OPCODES each line is preceded by the right-justified program counter.
+// A DIV event with a zero divisor, or an event with an undefined opcode, is formatted as the
+// execution error message.
+
+string formatTraceEvent(const TraceEvent&        event,
+						TraceMode                trace,
+						const IntVariableTable&  variables,
+						const LabelTable&        labels,
+						const DroneCommandTable& drone_commands)
+{
+	ostringstream line;
+
+	if (trace == TraceMode::ALL_OPCODES) {
+		line << right << setw(8) << event.program_counter << "    ";
+	}
+
+	switch (event.opcode) {
+	case Opcodes::INT:
+		line << variables.getName(event.operand1) << " = " << event.value2;
+		break;
+	case Opcodes::ADD:
+		line << variables.getName(event.operand1) << " = " << event.value1 << " + " << event.value2
+			 << " = " << event.result;
+		break;
+	case Opcodes::SUB:
+		line << variables.getName(event.operand1) << " = " << event.value1 << " - " << event.value2
+			 << " = " << event.result;
+		break;
+	case Opcodes::MUL:
+		line << variables.getName(event.operand1) << " = " << event.value1 << " * " << event.value2
+			 << " = " << event.result;
+		break;
+	case Opcodes::DIV:
+		if (event.value2 == 0) {
+			line << "Attempted division by zero at location " << event.program_counter << " - program terminated";
+		}
+		else {
+			line << variables.getName(event.operand1) << " = " << event.value1 << " / " << event.value2
+				 << " = " << event.result;
+		}
+		break;
+	case Opcodes::SET:
+		line << variables.getName(event.operand1) << " = " << event.result;
+		break;
+	case Opcodes::CMP:
+		line << event.value1 << " == " << event.value2 << " ?";
+		break;
+	case Opcodes::BEQ:
+		if (event.taken) {
+			line << "BEQ taken to label " << labels.getName(event.operand1);
+		}
+		else {
+			line << "BEQ skipped";
+		}
+		break;
+	case Opcodes::BNE:
+		if (event.taken) {
+			line << "BNE taken to label " << labels.getName(event.operand1);
+		}
+		else {
+			line << "BNE skipped";
+		}
+		break;
+	case Opcodes::BRA:
+		line << "BRA to label " << labels.getName(event.operand1);
+		break;
+	case Opcodes::CMD:
+	{
+		const string command{ drone_commands.getCommand(event.operand1) };
+		line << "CMD " << command;
+		if (event.num_values > 0) {
+			const string modified_command{ substituteTraceValues(command, event) };
+			if (modified_command != command) {
+				line << " becomes CMD " << modified_command;
+			}
+		}
+		break;
+	}
+	case Opcodes::NOP:
+		line << "Wait until " << event.value2 << " seconds since initialization";
+		break;
+	case Opcodes::END:
+		line << "END";
+		break;
+	default:
+		line << "Undefined instruction opcode (" << opcodeToString(event.opcode) << ") at location "
+			 << event.program_counter << " - program terminated";
+		break;
+	}
+
+	return line.str();
+}
+
+
+// The TraceLogger constructor records references to the parse tables used to format events
+// and starts the writer thread.
+
+TraceLogger::TraceLogger(const IntVariableTable&  variables,
+						 const LabelTable&        labels,
+						 const DroneCommandTable& drone_commands,
+						 TraceMode                trace,
+						 TraceOverflow            overflow) :
+	int_variable_table(variables),
+	label_table(labels),
+	drone_command_table(drone_commands),
+	trace_mode(trace),
+	overflow_mode(overflow)
+{
+	writer_thread = thread(&TraceLogger::writerThread, this);
+}
+
+
+// The TraceLogger destructor writes any events still queued, stops the writer thread, and
+// reports how many events were dropped because the ring was full.
+
+TraceLogger::~TraceLogger()
+{
+	stop_writer = true;
+	wakeWriter();
+	writer_thread.join();
+
+	if (events_dropped > 0) {
+		cout << events_dropped << " trace events were dropped because the trace buffer was full" << endl;
+	}
+}
+
+
+// Queue a trace event for the writer thread, waking it if it is waiting for events.
+// If the ring is full the event is either discarded or the caller waits for space, depending on
+// the overflow mode.
+// Only the execution thread may call record().
+
+void TraceLogger::record(const TraceEvent& event)
+{
+	if (event_ring.push(event)) {
+		events_recorded++;
+	}
+	else if (overflow_mode == TraceOverflow::BLOCK) {
+		while (!event_ring.push(event)) {
+			std::this_thread::yield();
+		}
+		events_recorded++;
+	}
+	else {
+		events_dropped++;
+		return;
+	}
+
+	// Pairs with the fence in writerThread(): either the writer sees the event before it sleeps or
+	// this sees that it is sleeping.
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (writer_sleeping.load(std::memory_order_relaxed)) {
+		wakeWriter();
+	}
+}
+
+
+// Wait until every event recorded so far has been written to the console.
+// The execution thread calls flush() before writing any other console output of its own, so that
+// the trace and other messages appear in order.
+
+void TraceLogger::flush()
+{
+	if (events_written.load() == events_recorded.load()) {
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(writer_mutex);
+
+	flush_requested = true;
+	writer_drained.wait(lock, [this] { return events_written.load() >= events_recorded.load(); });
+	flush_requested = false;
+}
+
+
+// Wake the writer thread if it is waiting for events.
+
+void TraceLogger::wakeWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(writer_mutex);
+	}
+	writer_wake.notify_one();
+}
+
+
+// Returns the number of events discarded because the ring was full.
+
+long long TraceLogger::droppedEvents() const
+{
+	return events_dropped;
+}
+
+
+// The writer thread runs until the destructor asks it to stop, sleeping whenever the ring is empty
+// until record() wakes it.
+
+void TraceLogger::writerThread()
+{
+	while (!stop_writer) {
+		if (event_ring.empty()) {
+			std::unique_lock<std::mutex> lock(writer_mutex);
+
+			writer_sleeping.store(true, std::memory_order_relaxed);
+			writer_wake.wait(lock, [this] {
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				return !event_ring.empty() || stop_writer.load();
+			});
+			writer_sleeping.store(false, std::memory_order_relaxed);
+		}
+		else {
+			writeQueuedEvents();
+		}
+	}
+
+	writeQueuedEvents();
+}
+
+
+// Format all events currently in the ring and write them to the console as a single batch.
+
+void TraceLogger::writeQueuedEvents()
+{
+	string     batch;
+	TraceEvent event;
+	long long  count{ 0 };
+
+	while (event_ring.pop(event)) {
+		batch += formatTraceEvent(event, trace_mode, int_variable_table, label_table, drone_command_table);
+		batch += '\n';
+		count++;
+	}
+
+	if (count > 0) {
+		cout << batch << std::flush;
+		events_written += count;
+
+		if (flush_requested) {
+			{
+				std::lock_guard<std::mutex> lock(writer_mutex);
+			}
+			writer_drained.notify_one();
+		}
+	}
+}
@@ -0,0 +1,119 @@
+#ifndef TRACE_LOGGER_H
+#define TRACE_LOGGER_H
+
+
+#include "FlightPlanExecute.h"
+#include "Opcodes.h"
+#include "SpscRing.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+
+// TraceLogger class version 1.1
+
+// Instruction tracing records a compact binary event per traced instruction rather than writing
+// text to the console from the execution thread.
+// A background thread formats the events into the same text layout that FlightPlanExecute has
+// always produced, so tracing no longer slows execution down by flushing the console after every
+// instruction.
+
+
+// Forward declarations to reduce the need for include files.
+
+class IntVariableTable;
+class LabelTable;
+class DroneCommandTable;
+
+
+// The maximum number of integer variable values substituted into a traced drone command.
+
+const int MAX_TRACE_VALUES{ 8 };
+
+
+// The outcome of executing one instruction.
+// operand1 holds the instruction's variable, label or drone command table index.
+// value1 and value2 hold the operand values used, result holds the value assigned (if any),
+// and taken records whether a branch was taken.
+// For CMD instructions, values holds the integer variable values substituted into the command
+// in the order the '%' identifiers appear.
+
+struct TraceEvent
+{
+	int     program_counter{ 0 };
+	Opcodes opcode{ Opcodes::UNDEFINED };
+	int     operand1{ -1 };
+	int     value1{ 0 };
+	int     value2{ 0 };
+	int     result{ 0 };
+	bool    taken{ false };
+	int     num_values{ 0 };
+	int     values[MAX_TRACE_VALUES]{};
+};
+
+
+// Format a trace event into the text line (without a trailing newline) that the trace mode
+// requires, using the parse tables to look up variable, label and drone command names.
+
+std::string formatTraceEvent(const TraceEvent&        event,
+							 TraceMode                trace,
+							 const IntVariableTable&  variables,
+							 const LabelTable&        labels,
+							 const DroneCommandTable& drone_commands);
+
+
+// The TraceLogger class queues trace events in a lock-free ring and writes them to the console
+// on a background thread, which sleeps while the ring is empty.
+
+class TraceLogger
+{
+public:		// member functions intended to be used by clients of the class
+
+	TraceLogger(const IntVariableTable&  variables,
+				const LabelTable&        labels,
+				const DroneCommandTable& drone_commands,
+				TraceMode                trace,
+				TraceOverflow            overflow);		// constructor
+	~TraceLogger();										// destructor
+
+	void      record(const TraceEvent& event);
+	void      flush();
+	long long droppedEvents() const;
+
+private:	// member functions not intended to be used by clients of the class
+
+	void wakeWriter();
+	void writerThread();
+	void writeQueuedEvents();
+
+private:	// data members should always have private scope
+
+	static const unsigned RING_CAPACITY{ 4096 };		// number of events the ring can hold
+
+	const IntVariableTable&  int_variable_table;		// records integer variables
+	const LabelTable&        label_table;				// records labels
+	const DroneCommandTable& drone_command_table;		// records drone commands
+
+	const TraceMode     trace_mode;						// level of instruction tracing desired
+	const TraceOverflow overflow_mode;					// what to do when the ring is full
+
+	SpscRing<TraceEvent, RING_CAPACITY> event_ring;	// events recorded but not yet written
+
+	std::atomic<long long> events_recorded{ 0 };		// events pushed into the ring
+	std::atomic<long long> events_written{ 0 };			// events written to the console
+	std::atomic<long long> events_dropped{ 0 };			// events discarded because the ring was full
+	std::atomic<bool>      stop_writer{ false };		// tells the writer thread to finish
+	std::atomic<bool>      writer_sleeping{ false };	// the writer thread is waiting for events
+	std::atomic<bool>      flush_requested{ false };	// flush() is waiting for the ring to drain
+
+	std::mutex              writer_mutex;				// used with writer_wake and writer_drained
+	std::condition_variable writer_wake;				// wakes the writer thread for new events
+	std::condition_variable writer_drained;				// wakes flush() once events were written
+
+	std::thread writer_thread;							// formats and writes queued events
+};
+
+
+#endif // TRACE_LOGGER_H
@@ -0,0 +1,143 @@
+#include "TraceRecorder.h"
+#include "Varint.h"
+#include <iostream>
+
+
+// TraceRecorder class version 1.1
+
+// Records are appended to an in-memory buffer and written to the trace file in large blocks,
+// so recording costs a few bytes of buffer appends per executed instruction.
+
+
+using std::cout;
+using std::endl;
+using std::ios;
+using std::string;
+
+
+// The TraceRecorder constructor reserves the record buffer.
+
+TraceRecorder::TraceRecorder()
+{
+	buffer.reserve(FLUSH_SIZE + 64);
+}
+
+
+// The TraceRecorder destructor writes any buffered records and closes the trace file.
+
+TraceRecorder::~TraceRecorder()
+{
+	close();
+}
+
+
+// Create the trace file and write the header describing the execution state at the start of
+// recording.
+// Returns false, after writing a message, if the file cannot be created.
+
+bool TraceRecorder::open(const string& file_name, int start_index, bool compare_equal,
+						 const int values[], int num_values)
+{
+	close();
+
+	trace_file.open(file_name, ios::binary | ios::trunc);
+
+	if (!trace_file.is_open()) {
+		cout << "Unable to create trace file " << file_name << endl;
+		return false;
+	}
+
+	buffer.clear();
+	buffer += "FPLT";
+	buffer += static_cast<char>(1);
+	appendSignedVarint(buffer, start_index);
+	appendSignedVarint(buffer, compare_equal ? 1 : 0);
+	appendSignedVarint(buffer, num_values);
+
+	for (int i{ 0 }; i < num_values; i++) {
+		appendSignedVarint(buffer, values[i]);
+	}
+
+	previous_index     = start_index - 1;
+	previous_timestamp = 0;
+
+	return true;
+}
+
+
+// Write any buffered records and close the trace file.
+
+void TraceRecorder::close()
+{
+	if (trace_file.is_open()) {
+		writeBuffer();
+		trace_file.close();
+	}
+}
+
+
+// Start the record for the instruction at the specified index.
+// Sequential execution is recorded as a zero difference.
+
+void TraceRecorder::recordInstruction(int index)
+{
+	appendSignedVarint(buffer, static_cast<long long>(index) - (previous_index + 1));
+
+	previous_index = index;
+
+	if (buffer.length() >= FLUSH_SIZE) {
+		writeBuffer();
+	}
+}
+
+
+// Record the value assigned to an integer variable as a difference from its previous value.
+
+void TraceRecorder::recordValueChange(int old_value, int new_value)
+{
+	appendSignedVarint(buffer, static_cast<long long>(new_value) - old_value);
+}
+
+
+// Record a comparison result or branch outcome.
+
+void TraceRecorder::recordOutcome(bool outcome)
+{
+	buffer += static_cast<char>(outcome ? 1 : 0);
+}
+
+
+// Record a mission timestamp as a difference from the previous timestamp.
+
+void TraceRecorder::recordTimestamp(long long milliseconds)
+{
+	appendSignedVarint(buffer, milliseconds - previous_timestamp);
+
+	previous_timestamp = milliseconds;
+}
+
+
+// Write the buffered records to the trace file now, so that they survive a crash. Called at each
+// NOP and END instruction, where the mission already pauses, rather than only when FLUSH_SIZE
+// bytes have been buffered, so the end of the trace is not lost.
+
+void TraceRecorder::flush()
+{
+	if (!buffer.empty()) {
+		writeBuffer();
+	}
+
+	trace_file.flush();
+}
+
+
+// Append the buffered records to the trace file and empty the buffer.
+
+void TraceRecorder::writeBuffer()
+{
+	if (!trace_file.write(buffer.data(), buffer.length())) {
+		cout << "Unable to write to trace file" << endl;
+	}
+
+	buffer.clear();
+}
@@ -0,0 +1,63 @@
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+
+#include <fstream>
+#include <string>
+
+
+// TraceRecorder class version 1.1
+
+// A binary execution trace records every executed instruction with just enough information for
+// TraceDecoder to reconstruct the full instruction trace offline, given the same FPL program.
+//
+// File layout (all integers are signed varints, see Varint.h):
+//   "FPLT" signature, format version byte
+//   starting program counter, starting CMP result (0 or 1)
+//   number of integer variables n, followed by the n starting variable values (signed)
+//   one record per executed instruction:
+//     signed difference between the program counter and the previous program counter + 1
+//     CMD only:                  mission time in ms when the command was issued, as a signed
+//                                difference from the previous timestamp
+//     INT ADD SUB MUL DIV SET:   signed difference between the new and old variable values
+//     CMP:                       the comparison result (0 or 1)
+//     BEQ BNE BRA:               the branch outcome (0 = not taken, 1 = taken)
+//     NOP:                       mission time in ms when the wait ended, as a signed difference
+//                                from the previous timestamp
+//     END:                       nothing
+
+
+class TraceRecorder
+{
+public:		// member functions intended to be used by clients of the class
+
+	TraceRecorder();		// constructor
+	~TraceRecorder();		// destructor
+
+	bool open(const std::string& file_name, int start_index, bool compare_equal,
+			  const int values[], int num_values);
+	void close();
+
+	void recordInstruction(int index);
+	void recordValueChange(int old_value, int new_value);
+	void recordOutcome(bool outcome);
+	void recordTimestamp(long long milliseconds);
+	void flush();
+
+private:	// member functions not intended to be used by clients of the class
+
+	void writeBuffer();
+
+private:	// data members should always have private scope
+
+	static const unsigned FLUSH_SIZE{ 65536 };	// buffered bytes that trigger a file write between NOPs
+
+	std::ofstream trace_file;					// the binary trace file
+	std::string   buffer;						// records not yet written to the file
+
+	int       previous_index{ -1 };				// program counter of the previous record
+	long long previous_timestamp{ 0 };			// timestamp of the previous CMD or NOP record
+};
+
+
+#endif // TRACE_RECORDER_H
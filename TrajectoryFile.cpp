@@ -0,0 +1,283 @@
+#include "TrajectoryFile.h"
+#include "Varint.h"
+#include <iostream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+// TrajectoryFile class version 1.1
+
+
+using std::cout;
+using std::endl;
+using std::size_t;
+using std::string;
+
+
+// The TrajectoryFile constructor creates a reader with no file open.
+
+TrajectoryFile::TrajectoryFile()
+{}
+
+
+// The TrajectoryFile destructor unmaps the file.
+
+TrajectoryFile::~TrajectoryFile()
+{
+	close();
+}
+
+
+// Map a trajectory file, check every record and position the reader at the first record.
+// Returns false, after writing a message, if the file cannot be mapped or is not a valid
+// trajectory file.
+
+bool TrajectoryFile::open(const string& file_name)
+{
+	close();
+
+	const void* memory{ nullptr };
+	size_t      file_size{ 0 };
+
+#ifdef _WIN32
+	const HANDLE file{ CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+								   FILE_ATTRIBUTE_NORMAL, nullptr) };
+	if (file != INVALID_HANDLE_VALUE) {
+		LARGE_INTEGER length;
+		if (GetFileSizeEx(file, &length) && (length.QuadPart >= LONGLONG(HEADER_SIZE))) {
+			const HANDLE file_mapping{ CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) };
+			if (file_mapping != nullptr) {
+				memory = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+				if (memory == nullptr) {
+					CloseHandle(file_mapping);
+				}
+				else {
+					mapping   = file_mapping;
+					file_size = size_t(length.QuadPart);
+				}
+			}
+		}
+		CloseHandle(file);
+	}
+#else
+	const int fd{ ::open(file_name.c_str(), O_RDONLY) };
+	if (fd >= 0) {
+		struct stat status;
+		if ((fstat(fd, &status) == 0) && (status.st_size >= off_t(HEADER_SIZE))) {
+			memory = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if (memory == MAP_FAILED) {
+				memory = nullptr;
+			}
+			else {
+				file_size = size_t(status.st_size);
+			}
+		}
+		::close(fd);
+	}
+#endif
+
+	if (memory == nullptr) {
+		cout << "Unable to open trajectory file " << file_name << endl;
+		return false;
+	}
+
+	data = static_cast<const char*>(memory);
+	size = file_size;
+
+	version = data[4];
+
+	if ((string(data, 4) != "FPLJ") || (version < 1) || (version > MAX_VERSION)) {
+		cout << "File " << file_name << " is not a trajectory file" << endl;
+		close();
+		return false;
+	}
+
+	// Check every record, counting them and finding the mission time of the last.
+	TrajectoryRecord record;
+
+	rewind();
+	while (readRecord(record)) {
+		num_records++;
+		last_time = record.command.time_ms;
+	}
+
+	if (offset != size) {
+		cout << "Trajectory file " << file_name << " is truncated after " << num_records << " commands" << endl;
+	}
+
+	rewind();
+
+	return true;
+}
+
+
+// Unmap the file.
+
+void TrajectoryFile::close()
+{
+	if (data == nullptr) {
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+	CloseHandle(static_cast<HANDLE>(mapping));
+	mapping = nullptr;
+#else
+	munmap(const_cast<char*>(data), size);
+#endif
+
+	data        = nullptr;
+	size        = 0;
+	num_records = 0;
+	last_time   = 0;
+}
+
+
+// Read the next record, returning false at the end of the file or of its last complete record.
+
+bool TrajectoryFile::readRecord(TrajectoryRecord& record)
+{
+	if (data == nullptr) {
+		return false;
+	}
+
+	size_t    next_offset{ offset };
+	long long time{ current_time };
+	int       index{ current_index };
+
+	if (!decodeRecord(next_offset, time, index, record)) {
+		return false;
+	}
+
+	offset        = next_offset;
+	current_time  = time;
+	current_index = index;
+
+	return true;
+}
+
+
+// Position the reader at the first record.
+
+void TrajectoryFile::rewind()
+{
+	offset        = HEADER_SIZE;
+	current_time  = 0;
+	current_index = 0;
+}
+
+
+// Return the mission time of the next record without reading it, or -1 at the end of the file.
+
+long long TrajectoryFile::nextTime() const
+{
+	size_t           next_offset{ offset };
+	long long        time{ current_time };
+	int              index{ current_index };
+	TrajectoryRecord record;
+
+	if ((data == nullptr) || !decodeRecord(next_offset, time, index, record)) {
+		return -1;
+	}
+
+	return time;
+}
+
+
+// Return the number of records in the file.
+
+long long TrajectoryFile::numRecords() const
+{
+	return num_records;
+}
+
+
+// Return the mission time of the last record in milliseconds.
+
+long long TrajectoryFile::duration() const
+{
+	return last_time;
+}
+
+
+// Decode the record at data[position] given the previous record's time and instruction location,
+// advancing position past it and updating time and index.
+// Returns false if the record is incomplete or invalid.
+
+bool TrajectoryFile::decodeRecord(size_t& position, long long& time, int& index, TrajectoryRecord& record) const
+{
+	int64_t time_delta{ 0 };
+	int64_t index_delta{ 0 };
+
+	if (!readSignedVarint(data, size, position, time_delta) || !readSignedVarint(data, size, position, index_delta) ||
+		(position >= size)) {
+		return false;
+	}
+
+	const unsigned type{ static_cast<unsigned char>(data[position]) };
+
+	if (type > static_cast<unsigned>(SimulatorCommandType::OTHER)) {
+		return false;
+	}
+
+	position++;
+
+	record.command      = SimulatorCommand();
+	record.command.type = static_cast<SimulatorCommandType>(type);
+	record.text.clear();
+
+	int64_t  x{ 0 };
+	int64_t  y{ 0 };
+	int64_t  z{ 0 };
+	uint64_t speed{ 0 };
+	uint64_t length{ 0 };
+
+	switch (record.command.type) {
+	case SimulatorCommandType::MOVE:
+		if (!readSignedVarint(data, size, position, x) || !readSignedVarint(data, size, position, y) ||
+			!readSignedVarint(data, size, position, z)) {
+			return false;
+		}
+		record.command.offset.x = int(x);
+		record.command.offset.y = int(y);
+		record.command.offset.z = int(z);
+		if (version >= 2) {
+			if (!readVarint(data, size, position, speed)) {
+				return false;
+			}
+			record.command.value = int(speed);
+		}
+		break;
+	case SimulatorCommandType::SPEED:
+		if (!readSignedVarint(data, size, position, x)) {
+			return false;
+		}
+		record.command.value = int(x);
+		break;
+	case SimulatorCommandType::OTHER:
+		if (!readVarint(data, size, position, length) || (length > size - position)) {
+			return false;
+		}
+		record.text.assign(data + position, size_t(length));
+		position += size_t(length);
+		break;
+	default:
+		break;
+	}
+
+	time  += time_delta;
+	index += int(index_delta);
+
+	record.command.time_ms     = time;
+	record.command.instruction = index;
+
+	return true;
+}
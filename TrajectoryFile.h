@@ -0,0 +1,72 @@
+#ifndef TRAJECTORY_FILE_H
+#define TRAJECTORY_FILE_H
+
+
+#include "DroneSimulatorApi.h"
+#include <cstddef>
+#include <string>
+
+
+// TrajectoryFile class version 1.1
+
+// Reads a trajectory file written by TrajectoryRecorder (see TrajectoryRecorder.h for the layout).
+// The file is memory mapped rather than read into memory, so opening even a very long mission is
+// immediate apart from one pass that checks the records and finds the mission's duration.
+// Records are read in order, continuing from wherever reading stopped; rewind() returns to the
+// first record, which is how a replay seeks backwards.
+
+
+// One drone command read from a trajectory file.
+
+struct TrajectoryRecord
+{
+	SimulatorCommand command;		// the parsed command, with its mission time and instruction location
+	std::string      text;			// the command text, only for SimulatorCommandType::OTHER commands
+};
+
+
+class TrajectoryFile
+{
+public:		// member functions intended to be used by clients of the class
+
+	TrajectoryFile();		// constructor
+	~TrajectoryFile();		// destructor
+
+	TrajectoryFile(const TrajectoryFile&) = delete;
+	TrajectoryFile& operator=(const TrajectoryFile&) = delete;
+
+	bool open(const std::string& file_name);
+	void close();
+
+	bool      readRecord(TrajectoryRecord& record);
+	void      rewind();
+	long long nextTime() const;
+
+	long long numRecords() const;
+	long long duration() const;
+
+private:	// member functions not intended to be used by clients of the class
+
+	bool decodeRecord(std::size_t& position, long long& time, int& index, TrajectoryRecord& record) const;
+
+private:	// data members should always have private scope
+
+	static const std::size_t HEADER_SIZE{ 5 };	// signature and version byte
+	static const int         MAX_VERSION{ 2 };	// latest file format version read
+
+	int         version{ 0 };				// the file's format version
+
+	const char* data{ nullptr };			// the mapped file contents
+	std::size_t size{ 0 };					// the file size in bytes
+	void*       mapping{ nullptr };			// the file mapping handle on Windows
+
+	std::size_t offset{ 0 };				// position of the next record in data
+	long long   current_time{ 0 };			// mission time of the previous record read
+	int         current_index{ 0 };			// instruction location of the previous record read
+
+	long long   num_records{ 0 };			// records in the file
+	long long   last_time{ 0 };				// mission time of the last record
+};
+
+
+#endif // TRAJECTORY_FILE_H
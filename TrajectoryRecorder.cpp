@@ -0,0 +1,136 @@
+#include "TrajectoryRecorder.h"
+#include "DroneSimulatorApi.h"
+#include "SimulatorBackend.h"
+#include "Varint.h"
+#include <iostream>
+
+
+// TrajectoryRecorder class version 1.3
+
+// Records are appended to an in-memory buffer and written to the trajectory file in large blocks.
+// Commands are converted with SimulatorBackend::toSimulatorCommand() so that the common commands
+// are stored as a type byte and a few small integers.
+
+
+using std::cout;
+using std::endl;
+using std::ios;
+using std::string;
+
+
+// The TrajectoryRecorder constructor reserves the record buffer.
+
+TrajectoryRecorder::TrajectoryRecorder()
+{
+	buffer.reserve(FLUSH_SIZE + 64);
+}
+
+
+// The TrajectoryRecorder destructor writes any buffered records and closes the trajectory file.
+
+TrajectoryRecorder::~TrajectoryRecorder()
+{
+	close();
+}
+
+
+// Create the trajectory file and write its header.
+// Returns false, after writing a message, if the file cannot be created.
+
+bool TrajectoryRecorder::open(const string& file_name)
+{
+	close();
+
+	trajectory_file.open(file_name, ios::binary | ios::trunc);
+
+	if (!trajectory_file.is_open()) {
+		cout << "Unable to create trajectory file " << file_name << endl;
+		return false;
+	}
+
+	buffer.clear();
+	buffer += "FPLJ";
+	buffer += static_cast<char>(FORMAT_VERSION);
+
+	previous_time  = 0;
+	previous_index = 0;
+
+	return true;
+}
+
+
+// Write any buffered records and close the trajectory file.
+
+void TrajectoryRecorder::close()
+{
+	if (trajectory_file.is_open()) {
+		writeBuffer();
+		trajectory_file.close();
+	}
+}
+
+
+// Record a drone command, with the mission time it was sent at and the location of the CMD
+// instruction that sent it.
+
+void TrajectoryRecorder::recordCommand(long long mission_ms, int instruction_index, const DroneCommand& command)
+{
+	const SimulatorCommand simulator_command{ SimulatorBackend::toSimulatorCommand(command) };
+	string                 text;
+
+	appendSignedVarint(buffer, mission_ms - previous_time);
+	appendSignedVarint(buffer, static_cast<long long>(instruction_index) - previous_index);
+	buffer += static_cast<char>(simulator_command.type);
+
+	switch (simulator_command.type) {
+	case SimulatorCommandType::MOVE:
+		appendSignedVarint(buffer, simulator_command.offset.x);
+		appendSignedVarint(buffer, simulator_command.offset.y);
+		appendSignedVarint(buffer, simulator_command.offset.z);
+		appendVarint(buffer, simulator_command.value);
+		break;
+	case SimulatorCommandType::SPEED:
+		appendSignedVarint(buffer, simulator_command.value);
+		break;
+	case SimulatorCommandType::OTHER:
+		text = formatDroneCommand(command);
+		appendVarint(buffer, text.length());
+		buffer += text;
+		break;
+	default:
+		break;
+	}
+
+	previous_time  = mission_ms;
+	previous_index = instruction_index;
+
+	if (buffer.length() >= FLUSH_SIZE) {
+		writeBuffer();
+	}
+}
+
+
+// Write the buffered records to the trajectory file now, so that a mission with few commands can
+// be replayed while it is still executing and the file survives a crash. Called whenever execution
+// waits for the drones, rather than only when FLUSH_SIZE bytes have been buffered.
+
+void TrajectoryRecorder::flush()
+{
+	if (!buffer.empty()) {
+		writeBuffer();
+	}
+
+	trajectory_file.flush();
+}
+
+
+// Append the buffered records to the trajectory file and empty the buffer.
+
+void TrajectoryRecorder::writeBuffer()
+{
+	if (!trajectory_file.write(buffer.data(), buffer.length())) {
+		cout << "Unable to write to trajectory file" << endl;
+	}
+
+	buffer.clear();
+}
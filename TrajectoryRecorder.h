@@ -0,0 +1,61 @@
+#ifndef TRAJECTORY_RECORDER_H
+#define TRAJECTORY_RECORDER_H
+
+
+#include "DroneCommand.h"
+#include <fstream>
+#include <string>
+
+
+// TrajectoryRecorder class version 1.3
+
+// A trajectory file records every drone command sent by an FPL program, after its integer
+// variables have been replaced with their values, together with the mission time it was sent at
+// and the location of the CMD instruction that sent it. TrajectoryFile reads it back, so a mission
+// can be replayed (see fpl-viewer.cpp) without executing the program again.
+//
+// File layout (all integers are varints, see Varint.h):
+//   "FPLJ" signature, format version byte (2; TrajectoryFile also reads version 1)
+//   one record per drone command:
+//     signed difference between the mission time in ms and the previous record's mission time
+//     signed difference between the instruction location and the previous record's location
+//     command type byte (a SimulatorCommandType value)
+//     MOVE:                  the signed x, y and z offsets, then the unsigned speed in cm/s or 0
+//                            for the drone's own speed (format version 2 only)
+//     SPEED:                 the signed speed
+//     TAKEOFF LAND ARM:      nothing
+//     OTHER:                 the unsigned length of the command text followed by the text
+//                            (such as "initialize" or "cw 90")
+
+
+class TrajectoryRecorder
+{
+public:		// member functions intended to be used by clients of the class
+
+	TrajectoryRecorder();		// constructor
+	~TrajectoryRecorder();		// destructor
+
+	bool open(const std::string& file_name);
+	void close();
+
+	void recordCommand(long long mission_ms, int instruction_index, const DroneCommand& command);
+	void flush();
+
+private:	// member functions not intended to be used by clients of the class
+
+	void writeBuffer();
+
+private:	// data members should always have private scope
+
+	static const unsigned FLUSH_SIZE{ 65536 };	// buffered bytes that trigger a file write
+	static const int      FORMAT_VERSION{ 2 };	// trajectory file format version written
+
+	std::ofstream trajectory_file;				// the binary trajectory file
+	std::string   buffer;						// records not yet written to the file
+
+	long long previous_time{ 0 };				// mission time of the previous record
+	int       previous_index{ 0 };				// instruction location of the previous record
+};
+
+
+#endif // TRAJECTORY_RECORDER_H
@@ -0,0 +1,96 @@
+#ifndef VARINT_H
+#define VARINT_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+// Variable-length integer encoding used by the binary trace and trajectory file formats.
+// Unsigned values are stored 7 bits per byte, least significant group first, with the high bit of
+// each byte set when more bytes follow, so small values occupy a single byte.
+// Signed values are first zigzag encoded (0, -1, 1, -2, 2 ... become 0, 1, 2, 3, 4 ...) so that
+// small negative deltas are also short.
+
+
+// Map a signed value onto an unsigned value whose magnitude grows with the signed value's magnitude.
+
+inline uint64_t zigzagEncode(int64_t value)
+{
+	return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+
+// Reverse zigzagEncode().
+
+inline int64_t zigzagDecode(uint64_t value)
+{
+	return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+
+// Append an unsigned varint to the end of the buffer.
+
+inline void appendVarint(std::string& buffer, uint64_t value)
+{
+	while (value >= 0x80) {
+		buffer += static_cast<char>((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+
+	buffer += static_cast<char>(value);
+}
+
+
+// Append a zigzag encoded signed varint to the end of the buffer.
+
+inline void appendSignedVarint(std::string& buffer, int64_t value)
+{
+	appendVarint(buffer, zigzagEncode(value));
+}
+
+
+// Read an unsigned varint starting at data[offset] and advance offset past it.
+// Returns false, leaving offset unchanged, if the varint is truncated by the end of the data.
+
+inline bool readVarint(const char* data, std::size_t size, std::size_t& offset, uint64_t& value)
+{
+	uint64_t    result{ 0 };
+	int         shift{ 0 };
+	std::size_t i{ offset };
+
+	while ((i < size) && (shift < 64)) {
+		const uint8_t byte{ static_cast<uint8_t>(data[i]) };
+		i++;
+		result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			value  = result;
+			offset = i;
+			return true;
+		}
+		shift += 7;
+	}
+
+	return false;
+}
+
+
+// Read a zigzag encoded signed varint starting at data[offset] and advance offset past it.
+// Returns false, leaving offset unchanged, if the varint is truncated by the end of the data.
+
+inline bool readSignedVarint(const char* data, std::size_t size, std::size_t& offset, int64_t& value)
+{
+	uint64_t encoded{ 0 };
+
+	if (!readVarint(data, size, offset, encoded)) {
+		return false;
+	}
+
+	value = zigzagDecode(encoded);
+
+	return true;
+}
+
+
+#endif // VARINT_H
@@ -0,0 +1,150 @@
+#include "IntVariableTable.h"
+#include "LabelTable.h"
+#include "DroneCommandTable.h"
+#include "InstructionTable.h"
+#include "FlightPlanParse.h"
+#include "TraceDecoder.h"
+#include "TraceLogger.h"
+#include "DroneSimulatorApi.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <thread>
+
+
+using std::cin;
+using std::cout;
+using std::endl;
+using std::getline;
+using std::ifstream;
+using std::right;
+using std::setw;
+using std::stod;
+using std::string;
+
+
+// An offline tool for binary execution traces recorded with FlightPlanExecute::recordTrace().
+// The FPL program that was executed is parsed again to rebuild its parse tables, which the trace
+// decoder needs to reconstruct each instruction.
+//
+// Usage: fpl-trace <FPL file> <trace file>                  writes the full instruction trace
+//        fpl-trace <FPL file> <trace file> replay [speed]   replays the drone commands into the
+//                                                           drone simulator, optionally faster
+//                                                           (speed 2 = twice as fast)
+
+
+// Write every decoded instruction in the same layout as TraceMode::ALL_OPCODES execution.
+
+static void decodeTrace(TraceDecoder& decoder, const IntVariableTable& variables, const LabelTable& labels,
+						const DroneCommandTable& drone_commands)
+{
+	cout << endl << "Program execution: [program counter | operation]" << endl << endl;
+
+	TraceEvent event;
+
+	while (decoder.readEvent(event)) {
+		cout << formatTraceEvent(event, TraceMode::ALL_OPCODES, variables, labels, drone_commands) << '\n';
+	}
+
+	cout << std::flush;
+}
+
+
+// Send each recorded drone command to the drone simulator at its recorded mission time divided
+// by the speed factor.
+
+static void replayTrace(TraceDecoder& decoder, double speed)
+{
+	DroneSimulator simulator;
+
+	const auto replay_start{ std::chrono::steady_clock::now() };
+
+	TraceEvent event;
+
+	while (decoder.readEvent(event)) {
+		if (event.opcode == Opcodes::CMD) {
+			const string command{ decoder.droneCommand() };
+			const std::chrono::duration<double, std::milli> offset{ decoder.timestamp() / speed };
+			std::this_thread::sleep_until(replay_start +
+				std::chrono::duration_cast<std::chrono::steady_clock::duration>(offset));
+			cout << right << setw(10) << decoder.timestamp() << " ms    CMD " << command << endl;
+			const std::size_t n{ command.length() };
+			if ((command != "<initialize>") && (n > 2) && (command[0] == '<') && (command[n - 1] == '>')) {
+				simulator.sendCommand(command.substr(1, n - 2));
+			}
+		}
+	}
+
+	cout << endl << "Press any letter followed by the return key to exit the replay: ";
+	char c;
+	cin >> c;
+}
+
+
+int main(int argc, char* argv[])
+{
+	if ((argc < 3) || ((argc > 3) && (string(argv[3]) != "replay"))) {
+		cout << "Usage: fpl-trace <FPL file> <trace file> [replay [speed]]" << endl;
+		return 1;
+	}
+
+	const string file_name{ argv[1] };
+	const string trace_name{ argv[2] };
+	const bool   replay{ argc > 3 };
+	double       speed{ 1.0 };
+
+	if (argc > 4) {
+		char* end;
+		speed = std::strtod(argv[4], &end);
+		if ((end == argv[4]) || (*end != '\0')) {
+			speed = 0.0;
+		}
+	}
+
+	if (!(speed > 0.0)) {
+		cout << "The replay speed must be a number greater than zero" << endl;
+		cout << "Usage: fpl-trace <FPL file> <trace file> [replay [speed]]" << endl;
+		return 1;
+	}
+
+	ifstream fpl_file(file_name);
+
+	if (!fpl_file.is_open()) {
+		cout << "File " << file_name << " not found" << endl;
+		return 1;
+	}
+
+	IntVariableTable  int_variables;
+	LabelTable        labels;
+	DroneCommandTable drone_commands;
+	InstructionTable  instructions;
+	FlightPlanParse   fpl_parse(int_variables, labels, drone_commands, instructions);
+	string            line;
+	while (getline(fpl_file, line)) {
+		line += ' ';
+		fpl_parse.parseLine(line);
+	}
+
+	if (!fpl_parse.parseSuccess()) {
+		cout << "File " << file_name << " did not parse successfully" << endl;
+		return 1;
+	}
+
+	TraceDecoder decoder(int_variables, labels, drone_commands, instructions);
+
+	if (!decoder.open(trace_name)) {
+		return 1;
+	}
+
+	if (replay) {
+		replayTrace(decoder, speed);
+	}
+	else {
+		decodeTrace(decoder, int_variables, labels, drone_commands);
+	}
+
+	return 0;
+}
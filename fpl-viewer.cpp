@@ -0,0 +1,339 @@
+#include "DroneSimulatorApi.h"
+#include "SimulatorLink.h"
+#include "SimulatorScene.h"
+#include "TrajectoryFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using std::cin;
+using std::cout;
+using std::endl;
+using std::getline;
+using std::istringstream;
+using std::lock_guard;
+using std::mutex;
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+
+// A drone simulator viewer that runs in its own process, displaying the simulator commands of FPL
+// programs executed with FlightPlanExecute::useSimulatorViewer() in other processes.
+// Each program's commands arrive through a named shared memory link and are drawn as a drone in
+// the shared simulator window, so one viewer can watch several missions at once. The viewer can be
+// started before or after the programs; it attaches to each link as soon as it exists. A mission
+// is not affected if the viewer falls behind, stalls or exits.
+//
+// The viewer can also replay a trajectory file recorded with FlightPlanExecute::recordTrajectory(),
+// at any speed, seeking backwards and forwards in the mission with commands typed on the console.
+//
+// Usage: fpl-viewer <link name> [<link name> ...]   the names shown by the executing programs,
+//                                                   such as fpl-simulator-1234
+//        fpl-viewer --replay <trajectory file> [speed]
+//                                                   replays the mission, optionally faster
+//                                                   (speed 2 = twice as fast)
+
+
+// One link being watched and the simulated drone displaying its commands.
+
+struct ViewedLink
+{
+	string                     name;			// the shared memory name given on the command line
+	SimulatorLink              link;			// open while attached
+	unique_ptr<DroneSimulator> drone;			// created when attached to each mission
+	bool                       finished{ false };	// the mission has ended and every command was taken
+};
+
+
+// Take up to max_commands waiting commands from a link into its simulated drone, attaching to the
+// link first if it now exists, and return the number taken.
+// Once the sending program has finished and its last command has been taken the link is closed.
+// A new mission later sent through a link with the same name is displayed as a new drone.
+
+static int forwardCommands(ViewedLink& viewed, int max_commands)
+{
+	if (!viewed.link.isOpen()) {
+		if (!viewed.link.attach(viewed.name, true)) {
+			return 0;
+		}
+		if (viewed.finished) {
+			// The sender removes the name of the segment when it finishes, so a segment found under
+			// the same name is a new mission, unless it was left behind by a sender that crashed.
+			if (viewed.link.senderFinished()) {
+				viewed.link.close();
+				return 0;
+			}
+			viewed.finished = false;
+			viewed.drone.reset();
+		}
+		cout << "Attached to " << viewed.name << endl;
+		if (viewed.drone == nullptr) {
+			viewed.drone.reset(new DroneSimulator(viewed.link.startPosition()));
+		}
+	}
+
+	// Check whether the sender has finished before taking commands, so that a command sent just
+	// before it finished is not left behind.
+	const bool sender_finished{ viewed.link.senderFinished() };
+
+	int              num_commands{ 0 };
+	SimulatorCommand command;
+
+	while ((num_commands < max_commands) && viewed.link.receiveCommand(command)) {
+		viewed.drone->sendCommand(command);
+		num_commands++;
+	}
+
+	if (sender_finished && (num_commands < max_commands)) {
+		cout << "Mission in " << viewed.name << " finished";
+		if (viewed.link.droppedCommands() > 0) {
+			cout << " (" << viewed.link.droppedCommands() << " commands dropped)";
+		}
+		cout << endl;
+		viewed.drone->displayMotionReport();
+		viewed.link.close();
+		viewed.finished = true;
+	}
+
+	return num_commands;
+}
+
+
+// Console requests that control a replay, shared between the console thread and the replay loop.
+
+struct ReplayControl
+{
+	mutex     control_mutex;			// ensures thread-safe access to the other members
+	double    speed{ 1.0 };				// mission milliseconds replayed per real millisecond
+	bool      paused{ false };			// the replay is paused
+	long long seek_ms{ -1 };			// mission time to seek to, or -1 if no seek was requested
+	long long skip_ms{ 0 };				// relative seek requested, added to the replay time
+	bool      quit{ false };			// the replay should end
+};
+
+
+// Read replay commands typed on the console until "q" is entered or the console is closed.
+// The control is shared because the console thread may still be waiting for input when the replay
+// ends.
+
+static void readReplayCommands(shared_ptr<ReplayControl> shared_control)
+{
+	ReplayControl& control{ *shared_control };
+
+	string line;
+
+	while (getline(cin, line)) {
+		istringstream iss_line(line);
+		string        command;
+		double        value{ 0.0 };
+		iss_line >> command;
+		const bool has_value{ static_cast<bool>(iss_line >> value) };
+
+		lock_guard<mutex> lock(control.control_mutex);
+
+		if (command == "p") {
+			control.paused = !control.paused;
+		}
+		else if ((command == "s") && has_value && (value >= 0.0)) {
+			control.seek_ms = static_cast<long long>(value * 1000.0);
+			control.skip_ms = 0;
+		}
+		else if (command == "f") {
+			control.skip_ms += static_cast<long long>((has_value ? value : 10.0) * 1000.0);
+		}
+		else if (command == "b") {
+			control.skip_ms -= static_cast<long long>((has_value ? value : 10.0) * 1000.0);
+		}
+		else if ((command == "x") && has_value && (value > 0.0)) {
+			control.speed = value;
+		}
+		else if (command == "q") {
+			control.quit = true;
+			return;
+		}
+		else {
+			cout << "Replay commands: p (pause or resume), s <seconds> (seek), f [seconds] (forward), "
+				 << "b [seconds] (back), x <speed>, q (quit)" << endl;
+		}
+	}
+}
+
+
+// Move the replay to a mission time, sending every command up to that time to the simulated drone
+// as an instant command so that the drone and its flight path are shown as they were at that time.
+// Seeking backwards starts again from the beginning of the file with an empty flight path.
+
+static void seekReplay(TrajectoryFile& file, SimulatorScene& scene, DroneSimulator& drone, double& replay_ms,
+					   long long target_ms)
+{
+	target_ms = std::min(target_ms, file.duration());
+
+	scene.setClock(target_ms);
+
+	if (target_ms < replay_ms) {
+		SimulatorCommand reset;
+		reset.type    = SimulatorCommandType::RESET;
+		reset.instant = true;
+		drone.sendCommand(reset);
+		file.rewind();
+	}
+
+	TrajectoryRecord record;
+
+	while ((file.nextTime() >= 0) && (file.nextTime() <= target_ms) && file.readRecord(record)) {
+		record.command.instant = true;
+		drone.sendCommand(record.command);
+	}
+
+	replay_ms = double(target_ms);
+}
+
+
+// Replay a trajectory file into a simulated drone in real time multiplied by the speed, following
+// the seek, pause and speed commands typed on the console, until the window is closed or "q" is
+// entered.
+// The scene's clock is driven by the replay's mission time, so the drone flies at the replay's
+// speed, stops while the replay is paused, and each command keeps its recorded time.
+
+static void replayTrajectory(TrajectoryFile& file, double speed)
+{
+	const int IDLE_WAIT_MS{ 5 };	// sleep between checks for commands that are due
+
+	SimulatorScene&                 scene{ SimulatorScene::sharedScene() };
+	DroneSimulator                  drone;
+	const shared_ptr<ReplayControl> shared_control{ std::make_shared<ReplayControl>() };
+	ReplayControl&                  control{ *shared_control };
+
+	control.speed = speed;
+
+	scene.setClock(0);
+
+	cout << "Replaying " << file.numRecords() << " drone commands over " << std::fixed << std::setprecision(1)
+		 << file.duration() / 1000.0 << " seconds" << std::defaultfloat << endl;
+	cout << "Replay commands: p (pause or resume), s <seconds> (seek), f [seconds] (forward), "
+		 << "b [seconds] (back), x <speed>, q (quit)" << endl;
+
+	std::thread console_thread(readReplayCommands, shared_control);
+	console_thread.detach();
+
+	double replay_ms{ 0.0 };
+	bool   finished{ false };
+	auto   previous_time{ std::chrono::steady_clock::now() };
+
+	while (scene.rendering()) {
+		long long seek_ms{ -1 };
+		double    current_speed{ 1.0 };
+		bool      paused{ false };
+		{
+			lock_guard<mutex> lock(control.control_mutex);
+			if (control.quit) {
+				break;
+			}
+			if (control.seek_ms >= 0) {
+				seek_ms = control.seek_ms;
+			}
+			else if (control.skip_ms != 0) {
+				seek_ms = std::max(0LL, static_cast<long long>(replay_ms) + control.skip_ms);
+			}
+			control.seek_ms = -1;
+			control.skip_ms = 0;
+			current_speed   = control.speed;
+			paused          = control.paused;
+		}
+
+		const auto   now{ std::chrono::steady_clock::now() };
+		const double elapsed_ms{ std::chrono::duration<double, std::milli>(now - previous_time).count() };
+		previous_time = now;
+
+		if (seek_ms >= 0) {
+			seekReplay(file, scene, drone, replay_ms, seek_ms);
+			cout << "Replay at " << std::fixed << std::setprecision(1) << replay_ms / 1000.0 << " seconds"
+				 << std::defaultfloat << endl;
+			finished = false;
+		}
+		else if (!paused) {
+			replay_ms += elapsed_ms * current_speed;
+			scene.setClock(static_cast<long long>(replay_ms));
+			TrajectoryRecord record;
+			while ((file.nextTime() >= 0) && (file.nextTime() <= replay_ms) && file.readRecord(record)) {
+				drone.sendCommand(record.command);
+			}
+		}
+
+		if (!finished && (file.nextTime() < 0)) {
+			cout << "Replay finished - seek to watch again" << endl;
+			finished = true;
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_WAIT_MS));
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	const int MAX_COMMANDS_PER_LINK{ 256 };	// commands taken from one link before moving to the next
+	const int IDLE_WAIT_MS{ 5 };				// sleep when no link had a command
+
+	if ((argc < 2) || ((string(argv[1]) == "--replay") && ((argc < 3) || (argc > 4)))) {
+		cout << "Usage: fpl-viewer <link name> [<link name> ...]" << endl;
+		cout << "       fpl-viewer --replay <trajectory file> [speed]" << endl;
+		return 1;
+	}
+
+	if (string(argv[1]) == "--replay") {
+		double speed{ 1.0 };
+		if (argc > 3) {
+			char* end;
+			speed = std::strtod(argv[3], &end);
+			if ((end == argv[3]) || (*end != '\0')) {
+				speed = 0.0;
+			}
+		}
+		if (!(speed > 0.0)) {
+			cout << "The replay speed must be a number greater than zero" << endl;
+			cout << "Usage: fpl-viewer --replay <trajectory file> [speed]" << endl;
+			return 1;
+		}
+		TrajectoryFile file;
+		if (!file.open(argv[2])) {
+			return 1;
+		}
+		replayTrajectory(file, speed);
+		return 0;
+	}
+
+	vector<ViewedLink> links(argc - 1);
+
+	for (int i{ 1 }; i < argc; i++) {
+		links[i - 1].name = argv[i];
+	}
+
+	SimulatorScene& scene{ SimulatorScene::sharedScene() };
+
+	cout << "Waiting for drone simulator commands - close the simulator window to exit" << endl;
+
+	// Take commands from every link in turn until the window is closed.
+	while (scene.rendering()) {
+		int num_commands{ 0 };
+		for (ViewedLink& viewed : links) {
+			num_commands += forwardCommands(viewed, MAX_COMMANDS_PER_LINK);
+		}
+		if (num_commands == 0) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(IDLE_WAIT_MS));
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,595 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+
+using std::cout;
+using std::endl;
+using std::istringstream;
+using std::string;
+using std::vector;
+
+
+// An emulator of one or more Tello drones speaking the Tello SDK 2.0 UDP protocol on localhost,
+// so that the Tello class can be measured and tested without drones. It runs on Linux.
+// Each emulated drone answers commands on its own UDP port with "ok", "error" or the value queried,
+// as a Tello does: motion commands are answered once the motion would have finished. Once a drone
+// has accepted "command" it sends its state to the sender's address ten times a second.
+// Every datagram the emulator sends can be delayed, lost or reordered to imitate a congested
+// Wi-Fi link, and requests can be lost before they reach the drone.
+// See tello-load.cpp for a load generator that drives the emulated drones through the Tello class.
+//
+// Usage: tello-emulator [options]
+//   --drones n          number of emulated drones (default 1)
+//   --port p            UDP command port of the first drone; drone i uses port p + i (default 9000)
+//   --state-port p      UDP port the first drone's state is sent to; drone i uses p + i (default 8890)
+//   --shared-state n    1 to send every drone's state to the --state-port port, as TelloSwarm
+//                       expects (default 0)
+//   --latency ms        delay added to every datagram sent (default 5)
+//   --jitter ms         maximum random variation of the delay (default 2)
+//   --loss fraction     probability that a request or a datagram sent is lost (default 0)
+//   --reorder fraction  probability that a datagram sent is held back behind later ones (default 0)
+//   --time-scale x      factor applied to motion durations, 0 to answer motions at once (default 1)
+//   --seed n            seed for the random delays and losses (default 1)
+// The emulator runs until interrupted, then writes how many datagrams it handled.
+
+
+// The options given on the command line.
+
+struct EmulatorOptions
+{
+	int            num_drones{ 1 };
+	unsigned short command_port{ 9000 };
+	unsigned short state_port{ 8890 };
+	bool           shared_state{ false };
+	double         latency_ms{ 5.0 };
+	double         jitter_ms{ 2.0 };
+	double         loss{ 0.0 };
+	double         reorder{ 0.0 };
+	double         time_scale{ 1.0 };
+	unsigned       seed{ 1 };
+};
+
+
+// The emulated state of one drone.
+
+struct EmulatedDrone
+{
+	int            socket_fd{ -1 };			// bound to the drone's command port
+	unsigned short state_port{ 0 };			// port on the client's host that receives the state
+	sockaddr_in    client_addr{};			// sender of the latest command
+	bool           sdk_mode{ false };		// "command" has been accepted
+	bool           flying{ false };			// airborne after "takeoff"
+	double         x{ 0.0 };				// position in cm
+	double         y{ 0.0 };
+	double         z{ 0.0 };
+	int            yaw{ 0 };				// heading in degrees
+	int            speed{ 10 };				// speed set by "speed" in cm/s
+	double         battery{ 100.0 };		// battery percentage
+	long long      takeoff_ms{ 0 };			// time of the latest takeoff
+	long long      busy_until_ms{ 0 };		// end of the motion in progress
+	long long      requests{ 0 };			// commands received
+	long long      responses{ 0 };			// responses sent
+};
+
+
+// A datagram waiting for its delay to pass.
+
+struct DelayedDatagram
+{
+	long long   due_ms;						// time to send it
+	long long   order;						// tie breaker preserving the order of equal due times
+	int         socket_fd;					// socket to send it from
+	sockaddr_in destination;
+	string      text;
+
+	bool operator>(const DelayedDatagram& other) const
+	{
+		return (due_ms != other.due_ms) ? (due_ms > other.due_ms) : (order > other.order);
+	}
+};
+
+
+static volatile std::sig_atomic_t interrupted{ 0 };	// set by SIGINT or SIGTERM
+
+
+static void interruptHandler(int)
+{
+	interrupted = 1;
+}
+
+
+// Return the steady clock time in milliseconds.
+
+static long long steadyMilliseconds()
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+// Sends datagrams after the configured delay, unless they are lost, holding some back so that
+// they arrive out of order.
+
+class DatagramScheduler
+{
+public:
+
+	DatagramScheduler(const EmulatorOptions& options) :
+		options(options),
+		random(options.seed)
+	{}
+
+	// Return whether a datagram should be lost.
+
+	bool lose()
+	{
+		return uniform(random) < options.loss;
+	}
+
+	// Queue a datagram to be sent after the transmission delay plus extra_ms.
+
+	void send(int socket_fd, const sockaddr_in& destination, const string& text, double extra_ms)
+	{
+		if (lose()) {
+			lost++;
+			return;
+		}
+
+		double delay_ms{ options.latency_ms + options.jitter_ms * (2.0 * uniform(random) - 1.0) + extra_ms };
+
+		if (uniform(random) < options.reorder) {
+			delay_ms += options.latency_ms + 2.0 * options.jitter_ms + 1.0;	// behind the next datagram
+			reordered++;
+		}
+
+		pending.push({ steadyMilliseconds() + std::max(0LL, static_cast<long long>(delay_ms)), next_order++,
+					   socket_fd, destination, text });
+	}
+
+	// Send every datagram that is due, and return the number of milliseconds until the next one,
+	// or -1 if none is waiting.
+
+	int sendDue()
+	{
+		const long long now{ steadyMilliseconds() };
+
+		while (!pending.empty() && (pending.top().due_ms <= now)) {
+			const DelayedDatagram& datagram{ pending.top() };
+			sendto(datagram.socket_fd, datagram.text.data(), datagram.text.length(), 0,
+				   (const sockaddr*)&datagram.destination, sizeof(datagram.destination));
+			sent++;
+			pending.pop();
+		}
+
+		return pending.empty() ? -1 : static_cast<int>(pending.top().due_ms - now);
+	}
+
+	long long sent{ 0 };		// datagrams sent
+	long long lost{ 0 };		// datagrams and requests lost
+	long long reordered{ 0 };	// datagrams held back
+
+private:
+
+	const EmulatorOptions& options;
+
+	std::mt19937                           random;
+	std::uniform_real_distribution<double> uniform{ 0.0, 1.0 };
+
+	std::priority_queue<DelayedDatagram, vector<DelayedDatagram>, std::greater<DelayedDatagram>> pending;
+	long long next_order{ 0 };
+};
+
+
+// Return whether value lies within [low, high].
+
+static bool inRange(int value, int low, int high)
+{
+	return (value >= low) && (value <= high);
+}
+
+
+// Carry out a command on an emulated drone and return the response, or an empty string if a
+// Tello would not respond. motion_ms receives the time the command's motion takes.
+
+static string executeCommand(EmulatedDrone& drone, const string& command, long long now, double& motion_ms)
+{
+	istringstream iss_command(command);
+	string        name;
+	iss_command >> name;
+
+	motion_ms = 0.0;
+
+	if (name == "command") {
+		drone.sdk_mode = true;
+		return "ok";
+	}
+	if (!drone.sdk_mode) {
+		return "";
+	}
+
+	// Queries
+
+	char text[96];
+
+	if (name == "battery?") {
+		snprintf(text, sizeof(text), "%d", int(drone.battery));
+		return text;
+	}
+	if (name == "speed?") {
+		snprintf(text, sizeof(text), "%d.0", drone.speed);
+		return text;
+	}
+	if (name == "time?") {
+		snprintf(text, sizeof(text), "%llds", drone.flying ? (now - drone.takeoff_ms) / 1000 : 0LL);
+		return text;
+	}
+	if (name == "height?") {
+		snprintf(text, sizeof(text), "%ddm", int(drone.z) / 10);
+		return text;
+	}
+	if (name == "temp?") {
+		return "60~63C";
+	}
+	if (name == "attitude?") {
+		snprintf(text, sizeof(text), "pitch:0;roll:0;yaw:%d;", drone.yaw);
+		return text;
+	}
+	if (name == "baro?") {
+		snprintf(text, sizeof(text), "%.2f", drone.z / 100.0);
+		return text;
+	}
+	if (name == "tof?") {
+		snprintf(text, sizeof(text), "%dmm", std::max(100, int(drone.z) * 10));
+		return text;
+	}
+	if (name == "wifi?") {
+		return "90";
+	}
+	if (name == "sdk?") {
+		return "20";
+	}
+	if (name == "sn?") {
+		return "0TQZEMULATOR";
+	}
+
+	// Settings
+
+	int value{ 0 };
+
+	if (name == "speed") {
+		if (!(iss_command >> value) || !inRange(value, 10, 100)) {
+			return "error";
+		}
+		drone.speed = value;
+		return "ok";
+	}
+	if ((name == "streamon") || (name == "streamoff") || (name == "mon") || (name == "moff") ||
+		(name == "mdirection")) {
+		return "ok";
+	}
+	if (name == "emergency") {
+		drone.flying        = false;
+		drone.z             = 0.0;
+		drone.busy_until_ms = 0;
+		return "ok";
+	}
+
+	// Motion commands, which a Tello rejects while a motion is in progress.
+
+	if (now < drone.busy_until_ms) {
+		return "error Not joystick";
+	}
+
+	if (name == "takeoff") {
+		if (drone.flying) {
+			return "error";
+		}
+		drone.flying     = true;
+		drone.takeoff_ms = now;
+		drone.z          = 80.0;
+		motion_ms        = 5000.0;
+		return "ok";
+	}
+	if (!drone.flying) {
+		return "error Motor stop";
+	}
+	if (name == "land") {
+		drone.flying = false;
+		motion_ms    = 1000.0 * drone.z / 50.0;
+		drone.z      = 0.0;
+		return "ok";
+	}
+	if (name == "stop") {
+		return "ok";
+	}
+
+	const double heading{ drone.yaw * 3.14159265358979 / 180.0 };
+
+	if ((name == "up") || (name == "down") || (name == "left") || (name == "right") ||
+		(name == "forward") || (name == "back")) {
+		if (!(iss_command >> value) || !inRange(value, 20, 500)) {
+			return "error";
+		}
+		const double direction{ (name == "left") ? 1.0 : ((name == "right") ? -1.0 : 0.0) };
+		const double advance{ (name == "forward") ? 1.0 : ((name == "back") ? -1.0 : 0.0) };
+		drone.x += value * (advance * cos(heading) - direction * sin(heading));
+		drone.y += value * (advance * sin(heading) + direction * cos(heading));
+		drone.z += (name == "up") ? value : ((name == "down") ? -value : 0);
+		drone.z  = std::max(0.0, drone.z);
+		motion_ms = 1000.0 * value / drone.speed;
+		return "ok";
+	}
+	if ((name == "cw") || (name == "ccw")) {
+		if (!(iss_command >> value) || !inRange(value, 1, 3600)) {
+			return "error";
+		}
+		drone.yaw = (((drone.yaw + ((name == "cw") ? value : -value)) % 360) + 360) % 360;
+		motion_ms = 1000.0 * value / 90.0;
+		return "ok";
+	}
+	if (name == "flip") {
+		string direction;
+		if (!(iss_command >> direction) || (direction.length() != 1) || (string("lrfb").find(direction) == string::npos)) {
+			return "error";
+		}
+		motion_ms = 1500.0;
+		return "ok";
+	}
+	if (name == "go") {
+		int x{ 0 };
+		int y{ 0 };
+		int z{ 0 };
+		int go_speed{ 0 };
+		if (!(iss_command >> x >> y >> z >> go_speed) || !inRange(x, -500, 500) || !inRange(y, -500, 500) ||
+			!inRange(z, -500, 500) || !inRange(go_speed, 10, 100) ||
+			(inRange(x, -20, 20) && inRange(y, -20, 20) && inRange(z, -20, 20))) {
+			return "error";
+		}
+		drone.x  += x * cos(heading) - y * sin(heading);
+		drone.y  += x * sin(heading) + y * cos(heading);
+		drone.z   = std::max(0.0, drone.z + z);
+		motion_ms = 1000.0 * std::sqrt(double(x * x + y * y + z * z)) / go_speed;
+		return "ok";
+	}
+	if (name == "curve") {
+		int coordinates[6];
+		int curve_speed{ 0 };
+		for (int& coordinate : coordinates) {
+			if (!(iss_command >> coordinate) || !inRange(coordinate, -500, 500)) {
+				return "error";
+			}
+		}
+		if (!(iss_command >> curve_speed) || !inRange(curve_speed, 10, 60)) {
+			return "error";
+		}
+		drone.x  += coordinates[3];
+		drone.y  += coordinates[4];
+		drone.z   = std::max(0.0, drone.z + coordinates[5]);
+		motion_ms = 1000.0 * (std::hypot(coordinates[0], coordinates[1]) +
+							  std::hypot(coordinates[3] - coordinates[0], coordinates[4] - coordinates[1])) / curve_speed;
+		return "ok";
+	}
+
+	return "error";
+}
+
+
+// Return the state packet of an emulated drone in the Tello's format.
+
+static string formatState(const EmulatedDrone& drone, long long now)
+{
+	char text[320];
+
+	snprintf(text, sizeof(text),
+			 "mid:-1;x:0;y:0;z:0;mpry:0,0,0;pitch:0;roll:0;yaw:%d;vgx:0;vgy:0;vgz:0;templ:60;temph:63;"
+			 "tof:%d;h:%d;bat:%d;baro:%.2f;time:%lld;agx:0.00;agy:0.00;agz:-1000.00;\r\n",
+			 drone.yaw > 180 ? drone.yaw - 360 : drone.yaw, std::max(10, int(drone.z)), int(drone.z),
+			 int(drone.battery), drone.z / 100.0, drone.flying ? (now - drone.takeoff_ms) / 1000 : 0LL);
+
+	return text;
+}
+
+
+// Read the command line options into the options argument and return whether they are valid.
+
+static bool parseOptions(int argc, char* argv[], EmulatorOptions& options)
+{
+	for (int i{ 1 }; i < argc; i += 2) {
+		const string option{ argv[i] };
+		if (i + 1 >= argc) {
+			return false;
+		}
+		const double value{ atof(argv[i + 1]) };
+		if (option == "--drones") {
+			options.num_drones = int(value);
+		}
+		else if (option == "--port") {
+			options.command_port = static_cast<unsigned short>(value);
+		}
+		else if (option == "--state-port") {
+			options.state_port = static_cast<unsigned short>(value);
+		}
+		else if (option == "--shared-state") {
+			options.shared_state = (value != 0.0);
+		}
+		else if (option == "--latency") {
+			options.latency_ms = value;
+		}
+		else if (option == "--jitter") {
+			options.jitter_ms = value;
+		}
+		else if (option == "--loss") {
+			options.loss = value;
+		}
+		else if (option == "--reorder") {
+			options.reorder = value;
+		}
+		else if (option == "--time-scale") {
+			options.time_scale = value;
+		}
+		else if (option == "--seed") {
+			options.seed = static_cast<unsigned>(value);
+		}
+		else {
+			return false;
+		}
+	}
+
+	return (options.num_drones > 0) && (options.latency_ms >= 0.0) && (options.jitter_ms >= 0.0) &&
+		   (options.jitter_ms <= options.latency_ms) && (options.time_scale >= 0.0);
+}
+
+
+int main(int argc, char* argv[])
+{
+	const int       MAX_EVENTS{ 64 };			// socket events handled per epoll_wait() call
+	const long long STATE_INTERVAL_MS{ 100 };	// time between state packets
+	const unsigned  BUFFER_SIZE{ 512 };			// command receive buffer size
+
+	EmulatorOptions options;
+
+	if (!parseOptions(argc, argv, options)) {
+		cout << "Usage: tello-emulator [--drones n] [--port p] [--state-port p] [--shared-state n]" << endl;
+		cout << "                      [--latency ms] [--jitter ms] [--loss fraction] [--reorder fraction]" << endl;
+		cout << "                      [--time-scale x] [--seed n]" << endl;
+		cout << "The jitter may not exceed the latency." << endl;
+		return 1;
+	}
+
+	const int epoll_fd{ epoll_create1(EPOLL_CLOEXEC) };
+
+	if (epoll_fd < 0) {
+		cout << "Error creating the event loop (" << strerror(errno) << ')' << endl;
+		return 1;
+	}
+
+	vector<EmulatedDrone> drones(options.num_drones);
+
+	for (int i{ 0 }; i < options.num_drones; i++) {
+		EmulatedDrone& drone{ drones[i] };
+		sockaddr_in    drone_addr{};
+
+		drone_addr.sin_family      = AF_INET;
+		drone_addr.sin_port        = htons(static_cast<unsigned short>(options.command_port + i));
+		drone_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		drone.state_port = static_cast<unsigned short>(options.shared_state ? options.state_port : options.state_port + i);
+		drone.socket_fd  = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP);
+
+		epoll_event event{};
+		event.events   = EPOLLIN;
+		event.data.u32 = static_cast<uint32_t>(i);
+
+		if ((drone.socket_fd < 0) || (::bind(drone.socket_fd, (sockaddr*)&drone_addr, sizeof(drone_addr)) != 0) ||
+			(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, drone.socket_fd, &event) != 0)) {
+			cout << "Unable to listen on port " << options.command_port + i << " (" << strerror(errno) << ')' << endl;
+			return 1;
+		}
+	}
+
+	std::signal(SIGINT, interruptHandler);
+	std::signal(SIGTERM, interruptHandler);
+
+	cout << "Emulating " << options.num_drones << " Tello drone(s) on 127.0.0.1 ports " << options.command_port
+		 << " to " << options.command_port + options.num_drones - 1 << " - interrupt to stop" << endl;
+
+	DatagramScheduler scheduler(options);
+	epoll_event       events[MAX_EVENTS];
+	char              buffer[BUFFER_SIZE];
+	long long         next_state_ms{ steadyMilliseconds() };
+
+	while (!interrupted) {
+		// Sleep until a request arrives, a delayed datagram is due or the state is due.
+		const long long now{ steadyMilliseconds() };
+		const int       next_datagram_ms{ scheduler.sendDue() };
+		int             timeout_ms{ static_cast<int>(std::max(0LL, next_state_ms - now)) };
+
+		if (next_datagram_ms >= 0) {
+			timeout_ms = std::min(timeout_ms, next_datagram_ms);
+		}
+
+		const int num_events{ epoll_wait(epoll_fd, events, MAX_EVENTS, timeout_ms) };
+
+		if ((num_events < 0) && (errno != EINTR)) {
+			cout << "Failed to wait for requests (" << strerror(errno) << ')' << endl;
+			break;
+		}
+
+		for (int i{ 0 }; i < num_events; i++) {
+			EmulatedDrone& drone{ drones[events[i].data.u32] };
+
+			while (true) {
+				sockaddr_in   sender{};
+				socklen_t     sender_length{ sizeof(sender) };
+				const ssize_t length{ recvfrom(drone.socket_fd, buffer, BUFFER_SIZE, 0, (sockaddr*)&sender, &sender_length) };
+
+				if (length < 0) {
+					break;
+				}
+
+				drone.requests++;
+				if (scheduler.lose()) {
+					scheduler.lost++;
+					continue;
+				}
+
+				double       motion_ms{ 0.0 };
+				const string response{ executeCommand(drone, string(buffer, size_t(length)), steadyMilliseconds(), motion_ms) };
+
+				drone.client_addr = sender;
+				if (!response.empty()) {
+					motion_ms *= options.time_scale;
+					drone.busy_until_ms = steadyMilliseconds() + static_cast<long long>(motion_ms);
+					scheduler.send(drone.socket_fd, sender, response, motion_ms);
+					drone.responses++;
+				}
+			}
+		}
+
+		// Send each drone's state, and drain the battery of flying drones by 1% a minute.
+		if (steadyMilliseconds() >= next_state_ms) {
+			const long long state_time{ steadyMilliseconds() };
+			for (EmulatedDrone& drone : drones) {
+				if (drone.flying) {
+					drone.battery = std::max(0.0, drone.battery - STATE_INTERVAL_MS / 60000.0);
+				}
+				if (drone.sdk_mode) {
+					sockaddr_in state_addr{ drone.client_addr };
+					state_addr.sin_port = htons(drone.state_port);
+					scheduler.send(drone.socket_fd, state_addr, formatState(drone, state_time), 0.0);
+				}
+			}
+			next_state_ms += STATE_INTERVAL_MS;
+		}
+	}
+
+	long long requests{ 0 };
+	long long responses{ 0 };
+
+	for (EmulatedDrone& drone : drones) {
+		requests  += drone.requests;
+		responses += drone.responses;
+		close(drone.socket_fd);
+	}
+	close(epoll_fd);
+
+	cout << endl << requests << " requests received, " << responses << " responses, " << scheduler.sent
+		 << " datagrams sent, " << scheduler.lost << " lost, " << scheduler.reordered << " reordered" << endl;
+
+	return 0;
+}
@@ -0,0 +1,146 @@
+#include "TelloApi.h"
+#include "TelloSwarm.h"
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+using std::cout;
+using std::endl;
+using std::future;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+
+// A load generator that measures the command throughput and response times of the Tello class
+// against drones emulated by tello-emulator on the same computer.
+// Every drone is initialized, then each is submitted the same number of commands at once, cycling
+// through a setting, a query the Tello state cannot answer, a query it can answer and a short
+// motion. The Tello sends them one at a time as a real Tello requires, so the throughput of each
+// drone is limited by its round trip time, and the drones run in parallel.
+// With --swarm 1 the drones are driven by one TelloSwarm instead of a Tello object each, and
+// the emulator must be started with --shared-state 1.
+// Start the emulator first with --time-scale 0 unless the motions should take their real time.
+//
+// Usage: tello-load [--drones n] [--port p] [--state-port p] [--commands n] [--swarm n]
+//   the ports must match those given to tello-emulator (defaults 9000 and 8890)
+
+
+int main(int argc, char* argv[])
+{
+	static const char* const COMMANDS[]{ "speed 50", "wifi?", "battery?", "forward 20" };
+
+	const int STATE_WAIT_MS{ 300 };		// time allowed for the first state packets after initialization
+
+	int            num_drones{ 1 };
+	unsigned short command_port{ 9000 };
+	unsigned short state_port{ 8890 };
+	int            num_commands{ 1000 };
+	bool           use_swarm{ false };
+
+	for (int i{ 1 }; i + 1 < argc; i += 2) {
+		const string option{ argv[i] };
+		const int    value{ atoi(argv[i + 1]) };
+		if (option == "--drones") {
+			num_drones = value;
+		}
+		else if (option == "--port") {
+			command_port = static_cast<unsigned short>(value);
+		}
+		else if (option == "--state-port") {
+			state_port = static_cast<unsigned short>(value);
+		}
+		else if (option == "--commands") {
+			num_commands = value;
+		}
+		else if (option == "--swarm") {
+			use_swarm = (value != 0);
+		}
+		else {
+			argc = 0;
+		}
+	}
+
+	if ((argc % 2 == 0) || (num_drones <= 0) || (num_commands <= 0)) {
+		cout << "Usage: tello-load [--drones n] [--port p] [--state-port p] [--commands n] [--swarm n]" << endl;
+		return 1;
+	}
+
+	vector<unique_ptr<Tello>> drones;
+	TelloSwarm                swarm(0, state_port);
+
+	for (int i{ 0 }; use_swarm && (i < num_drones); i++) {
+		swarm.addDrone("127.0.0.1", static_cast<unsigned short>(command_port + i));
+	}
+
+	if (use_swarm) {
+		swarm.setCommandEcho(false);
+		if (!swarm.start()) {
+			cout << "The emulated drones could not be initialized" << endl;
+			return 1;
+		}
+		vector<future<bool>> takeoffs;
+		for (int i{ 0 }; i < num_drones; i++) {
+			takeoffs.push_back(swarm.submit(i, "takeoff"));
+		}
+		for (future<bool>& takeoff : takeoffs) {
+			takeoff.get();
+		}
+	}
+
+	for (int i{ 0 }; !use_swarm && (i < num_drones); i++) {
+		drones.emplace_back(new Tello("127.0.0.1", static_cast<unsigned short>(command_port + i), 0,
+									  static_cast<unsigned short>(state_port + i)));
+		if (!drones.back()->canInitialize() || !drones.back()->sendCommand("takeoff")) {
+			cout << "Emulated drone " << i + 1 << " on port " << command_port + i << " could not be initialized" << endl;
+			return 1;
+		}
+		drones.back()->setCommandEcho(false);
+	}
+
+	// Give the drones time to send their first state, so that queries it answers are not sent.
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(STATE_WAIT_MS));
+
+	// Submit every command to every drone, then wait for all the results.
+
+	const auto start{ std::chrono::steady_clock::now() };
+
+	vector<future<bool>> results;
+	results.reserve(size_t(num_drones) * num_commands);
+
+	for (int command{ 0 }; command < num_commands; command++) {
+		for (int i{ 0 }; i < num_drones; i++) {
+			results.push_back(use_swarm ? swarm.submit(i, COMMANDS[command % 4]) : drones[i]->submit(COMMANDS[command % 4]));
+		}
+	}
+
+	int num_failed{ 0 };
+
+	for (future<bool>& result : results) {
+		num_failed += result.get() ? 0 : 1;
+	}
+
+	const double elapsed_s{ std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() };
+
+	for (int i{ 0 }; i < num_drones; i++) {
+		if (use_swarm) {
+			swarm.displayLatencyReport(i);
+		}
+		else {
+			cout << endl << "Emulated drone " << i + 1 << ':';
+			drones[i]->displayLatencyReport();
+		}
+	}
+
+	cout << endl << results.size() << " commands to " << num_drones << " drone(s) in " << elapsed_s << " s: "
+		 << results.size() / elapsed_s << " commands/s, " << num_failed << " failed" << endl;
+
+	return 0;
+}